@@ -23,7 +23,7 @@ public:
 
     void run() override {
         TrackTags tags(m_id);
-        m_tagReader.readMetadata(m_id, tags);
+        m_tagReader.extractCoverArt(m_id, tags);
 
         const auto coverImage = tags.coverImage();
         if (coverImage.isEmpty()) {
@@ -7,10 +7,12 @@
 #include "models/trackcollectionmodel.hpp"
 
 #include "activetrackmanager.h"
+#include "database/databaseexecutor.h"
 #include "database/databasemanager.h"
 #include "library/library.hpp"
 #include "mediaplayerwrapper.h"
 #include "playermanager.h"
+#include "taglib/audioclassifier.h"
 
 #include <QDebug>
 #include <QDialog>
@@ -27,6 +29,8 @@
 class CorPlayerPrivate {
 public:
     QThread m_databaseThread;
+    // Stopped in ~CorPlayer, before anything its jobs use is destroyed
+    DatabaseExecutor m_dbExecutor{&m_databaseThread};
     DatabaseManager* m_dbManager = nullptr;
     std::unique_ptr<Library> m_library;
 
@@ -58,8 +62,9 @@ bool CorPlayer::openFiles(const QList<QUrl>& files, const QString& workingDirect
     QList<Metadata::TrackFields> entries;
 
     for (const QUrl& file : files) {
-        const QMimeType mime = mimeDB.mimeTypeForUrl(file);
-        if (mime.name().startsWith(QStringLiteral("audio/"))) {
+        // Files the classifier does not know are still opened when the system says they are audio
+        if (AudioClassifier::isAudio(AudioClassifier::classify(file)) ||
+            mimeDB.mimeTypeForUrl(file).name().startsWith(QStringLiteral("audio/"))) {
             auto entry = Metadata::TrackFields();
             entry.insert(Metadata::Fields::ElementType, PlayerUtils::FileName);
             entry.insert(Metadata::Fields::ResourceUrl, file);
@@ -83,12 +88,13 @@ void CorPlayer::initialize() {
     Q_EMIT initializationDone();
 }
 
-void CorPlayer::playTrack(const quint64 trackId) const {
-    const auto track = capp->m_library->trackDatabase().fetchTrackFromId(trackId);
-    if (!track.isValid()) return;
+void CorPlayer::playTrack(const quint64 trackId) {
+    capp->m_library->loadTrack(trackId).then(this, [this](const Metadata::TrackFields& track) {
+        if (!track.isValid()) return;
 
-    capp->m_playlistProxyModel->enqueue({track}, PlayerUtils::PlaylistEnqueueMode::ReplacePlaylist,
-                                        PlayerUtils::TriggerPlay);
+        capp->m_playlistProxyModel->enqueue({track}, PlayerUtils::PlaylistEnqueueMode::ReplacePlaylist,
+                                            PlayerUtils::TriggerPlay);
+    });
 }
 
 void CorPlayer::initializeModels() {
@@ -105,6 +111,7 @@ void CorPlayer::initializeModels() {
 
     capp->m_library = std::make_unique<Library>();
     capp->m_library->initialize(capp->m_dbManager->dbConnectionPool());
+    capp->m_library->setExecutor(&capp->m_dbExecutor);
 
     capp->m_trackCollectionModel = std::make_unique<TrackCollectionModel>(capp->m_library.get());
     Q_EMIT trackCollectionModelChanged();
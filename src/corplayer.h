@@ -63,7 +63,7 @@ public Q_SLOTS:
     bool openFiles(const QList<QUrl>& files);
     bool openFiles(const QList<QUrl>& files, const QString& workingDirectory);
     void initialize();
-    void playTrack(quint64 trackId) const;
+    void playTrack(quint64 trackId);
 
 private:
     void initializeModels();
@@ -3,6 +3,8 @@
 #include "database/sqlquery.h"
 
 void BaseDatabase::maintenance() const {
+    const auto writer = writeLease();
+
     {
         SqlQuery vacuumQuery{db(), QStringLiteral("VACUUM;")};
         if (!vacuumQuery.exec()) {
@@ -16,6 +18,13 @@ void BaseDatabase::maintenance() const {
     }
 }
 
+void BaseDatabase::checkpoint() const {
+    SqlQuery checkpointQuery{db(), QStringLiteral("PRAGMA wal_checkpoint(PASSIVE);")};
+    if (!checkpointQuery.exec()) {
+        qDebug() << "Failed to checkpoint database";
+    }
+}
+
 void BaseDatabase::initialize(const DbConnection& dbConnection) {
     m_dbConnection = dbConnection;
 }
@@ -23,3 +32,15 @@ void BaseDatabase::initialize(const DbConnection& dbConnection) {
 QSqlDatabase BaseDatabase::db() const {
     return m_dbConnection.db();
 }
+
+StatementCache::Lease BaseDatabase::cachedQuery(const QString& statement) const {
+    return m_dbConnection.statement(statement);
+}
+
+DbConnectionPool::ReadLease BaseDatabase::readLease() const {
+    return m_dbConnection.read();
+}
+
+DbConnectionPool::WriteLease BaseDatabase::writeLease() const {
+    return m_dbConnection.write();
+}
@@ -8,10 +8,18 @@ public:
 	BaseDatabase() = default;
     virtual ~BaseDatabase() = default;
     void maintenance() const;
+    // Copies the WAL back into the database without waiting for readers, after large writes
+    void checkpoint() const;
     virtual void initialize(const DbConnection& dbConnection);
 
 protected:
     [[nodiscard]] QSqlDatabase db() const;
+    // For statements that run often, prepared once per connection and reset when the lease ends
+    [[nodiscard]] StatementCache::Lease cachedQuery(const QString& statement) const;
+    // Held around reads that should count against the pool's read slots, see DbConnectionPool
+    [[nodiscard]] DbConnectionPool::ReadLease readLease() const;
+    // Taken by every SqlTransaction, so writes from different threads run one after another
+    [[nodiscard]] DbConnectionPool::WriteLease writeLease() const;
 
 private:
     DbConnection m_dbConnection;
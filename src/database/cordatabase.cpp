@@ -3,23 +3,25 @@
 #include <QSqlQuery>
 
 CorDatabase::CorDatabase(const QString& databaseFileName, const QString& connectionName) : m_conName{connectionName} {
-    auto database = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+    m_db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
 
     if (!databaseFileName.isEmpty()) {
-        database.setDatabaseName(QStringLiteral("file:") + databaseFileName);
+        m_db.setDatabaseName(QStringLiteral("file:") + databaseFileName);
     } else {
-        database.setDatabaseName(QStringLiteral("file:memdb1?mode=memory"));
+        m_db.setDatabaseName(QStringLiteral("file:memdb1?mode=memory"));
     }
-    // TODO look into other options for the last 2 calls
-    database.setConnectOptions(QStringLiteral("QSQLITE_OPEN_URI;"));
+    // Journal, sync and cache settings are applied per connection from the pool's DbProfile
+    m_db.setConnectOptions(QStringLiteral("QSQLITE_OPEN_URI;"));
 }
 
 CorDatabase::CorDatabase(const CorDatabase& other, const QString& connectionName) : m_conName{connectionName} {
-    QSqlDatabase::cloneDatabase(other.name(), connectionName);
+    m_db = QSqlDatabase::cloneDatabase(other.db(), connectionName);
 }
 
 CorDatabase::~CorDatabase() {
     close();
+    // The registry only lets go of a connection nobody holds a handle to
+    m_db = QSqlDatabase{};
     QSqlDatabase::removeDatabase(m_conName);
 }
 
@@ -28,27 +30,36 @@ QString CorDatabase::name() const {
 }
 
 bool CorDatabase::open() const {
-    auto db = this->db();
-
-    if (!db.isOpen()) {
+    if (!m_db.isOpen()) {
+        // Opening changes the shared connection, not the handle
+        auto db = m_db;
         return db.open();
     }
 
     return true;
 }
 
-void CorDatabase::close() const {
-    auto db = this->db();
+void CorDatabase::close() {
+    // Prepared statements hold on to the connection
+    m_statements.clear();
 
-    if (db.isOpen()) {
-        db.close();
+    if (m_db.isOpen()) {
+        m_db.close();
     }
 }
 
 bool CorDatabase::isOpen() const {
-    return db().isOpen();
+    return m_db.isOpen();
+}
+
+const QSqlDatabase& CorDatabase::db() const {
+    return m_db;
+}
+
+StatementCache::Lease CorDatabase::statement(const QString& statement) {
+    return m_statements.acquire(m_db, statement);
 }
 
-QSqlDatabase CorDatabase::db() const {
-    return QSqlDatabase::database(m_conName);
+bool CorDatabase::hasLeasedStatements() const {
+    return m_statements.hasLeases();
 }
@@ -1,6 +1,8 @@
 #ifndef CORDATABASE_H
 #define CORDATABASE_H
 
+#include "database/statementcache.h"
+
 #include <QSqlDatabase>
 
 class CorDatabase {
@@ -14,12 +16,18 @@ public:
 
     [[nodiscard]] QString name() const;
     [[nodiscard]] bool open() const;
-    void close() const;
+    void close();
     [[nodiscard]] bool isOpen() const;
-    [[nodiscard]] QSqlDatabase db() const;
+    // Resolved once, copies of it skip the lookup in Qt's global connection registry
+    [[nodiscard]] const QSqlDatabase& db() const;
+    // Prepared once per connection, see StatementCache
+    [[nodiscard]] StatementCache::Lease statement(const QString& statement);
+    [[nodiscard]] bool hasLeasedStatements() const;
 
 private:
     QString m_conName;
+    QSqlDatabase m_db;
+    StatementCache m_statements;
 };
 
 #endif // CORDATABASE_H
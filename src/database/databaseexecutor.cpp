@@ -0,0 +1,23 @@
+#include "database/databaseexecutor.h"
+
+DatabaseExecutor::DatabaseExecutor(QThread* thread) : m_thread(thread) {
+    if (m_thread == nullptr) return;
+
+    m_context.reset(new QObject);
+    m_context->moveToThread(m_thread);
+}
+
+DatabaseExecutor::~DatabaseExecutor() = default;
+
+bool DatabaseExecutor::runsInline() const {
+    return m_context == nullptr || !m_thread->isRunning() || QThread::currentThread() == m_thread;
+}
+
+void DatabaseExecutor::ContextDeleter::operator()(QObject* context) const {
+    // Once the thread has stopped, jobs still queued are dropped with the context and their futures canceled
+    if (context->thread()->isRunning() && context->thread() != QThread::currentThread()) {
+        context->deleteLater();
+    } else {
+        delete context;
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef DATABASEEXECUTOR_H
+#define DATABASEEXECUTOR_H
+
+#include <QFuture>
+#include <QObject>
+#include <QPromise>
+#include <QThread>
+
+#include <memory>
+#include <type_traits>
+
+// Runs database work on one thread, which keeps its own pooled connection for as long as it runs.
+// Results come back as futures, continuations attached with a context object run on that object's thread.
+// Without a running thread, or when called from the database thread itself, the work runs right away.
+class DatabaseExecutor {
+public:
+    explicit DatabaseExecutor(QThread* thread = nullptr);
+    ~DatabaseExecutor();
+
+    DatabaseExecutor(const DatabaseExecutor&) = delete;
+    DatabaseExecutor& operator=(const DatabaseExecutor&) = delete;
+
+    [[nodiscard]] bool runsInline() const;
+
+    template <typename Job>
+    QFuture<std::invoke_result_t<std::decay_t<Job>>> run(Job&& job) const {
+        using Result = std::invoke_result_t<std::decay_t<Job>>;
+
+        if (runsInline()) {
+            if constexpr (std::is_void_v<Result>) {
+                job();
+                return QtFuture::makeReadyVoidFuture();
+            } else {
+                return QtFuture::makeReadyValueFuture(job());
+            }
+        }
+
+        // Shared, the queued call has to be copyable
+        auto promise = std::make_shared<QPromise<Result>>();
+        QFuture<Result> future = promise->future();
+        promise->start();
+
+        // Left unfinished if the thread stops first, the promise then cancels the future when it is destroyed
+        QMetaObject::invokeMethod(
+            m_context.get(),
+            [promise, job = std::decay_t<Job>(std::forward<Job>(job))]() mutable {
+                if constexpr (std::is_void_v<Result>) {
+                    job();
+                } else {
+                    promise->addResult(job());
+                }
+                promise->finish();
+            },
+            Qt::QueuedConnection);
+
+        return future;
+    }
+
+private:
+    struct ContextDeleter {
+        void operator()(QObject* context) const;
+    };
+
+    QThread* m_thread;
+    // Lives on the database thread, queued jobs are delivered to it
+    std::unique_ptr<QObject, ContextDeleter> m_context;
+};
+
+#endif // DATABASEEXECUTOR_H
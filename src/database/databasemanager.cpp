@@ -10,8 +10,8 @@ DatabaseManager& DatabaseManager::instance() {
     return instance;
 }
 
-void DatabaseManager::initialize(const QString& databasePath) {
-    m_connectionPool = DbConnectionPool::create(databasePath);
+void DatabaseManager::initialize(const QString& databasePath, const DbProfile& profile) {
+    m_connectionPool = DbConnectionPool::create(databasePath, profile);
 
     const DbSchema schema(DbConnection{m_connectionPool});
 
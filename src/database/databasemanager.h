@@ -8,7 +8,7 @@
 class DatabaseManager {
 public:
     static DatabaseManager& instance();
-    void initialize(const QString& databasePath);
+    void initialize(const QString& databasePath, const DbProfile& profile = {});
 
     DatabaseManager(const DatabaseManager&) = delete;
     DatabaseManager& operator=(const DatabaseManager&) = delete;
@@ -11,37 +11,53 @@ DbConnection::DbConnection() : m_connectionPool{nullptr} {}
 DbConnection::DbConnection(std::shared_ptr<DbConnectionPool> dbConnectionPool)
     : m_connectionPool(std::move(dbConnectionPool)) {}
 
-DbConnection::~DbConnection() {
-    if (isValid() && m_connectionPool->hasConnection()) {
-        m_connectionPool->release();
-    }
-}
-
 bool DbConnection::isValid() const {
     return m_connectionPool != nullptr;
 }
 
 QSqlDatabase DbConnection::db() const {
+    const CorDatabase* const dbConnection = connection();
+    return dbConnection != nullptr ? dbConnection->db() : QSqlDatabase{};
+}
+
+StatementCache::Lease DbConnection::statement(const QString& statement) const {
+    CorDatabase* const dbConnection = connection();
+
+    // Without a connection the statement fails on exec, as an uncached query on an invalid database does
+    if (dbConnection == nullptr) {
+        return {nullptr, statement, std::make_unique<SqlQuery>(QSqlDatabase{}, statement)};
+    }
+
+    return dbConnection->statement(statement);
+}
+
+DbConnectionPool::ReadLease DbConnection::read() const {
     if (!isValid()) {
         qWarning() << "No pool assigned";
-        return {};
     }
 
-    if (!m_connectionPool->hasConnection()) {
-        m_connectionPool->createConnection();
+    return DbConnectionPool::ReadLease{m_connectionPool.get()};
+}
+
+DbConnectionPool::WriteLease DbConnection::write() const {
+    if (!isValid()) {
+        qWarning() << "No pool assigned";
     }
 
-    const CorDatabase* const dbConnection = m_connectionPool->acquire();
+    return DbConnectionPool::WriteLease{m_connectionPool.get()};
+}
 
-    if (dbConnection == nullptr) {
-        qWarning() << "Could not acquire connection";
-        return {};
+CorDatabase* DbConnection::connection() const {
+    if (!isValid()) {
+        qWarning() << "No pool assigned";
+        return nullptr;
     }
 
-    if (!dbConnection->isOpen() && !dbConnection->db().open()) {
-        qWarning() << "Failed to open database connection";
-        return {};
+    CorDatabase* const dbConnection = m_connectionPool->connection();
+
+    if (dbConnection == nullptr) {
+        qWarning() << "Could not acquire connection";
     }
 
-    return dbConnection->db();
+    return dbConnection;
 }
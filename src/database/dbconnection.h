@@ -2,17 +2,26 @@
 #define DBCONNECTION_H
 
 #include "database/dbconnectionpool.h"
+#include "database/statementcache.h"
 
+// A handle to a pool, cheap to copy. The connection behind it belongs to the calling thread and the pool.
 class DbConnection {
 public:
     DbConnection();
     explicit DbConnection(std::shared_ptr<DbConnectionPool> dbConnectionPool);
-    ~DbConnection();
 
     [[nodiscard]] bool isValid() const;
     [[nodiscard]] QSqlDatabase db() const;
+    // A prepared statement from the cache of this thread's connection
+    [[nodiscard]] StatementCache::Lease statement(const QString& statement) const;
+
+    // See DbConnectionPool, invalid without a pool
+    [[nodiscard]] DbConnectionPool::ReadLease read() const;
+    [[nodiscard]] DbConnectionPool::WriteLease write() const;
 
 private:
+    [[nodiscard]] CorDatabase* connection() const;
+
     std::shared_ptr<DbConnectionPool> m_connectionPool;
 };
 
@@ -4,61 +4,249 @@
 #include "database/sqlquery.h"
 
 #include <QDebug>
-#include <QRandomGenerator>
 #include <QSqlDatabase>
 #include <QThread>
 
-DbConnectionPool::DbConnectionPool(QString databaseName) : m_databaseName{std::move(databaseName)} {}
+#include <algorithm>
+#include <utility>
 
-std::shared_ptr<DbConnectionPool> DbConnectionPool::create(const QString& databaseName) {
-    return std::make_shared<DbConnectionPool>(databaseName);
+namespace {
+
+std::atomic<int> nextPoolId{0};
+
+} // namespace
+
+DbConnectionPool::Lease::Lease(DbConnectionPool* pool, CorDatabase* connection)
+    : m_pool{pool}, m_connection{connection} {}
+
+DbConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : m_pool{std::exchange(other.m_pool, nullptr)}, m_connection{std::exchange(other.m_connection, nullptr)} {}
+
+bool DbConnectionPool::Lease::isValid() const {
+    return m_connection != nullptr;
+}
+
+QSqlDatabase DbConnectionPool::Lease::db() const {
+    return m_connection != nullptr ? m_connection->db() : QSqlDatabase{};
+}
+
+StatementCache::Lease DbConnectionPool::Lease::statement(const QString& statement) const {
+    // Without a connection the statement fails on exec, as an uncached query on an invalid database does
+    if (m_connection == nullptr) {
+        return {nullptr, statement, std::make_unique<SqlQuery>(QSqlDatabase{}, statement)};
+    }
+
+    return m_connection->statement(statement);
+}
+
+DbConnectionPool::ReadLease::ReadLease(DbConnectionPool* pool) : Lease{pool, nullptr} {
+    if (m_pool != nullptr) {
+        m_connection = m_pool->connection();
+        m_pool->acquireRead();
+    }
+}
+
+DbConnectionPool::ReadLease::~ReadLease() {
+    if (m_pool != nullptr) {
+        m_pool->releaseRead();
+    }
+}
+
+DbConnectionPool::WriteLease::WriteLease(DbConnectionPool* pool) : Lease{pool, nullptr} {
+    if (m_pool != nullptr) {
+        m_connection = m_pool->connection();
+        m_pool->acquireWrite();
+    }
+}
+
+DbConnectionPool::WriteLease::~WriteLease() {
+    if (m_pool != nullptr) {
+        m_pool->releaseWrite();
+    }
+}
+
+DbConnectionPool::ThreadConnection::~ThreadConnection() {
+    if (readDepth > 0 || writeDepth > 0) {
+        qWarning() << "Closing a connection that is still leased: " << database->name();
+    }
+}
+
+DbConnectionPool::DbConnectionPool(QString databaseName, DbProfile profile, const int maxReaders)
+    : m_databaseName{std::move(databaseName)}, m_profile{std::move(profile)}, m_maxReaders{std::max(maxReaders, 1)},
+      m_poolId{nextPoolId.fetch_add(1, std::memory_order_relaxed)}, m_readers{m_maxReaders} {}
+
+std::shared_ptr<DbConnectionPool> DbConnectionPool::create(const QString& databaseName, const DbProfile& profile,
+                                                           const int maxReaders) {
+    return std::make_shared<DbConnectionPool>(databaseName, profile, maxReaders);
+}
+
+int DbConnectionPool::defaultMaxReaders() {
+    // The UI, the cover provider and a scan running next to each other
+    return std::max(QThread::idealThreadCount(), 4);
 }
 
 bool DbConnectionPool::hasConnection() const {
     return m_threadConnections.hasLocalData();
 }
 
-bool DbConnectionPool::createConnection() {
-    if (hasConnection()) {
-        qWarning() << "Connection already exists: " << m_threadConnections.localData()->name();
-        return false;
+const DbProfile& DbConnectionPool::profile() const {
+    return m_profile;
+}
+
+int DbConnectionPool::maxReaders() const {
+    return m_maxReaders;
+}
+
+int DbConnectionPool::availableReaders() const {
+    return m_readers.available();
+}
+
+DbConnectionPool::ReadLease DbConnectionPool::read() {
+    return ReadLease{this};
+}
+
+DbConnectionPool::WriteLease DbConnectionPool::write() {
+    return WriteLease{this};
+}
+
+CorDatabase* DbConnectionPool::connection() {
+    ThreadConnection* const connection = threadConnection();
+    return connection != nullptr ? connection->database.get() : nullptr;
+}
+
+DbConnectionPool::ThreadConnection* DbConnectionPool::threadConnection() {
+    if (!hasConnection()) {
+        auto database = createConnection();
+
+        if (database == nullptr) {
+            return nullptr;
+        }
+
+        auto* connection = new ThreadConnection;
+        connection->database = std::move(database);
+        connection->lastChecked.start();
+
+        // Deleted by the storage when the thread exits, which closes the connection on its own thread
+        m_threadConnections.setLocalData(connection);
+        return connection;
+    }
+
+    ThreadConnection* const connection = m_threadConnections.localData();
+
+    // Only reopened between operations, while nothing on this thread holds a lease or a statement of the old one.
+    // Cached statements can be taken without a lease, so they are counted on their own.
+    if (connection->readDepth == 0 && connection->writeDepth == 0 && !connection->database->hasLeasedStatements() &&
+        !isHealthy(*connection)) {
+        qWarning() << "Reopening database connection: " << connection->database->name();
+        connection->database->close();
+
+        if (!open(*connection->database)) {
+            return nullptr;
+        }
+
+        connection->lastChecked.start();
     }
 
-    const QString connectionName =
-        QStringLiteral("Connection-%1").arg(QString::number(QRandomGenerator::global()->generate()));
+    return connection;
+}
+
+std::unique_ptr<CorDatabase> DbConnectionPool::createConnection() {
+    // Named after the pool and the order they were opened in, so logs can tell them apart
+    const QString connectionName = QStringLiteral("CorPlayer-%1-%2")
+                                       .arg(m_poolId)
+                                       .arg(m_nextConnectionId.fetch_add(1, std::memory_order_relaxed));
 
-    auto db = std::make_unique<CorDatabase>(m_databaseName, connectionName);
+    auto database = std::make_unique<CorDatabase>(m_databaseName, connectionName);
 
-    if (!db->open()) {
-        qWarning() << "Failed to open database connection";
+    if (!open(*database)) {
+        return nullptr;
+    }
+
+    return database;
+}
+
+bool DbConnectionPool::open(const CorDatabase& database) const {
+    if (!database.open()) {
+        qWarning() << "Failed to open database connection: " << database.name();
         return false;
     }
 
-    const QString statement = QStringLiteral("PRAGMA foreign_keys = ON;");
-    SqlQuery query{db->db(), statement};
+    SqlQuery query{database.db(), QStringLiteral("PRAGMA foreign_keys = ON;")};
 
     if (!query.exec()) {
         qWarning() << "Failed to enable foreign keys for database";
         return false;
     }
 
-    m_threadConnections.setLocalData(db.release());
+    // Most of the settings only last as long as the connection, so every thread's connection gets them
+    if (!m_profile.apply(database.db())) {
+        qWarning() << "Failed to apply database profile";
+        return false;
+    }
 
     return true;
 }
 
-CorDatabase* DbConnectionPool::acquire() const {
-    if (!hasConnection()) {
-        qWarning() << "DbConnectionPool::acquire: No connection available";
+bool DbConnectionPool::isHealthy(ThreadConnection& connection) {
+    if (!connection.database->isOpen()) {
+        return false;
+    }
+
+    if (connection.lastChecked.isValid() && !connection.lastChecked.hasExpired(healthCheckIntervalMs)) {
+        return true;
     }
 
-    return m_threadConnections.localData();
+    SqlQuery query{connection.database->db(), QStringLiteral("SELECT 1;")};
+
+    if (!query.exec() || !query.next()) {
+        return false;
+    }
+
+    connection.lastChecked.start();
+    return true;
 }
 
-void DbConnectionPool::release() {
-    if (!hasConnection()) {
-        qWarning() << "DbConnectionPool::release: No connection available";
+void DbConnectionPool::acquireRead() {
+    ThreadConnection* const connection = hasConnection() ? m_threadConnections.localData() : nullptr;
+
+    if (connection == nullptr) {
+        m_readers.acquire();
+        return;
+    }
+
+    // A thread that already reads or writes has its slot, waiting for another one could wait on itself
+    if (connection->readDepth++ == 0 && connection->writeDepth == 0) {
+        m_readers.acquire();
+        connection->holdsReadSlot = true;
+    }
+}
+
+void DbConnectionPool::releaseRead() {
+    ThreadConnection* const connection = hasConnection() ? m_threadConnections.localData() : nullptr;
+
+    if (connection == nullptr) {
+        m_readers.release();
+        return;
+    }
+
+    if (--connection->readDepth == 0 && connection->holdsReadSlot) {
+        connection->holdsReadSlot = false;
+        m_readers.release();
+    }
+}
+
+void DbConnectionPool::acquireWrite() {
+    m_writer.lock();
+
+    if (hasConnection()) {
+        ++m_threadConnections.localData()->writeDepth;
+    }
+}
+
+void DbConnectionPool::releaseWrite() {
+    if (hasConnection()) {
+        --m_threadConnections.localData()->writeDepth;
     }
 
-    m_threadConnections.setLocalData(nullptr);
+    m_writer.unlock();
 }
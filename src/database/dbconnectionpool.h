@@ -1,32 +1,116 @@
 #ifndef DBCONNECTIONPOOL_H
 #define DBCONNECTIONPOOL_H
 
+#include "database/dbprofile.h"
+#include "database/statementcache.h"
+
+#include <QElapsedTimer>
+#include <QRecursiveMutex>
+#include <QSemaphore>
 #include <QString>
 #include <QThreadStorage>
 
+#include <atomic>
 #include <memory>
 
 class QSqlDatabase;
 class CorDatabase;
 
+// Connections to one database file. Qt only allows a connection to be used from the thread that opened it,
+// so every thread gets its own, opened when it first needs one and closed when the thread exits.
+// What is pooled is the right to use them: a bounded number of reads run at the same time, and writes are
+// serialised so only one thread at a time waits on SQLite's single writer lock.
 class DbConnectionPool {
     Q_DISABLE_COPY_MOVE(DbConnectionPool)
 
 public:
-    explicit DbConnectionPool(QString databaseName);
-    static std::shared_ptr<DbConnectionPool> create(const QString& databaseName);
+    // Shared by the lease types below, the connection a lease hands out
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) = delete;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        [[nodiscard]] bool isValid() const;
+        [[nodiscard]] QSqlDatabase db() const;
+        [[nodiscard]] StatementCache::Lease statement(const QString& statement) const;
+
+    protected:
+        Lease(DbConnectionPool* pool, CorDatabase* connection);
+        ~Lease() = default;
+
+        DbConnectionPool* m_pool;
+        CorDatabase* m_connection;
+    };
+
+    // One of the pool's read slots for as long as it lives. Nested leases on one thread share the slot.
+    class ReadLease : public Lease {
+    public:
+        explicit ReadLease(DbConnectionPool* pool);
+        ReadLease(ReadLease&& other) noexcept = default;
+        ~ReadLease();
+    };
+
+    // The pool's writer lock for as long as it lives. A thread may take it again while holding it.
+    class WriteLease : public Lease {
+    public:
+        explicit WriteLease(DbConnectionPool* pool);
+        WriteLease(WriteLease&& other) noexcept = default;
+        ~WriteLease();
+    };
+
+    DbConnectionPool(QString databaseName, DbProfile profile, int maxReaders = defaultMaxReaders());
+    static std::shared_ptr<DbConnectionPool> create(const QString& databaseName, const DbProfile& profile = {},
+                                                    int maxReaders = defaultMaxReaders());
+
+    [[nodiscard]] static int defaultMaxReaders();
+
     [[nodiscard]] bool hasConnection() const;
+    [[nodiscard]] const DbProfile& profile() const;
+    [[nodiscard]] int maxReaders() const;
+    [[nodiscard]] int availableReaders() const;
+
+    [[nodiscard]] ReadLease read();
+    [[nodiscard]] WriteLease write();
+
+    // This thread's connection, opened on first use and reopened when it stops answering.
+    // Without a lease, for work that neither needs a read slot nor writes, like the schema setup.
+    [[nodiscard]] CorDatabase* connection();
 
 private:
-    friend class DbConnection;
+    struct ThreadConnection {
+        std::unique_ptr<CorDatabase> database;
+        QElapsedTimer lastChecked;
+        int readDepth = 0;
+        int writeDepth = 0;
+        bool holdsReadSlot = false;
+
+        ~ThreadConnection();
+    };
+
+    // Connections that were used within this interval are trusted without asking SQLite
+    static constexpr qint64 healthCheckIntervalMs = 30 * 1000;
 
     QString m_databaseName;
-    QThreadStorage<CorDatabase*> m_threadConnections;
+    DbProfile m_profile;
+    int m_maxReaders;
+    int m_poolId;
+    std::atomic<int> m_nextConnectionId{0};
+
+    QThreadStorage<ThreadConnection*> m_threadConnections;
+    QSemaphore m_readers;
+    QRecursiveMutex m_writer;
 
-    bool createConnection();
+    [[nodiscard]] ThreadConnection* threadConnection();
+    [[nodiscard]] std::unique_ptr<CorDatabase> createConnection();
+    [[nodiscard]] bool open(const CorDatabase& database) const;
+    [[nodiscard]] static bool isHealthy(ThreadConnection& connection);
 
-    [[nodiscard]] CorDatabase* acquire() const;
-    void release();
+    void acquireRead();
+    void releaseRead();
+    void acquireWrite();
+    void releaseWrite();
 };
 
 #endif // DBCONNECTIONPOOL_H
@@ -0,0 +1,70 @@
+#include "database/dbprofile.h"
+
+#include "database/sqlquery.h"
+
+#include <QDebug>
+#include <QSqlError>
+
+DbProfile DbProfile::preset(const Preset preset) {
+    DbProfile profile;
+
+    switch (preset) {
+    case Preset::BulkImport:
+        profile.mmapSize = qint64{1024} * 1024 * 1024;
+        profile.cacheSizeKiB = 256 * 1024;
+        // Checkpointing less often keeps the writer from stalling on the readers of a long import
+        profile.walAutocheckpointPages = 10'000;
+        profile.journalSizeLimit = qint64{256} * 1024 * 1024;
+        break;
+    case Preset::Safe:
+        profile.journalMode = QStringLiteral("DELETE");
+        profile.synchronous = QStringLiteral("FULL");
+        profile.mmapSize = 0;
+        profile.cacheSizeKiB = 2 * 1024;
+        profile.tempStoreInMemory = false;
+        break;
+    case Preset::Balanced:
+    default:
+        break;
+    }
+
+    return profile;
+}
+
+QStringList DbProfile::pragmas() const {
+    // Negative cache sizes are in KiB, positive ones in pages
+    return {
+        QStringLiteral("PRAGMA journal_mode = %1;").arg(journalMode),
+        QStringLiteral("PRAGMA synchronous = %1;").arg(synchronous),
+        QStringLiteral("PRAGMA mmap_size = %1;").arg(mmapSize),
+        QStringLiteral("PRAGMA cache_size = -%1;").arg(cacheSizeKiB),
+        QStringLiteral("PRAGMA temp_store = %1;")
+            .arg(tempStoreInMemory ? QStringLiteral("MEMORY") : QStringLiteral("DEFAULT")),
+        QStringLiteral("PRAGMA busy_timeout = %1;").arg(busyTimeoutMs),
+        QStringLiteral("PRAGMA wal_autocheckpoint = %1;").arg(walAutocheckpointPages),
+        QStringLiteral("PRAGMA journal_size_limit = %1;").arg(journalSizeLimit),
+    };
+}
+
+bool DbProfile::apply(const QSqlDatabase& db) const {
+    const QStringList statements = pragmas();
+
+    for (const QString& statement : statements) {
+        SqlQuery query{db, statement};
+
+        if (!query.exec()) {
+            qWarning() << "Failed to apply database setting: " << statement << query.lastError().text();
+            return false;
+        }
+    }
+
+    // In-memory databases stay in memory journal mode, anything else is worth knowing about
+    SqlQuery modeQuery{db, QStringLiteral("PRAGMA journal_mode;")};
+    if (modeQuery.exec() && modeQuery.next() &&
+        modeQuery.value(0).toString().compare(journalMode, Qt::CaseInsensitive) != 0) {
+        qDebug() << "Database runs in journal mode " << modeQuery.value(0).toString() << " instead of "
+                 << journalMode;
+    }
+
+    return true;
+}
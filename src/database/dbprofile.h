@@ -0,0 +1,34 @@
+#ifndef DBPROFILE_H
+#define DBPROFILE_H
+
+#include <QStringList>
+
+class QSqlDatabase;
+
+// SQLite settings applied to every pooled connection when it is opened.
+// The defaults are the Balanced preset: WAL lets readers run next to an import and NORMAL only syncs on checkpoints.
+struct DbProfile {
+    enum class Preset : std::uint8_t {
+        Balanced,   // desktop use, concurrent reads while scanning
+        BulkImport, // first import of a large library, checkpoints rarely and caches more
+        Safe,       // rollback journal with a sync on every commit, for file systems without shared memory
+    };
+
+    QString journalMode = QStringLiteral("WAL");
+    QString synchronous = QStringLiteral("NORMAL");
+    qint64 mmapSize = qint64{256} * 1024 * 1024;
+    qint64 cacheSizeKiB = 64 * 1024;
+    bool tempStoreInMemory = true;
+    int busyTimeoutMs = 5000;
+    // Checkpoint policy: pages the WAL may grow to before a commit checkpoints it, and the size it is cut back to
+    int walAutocheckpointPages = 1000;
+    qint64 journalSizeLimit = qint64{64} * 1024 * 1024;
+
+    [[nodiscard]] static DbProfile preset(Preset preset);
+
+    [[nodiscard]] QStringList pragmas() const;
+    // Runs the pragmas on an open connection, fails on the first one SQLite rejects
+    [[nodiscard]] bool apply(const QSqlDatabase& db) const;
+};
+
+#endif // DBPROFILE_H
@@ -1,9 +1,291 @@
 #include "database/dbschema.h"
 
+#include "database/playlistdatabase.h"
 #include "database/sqlquery.h"
+#include "metadata.hpp"
 
 #include <QSqlQuery>
 #include <QSqlError>
+#include <QTime>
+#include <QUrl>
+
+#include <array>
+
+namespace {
+
+bool execAll(const QSqlDatabase& db, const QStringList& statements) {
+    for (const QString& statement : statements) {
+        SqlQuery query{db, statement};
+        if (!query.exec()) {
+            qWarning() << "Failed to upgrade database: " << query.lastError().text() << "\nLast query: "
+                       << query.lastQuery();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int userVersion(const QSqlDatabase& db) {
+    SqlQuery query{db, QStringLiteral("PRAGMA user_version;")};
+    return query.exec() && query.next() ? query.value(0).toInt() : -1;
+}
+
+bool hasTable(const QSqlDatabase& db, const QString& name) {
+    SqlQuery query{db, QStringLiteral("SELECT 1 FROM `sqlite_master` WHERE `type` = 'table' AND `name` = :name;")};
+    query.bindStringValue(QStringLiteral(":name"), name);
+    return query.exec() && query.next();
+}
+
+bool hasColumn(const QSqlDatabase& db, const QString& table, const QString& column) {
+    SqlQuery query{db, QStringLiteral("SELECT 1 FROM pragma_table_info(:table) WHERE `name` = :column;")};
+    query.bindStringValue(QStringLiteral(":table"), table);
+    query.bindStringValue(QStringLiteral(":column"), column);
+    return query.exec() && query.next();
+}
+
+QString columnType(const QSqlDatabase& db, const QString& table, const QString& column) {
+    SqlQuery query{db, QStringLiteral("SELECT `type` FROM pragma_table_info(:table) WHERE `name` = :column;")};
+    query.bindStringValue(QStringLiteral(":table"), table);
+    query.bindStringValue(QStringLiteral(":column"), column);
+    return query.exec() && query.next() ? query.value(0).toString() : QString{};
+}
+
+// Version 1: file fingerprints. Tracks without one are read again by the next rescan.
+bool addFileFingerprints(const QSqlDatabase& db) {
+    const QStringList columns = {QStringLiteral("FileSize"), QStringLiteral("FileModified"),
+                                 QStringLiteral("FileInode")};
+
+    for (const QString& column : columns) {
+        if (hasColumn(db, QStringLiteral("Tracks"), column)) continue;
+
+        if (!execAll(db, {QStringLiteral("ALTER TABLE `Tracks` ADD COLUMN `%1` INTEGER;").arg(column)})) return false;
+    }
+
+    return true;
+}
+
+// Version 2: artist, album and genre names move from Tracks into their own tables, rows refer to them by id
+bool normalizeNames(const QSqlDatabase& db) {
+    if (!hasColumn(db, QStringLiteral("Tracks"), QStringLiteral("ArtistName"))) return true;
+
+    return execAll(
+        db,
+        {QStringLiteral("INSERT OR IGNORE INTO `Artists` (`Name`) "
+                        "SELECT `ArtistName` FROM `Tracks` WHERE `ArtistName` <> '' "
+                        "UNION SELECT `AlbumArtistName` FROM `Tracks` WHERE `AlbumArtistName` <> '';"),
+         QStringLiteral("INSERT OR IGNORE INTO `Genres` (`Name`) "
+                        "SELECT DISTINCT `Genre` FROM `Tracks` WHERE `Genre` <> '';"),
+
+         QStringLiteral("ALTER TABLE `Tracks` ADD COLUMN `ArtistID` INTEGER "
+                        "REFERENCES `Artists`(`ArtistID`) ON DELETE SET NULL;"),
+         QStringLiteral("ALTER TABLE `Tracks` ADD COLUMN `AlbumID` INTEGER "
+                        "REFERENCES `Albums`(`AlbumID`) ON DELETE SET NULL;"),
+         QStringLiteral("ALTER TABLE `Tracks` ADD COLUMN `AlbumArtistID` INTEGER "
+                        "REFERENCES `Artists`(`ArtistID`) ON DELETE SET NULL;"),
+         QStringLiteral("ALTER TABLE `Tracks` ADD COLUMN `GenreID` INTEGER "
+                        "REFERENCES `Genres`(`GenreID`) ON DELETE SET NULL;"),
+
+         QStringLiteral("UPDATE `Tracks` SET "
+                        "   `ArtistID` = (SELECT `Artists`.`ArtistID` FROM `Artists` "
+                        "       WHERE `Artists`.`Name` = `Tracks`.`ArtistName`),"
+                        "   `AlbumArtistID` = (SELECT `Artists`.`ArtistID` FROM `Artists` "
+                        "       WHERE `Artists`.`Name` = `Tracks`.`AlbumArtistName`),"
+                        "   `GenreID` = (SELECT `Genres`.`GenreID` FROM `Genres` "
+                        "       WHERE `Genres`.`Name` = `Tracks`.`Genre`);"),
+
+         // An album belongs to its album artist, or to the track artist, as TrackDatabase files new tracks
+         QStringLiteral("INSERT INTO `Albums` (`Title`, `ArtistID`) "
+                        "SELECT DISTINCT `AlbumTitle`, COALESCE(`AlbumArtistID`, `ArtistID`) FROM `Tracks` "
+                        "WHERE `AlbumTitle` <> '';"),
+         QStringLiteral("UPDATE `Tracks` SET `AlbumID` = (SELECT `Albums`.`AlbumID` FROM `Albums` "
+                        "   WHERE `Albums`.`Title` = `Tracks`.`AlbumTitle` "
+                        "   AND `Albums`.`ArtistID` IS COALESCE(`Tracks`.`AlbumArtistID`, `Tracks`.`ArtistID`));"),
+
+         QStringLiteral("ALTER TABLE `Tracks` DROP COLUMN `ArtistName`;"),
+         QStringLiteral("ALTER TABLE `Tracks` DROP COLUMN `AlbumTitle`;"),
+         QStringLiteral("ALTER TABLE `Tracks` DROP COLUMN `AlbumArtistName`;"),
+         QStringLiteral("ALTER TABLE `Tracks` DROP COLUMN `Genre`;")});
+}
+
+// Durations were written as QTime text before they became milliseconds
+int durationMs(const QVariant& value) {
+    if (value.typeId() == QMetaType::QString) {
+        const QTime time = QTime::fromString(value.toString(), Qt::ISODateWithMs);
+        return time.isValid() ? time.msecsSinceStartOfDay() : 0;
+    }
+
+    return value.toInt();
+}
+
+// Version 3: TrackHash turns from text into the 64-bit hash of the track's columns, and ContentHash is added.
+// The column type cannot be altered, so the table is rebuilt and the hashes computed again from the rows.
+bool rebuildTrackHashes(const QSqlDatabase& db) {
+    if (columnType(db, QStringLiteral("Tracks"), QStringLiteral("TrackHash")) == QStringLiteral("INTEGER")) {
+        return true;
+    }
+
+    // Stored columns other than the two hashes, which are the same in both tables
+    const QString columns = QStringLiteral(
+        "`TrackID`, `FileName`, `Title`, `ArtistID`, `AlbumID`, `AlbumArtistID`, `TrackNumber`, `DiscNumber`,"
+        "`Duration`, `GenreID`, `Performer`, `Composer`, `Lyricist`, `Year`, `Channels`, `Bitrate`, `SampleRate`,"
+        "`HasEmbeddedCover`, `FileSize`, `FileModified`, `FileInode`, `DateAdded`");
+
+    // The view would stop the renamed table from replacing the dropped one, createSchema makes it again
+    const bool rebuilt = execAll(
+        db,
+        {QStringLiteral("DROP VIEW IF EXISTS `TrackView`;"),
+         QStringLiteral("CREATE TABLE `Tracks_new` ("
+                        "   `TrackID` INTEGER PRIMARY KEY AUTOINCREMENT,"
+                        "   `FileName` TEXT NOT NULL UNIQUE,"
+                        "   `Title` TEXT NOT NULL,"
+                        "   `ArtistID` INTEGER,"
+                        "   `AlbumID` INTEGER,"
+                        "   `AlbumArtistID` INTEGER,"
+                        "   `TrackNumber` INTEGER,"
+                        "   `DiscNumber` INTEGER,"
+                        "   `Duration` INTEGER NOT NULL,"
+                        "   `GenreID` INTEGER,"
+                        "   `Performer` TEXT,"
+                        "   `Composer` TEXT,"
+                        "   `Lyricist` TEXT,"
+                        "   `Year` INTEGER,"
+                        "   `Channels` INTEGER,"
+                        "   `Bitrate` INTEGER,"
+                        "   `SampleRate` INTEGER,"
+                        "   `HasEmbeddedCover` INTEGER,"
+                        "   `FileSize` INTEGER,"
+                        "   `FileModified` INTEGER,"
+                        "   `FileInode` INTEGER,"
+                        "   `DateAdded` DATETIME NOT NULL DEFAULT (CURRENT_TIMESTAMP),"
+                        "   `TrackHash` INTEGER UNIQUE,"
+                        "   `ContentHash` INTEGER,"
+                        "   FOREIGN KEY (`ArtistID`) REFERENCES `Artists`(`ArtistID`)"
+                        "       ON DELETE SET NULL,"
+                        "   FOREIGN KEY (`AlbumID`) REFERENCES `Albums`(`AlbumID`)"
+                        "       ON DELETE SET NULL,"
+                        "   FOREIGN KEY (`AlbumArtistID`) REFERENCES `Artists`(`ArtistID`)"
+                        "       ON DELETE SET NULL,"
+                        "   FOREIGN KEY (`GenreID`) REFERENCES `Genres`(`GenreID`)"
+                        "       ON DELETE SET NULL"
+                        ");"),
+         QStringLiteral("INSERT INTO `Tracks_new` (%1) SELECT %1 FROM `Tracks`;").arg(columns),
+         QStringLiteral("DROP TABLE `Tracks`;"),
+         QStringLiteral("ALTER TABLE `Tracks_new` RENAME TO `Tracks`;")});
+
+    if (!rebuilt) return false;
+
+    // The columns FileScanner hashes when it reads a file
+    SqlQuery select{db, QStringLiteral("SELECT `Tracks`.`TrackID`, `Tracks`.`FileName`, `Tracks`.`Title`,"
+                                       "   `Artist`.`Name`, `Albums`.`Title`, `AlbumArtist`.`Name`, `Genres`.`Name`,"
+                                       "   `Tracks`.`Year`, `Tracks`.`Duration`, `Tracks`.`Bitrate` "
+                                       "FROM `Tracks` "
+                                       "LEFT JOIN `Artists` AS `Artist` ON `Artist`.`ArtistID` = `Tracks`.`ArtistID` "
+                                       "LEFT JOIN `Artists` AS `AlbumArtist` "
+                                       "   ON `AlbumArtist`.`ArtistID` = `Tracks`.`AlbumArtistID` "
+                                       "LEFT JOIN `Albums` ON `Albums`.`AlbumID` = `Tracks`.`AlbumID` "
+                                       "LEFT JOIN `Genres` ON `Genres`.`GenreID` = `Tracks`.`GenreID`;")};
+    SqlQuery update{db, QStringLiteral("UPDATE `Tracks` SET `TrackHash` = :trackHash WHERE `TrackID` = :trackId;")};
+
+    if (!select.exec()) {
+        qWarning() << "Failed to read tracks: " << select.lastError().text();
+        return false;
+    }
+
+    using Metadata::Fields;
+    constexpr std::array fields{Fields::ResourceUrl, Fields::Title, Fields::Artist, Fields::Album,
+                                Fields::AlbumArtist, Fields::Genre, Fields::Year};
+
+    while (select.next()) {
+        Metadata::TrackFields track;
+
+        for (std::size_t i = 0; i < fields.size(); ++i) {
+            const QVariant value = select.value(static_cast<int>(i) + 1);
+            if (value.isNull()) continue;
+
+            if (fields[i] == Fields::ResourceUrl) {
+                track.insert(fields[i], QUrl{value.toString()});
+            } else {
+                track.insert(fields[i], value);
+            }
+        }
+
+        if (const int duration = durationMs(select.value(8)); duration > 0) {
+            track.insert(Fields::Duration, QTime::fromMSecsSinceStartOfDay(duration));
+        }
+        if (const QVariant bitRate = select.value(9); !bitRate.isNull()) {
+            track.insert(Fields::BitRate, bitRate);
+        }
+
+        update.bindValue(QStringLiteral(":trackHash"), static_cast<qint64>(track.generateHash()));
+        update.bindValue(QStringLiteral(":trackId"), select.value(0));
+
+        if (!update.exec()) {
+            qWarning() << "Failed to store track hash: " << update.lastError().text();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Version 4: durations stored as QTime text, "hh:mm:ss.zzz", become milliseconds like the ones written since
+bool storeDurationMs(const QSqlDatabase& db) {
+    return execAll(db, {QStringLiteral("UPDATE `Tracks` SET `Duration` = COALESCE(CAST(round("
+                                       "   (julianday('2000-01-01 ' || `Duration`) - julianday('2000-01-01'))"
+                                       "   * 86400000) AS INTEGER), 0) "
+                                       "WHERE typeof(`Duration`) = 'text';")});
+}
+
+// Version 5: playlist entries get their own id and a sparse position instead of a dense index.
+// The entries keep their order, spaced as PlaylistDatabase spaces them when it renumbers a playlist.
+bool addPlaylistPositions(const QSqlDatabase& db) {
+    if (!hasTable(db, QStringLiteral("PlaylistTracks")) ||
+        hasColumn(db, QStringLiteral("PlaylistTracks"), QStringLiteral("Position"))) {
+        return true;
+    }
+
+    return execAll(
+        db,
+        {QStringLiteral("CREATE TABLE `PlaylistTracks_new` ("
+                        "   `EntryID` INTEGER PRIMARY KEY AUTOINCREMENT,"
+                        "   `PlaylistID` INTEGER NOT NULL,"
+                        "   `TrackID` INTEGER NOT NULL,"
+                        "   `Position` INTEGER NOT NULL,"
+                        "   `DateAdded` DATETIME NOT NULL DEFAULT (CURRENT_TIMESTAMP),"
+                        "   FOREIGN KEY (`PlaylistID`) REFERENCES `Playlists`(`PlaylistID`)"
+                        "       ON DELETE CASCADE,"
+                        "   FOREIGN KEY (`TrackID`) REFERENCES `Tracks`(`TrackID`)"
+                        "       ON DELETE CASCADE"
+                        ");"),
+         QStringLiteral("INSERT INTO `PlaylistTracks_new` (`PlaylistID`, `TrackID`, `Position`, `DateAdded`) "
+                        "SELECT `PlaylistID`, `TrackID`,"
+                        "   ROW_NUMBER() OVER (PARTITION BY `PlaylistID` ORDER BY `TrackIndex`, `rowid`) * %1,"
+                        "   `DateAdded` "
+                        "FROM `PlaylistTracks` ORDER BY `PlaylistID`, `TrackIndex`, `rowid`;")
+             .arg(PlaylistDatabase::PositionGap),
+         // Takes the old order index and the triggers with it, createSchema makes the index again
+         QStringLiteral("DROP TABLE `PlaylistTracks`;"),
+         QStringLiteral("ALTER TABLE `PlaylistTracks_new` RENAME TO `PlaylistTracks`;")});
+}
+
+struct Migration {
+    int version;
+    bool (*apply)(const QSqlDatabase& db);
+};
+
+// In version order, the last one is `DbSchema::latestVersion`
+constexpr std::array migrations{
+    Migration{1, addFileFingerprints},
+    Migration{2, normalizeNames},
+    Migration{3, rebuildTrackHashes},
+    Migration{4, storeDurationMs},
+    Migration{5, addPlaylistPositions},
+};
+
+static_assert(migrations.back().version == DbSchema::latestVersion);
+
+} // namespace
 
 DbSchema::DbSchema(const DbConnection& dbConnection, QObject* parent) : QObject(parent), m_status{DbStatus::Ok} {
     if (!dbConnection.isValid()) {
@@ -37,19 +319,62 @@ bool DbSchema::createSchema(const QSqlDatabase& db) {
         }
     }
 
+    // Names shared by many tracks are stored once and referenced by id
+    {
+        const QStringList nameStatements = {
+            "CREATE TABLE IF NOT EXISTS `Artists` ("
+            "   `ArtistID` INTEGER PRIMARY KEY AUTOINCREMENT,"
+            "   `Name` TEXT NOT NULL UNIQUE"
+            ");",
+
+            "CREATE TABLE IF NOT EXISTS `Genres` ("
+            "   `GenreID` INTEGER PRIMARY KEY AUTOINCREMENT,"
+            "   `Name` TEXT NOT NULL UNIQUE"
+            ");",
+
+            "CREATE TABLE IF NOT EXISTS `Albums` ("
+            "   `AlbumID` INTEGER PRIMARY KEY AUTOINCREMENT,"
+            "   `Title` TEXT NOT NULL,"
+            "   `ArtistID` INTEGER,"
+            "   UNIQUE (`Title`, `ArtistID`),"
+            "   FOREIGN KEY (`ArtistID`) REFERENCES `Artists`(`ArtistID`)"
+            "       ON DELETE SET NULL"
+            ");"
+        };
+
+        for (const QString& statement : nameStatements) {
+            SqlQuery query{db, statement};
+            if (!query.exec()) {
+                qWarning() << "Failed to create name table: " << query.lastError().text();
+                setStatus(DbStatus::DatabaseError);
+                return false;
+            }
+        }
+    }
+
+    // A database without tracks is new and gets the latest tables as they are.
+    // Upgrades run after the name tables exist, since they fill them.
+    if (const int version = userVersion(db); version < latestVersion && hasTable(db, QStringLiteral("Tracks"))) {
+        if (!upgradeSchema(db, version)) {
+            setStatus(DbStatus::BrokenSchemaError);
+            return false;
+        }
+    }
+
+    // Columns added here also go into trackcolumns.h, which generates every track statement
     {
         const QString statement = QStringLiteral(
             "CREATE TABLE IF NOT EXISTS `Tracks` ("
             "   `TrackID` INTEGER PRIMARY KEY AUTOINCREMENT,"
             "   `FileName` TEXT NOT NULL UNIQUE,"
             "   `Title` TEXT NOT NULL,"
-            "   `ArtistName` TEXT,"
-            "   `AlbumTitle` TEXT,"
-            "   `AlbumArtistName` TEXT,"
+            "   `ArtistID` INTEGER,"
+            "   `AlbumID` INTEGER,"
+            "   `AlbumArtistID` INTEGER,"
             "   `TrackNumber` INTEGER,"
             "   `DiscNumber` INTEGER,"
-            "   `Duration` INTEGER NOT NULL,"
-            "   `Genre` TEXT,"
+            "   `Duration` INTEGER NOT NULL," // milliseconds
+            "   `GenreID` INTEGER,"
             "   `Performer` TEXT,"
             "   `Composer` TEXT,"
             "   `Lyricist` TEXT,"
@@ -58,8 +383,20 @@ bool DbSchema::createSchema(const QSqlDatabase& db) {
             "   `Bitrate` INTEGER,"
             "   `SampleRate` INTEGER,"
             "   `HasEmbeddedCover` INTEGER,"
+            "   `FileSize` INTEGER,"
+            "   `FileModified` INTEGER,"
+            "   `FileInode` INTEGER,"
             "   `DateAdded` DATETIME NOT NULL DEFAULT (CURRENT_TIMESTAMP),"
-            "   `TrackHash` TEXT UNIQUE"
+            "   `TrackHash` INTEGER UNIQUE,"
+            "   `ContentHash` INTEGER,"
+            "   FOREIGN KEY (`ArtistID`) REFERENCES `Artists`(`ArtistID`)"
+            "       ON DELETE SET NULL,"
+            "   FOREIGN KEY (`AlbumID`) REFERENCES `Albums`(`AlbumID`)"
+            "       ON DELETE SET NULL,"
+            "   FOREIGN KEY (`AlbumArtistID`) REFERENCES `Artists`(`ArtistID`)"
+            "       ON DELETE SET NULL,"
+            "   FOREIGN KEY (`GenreID`) REFERENCES `Genres`(`GenreID`)"
+            "       ON DELETE SET NULL"
             ");"
         );
 
@@ -71,6 +408,33 @@ bool DbSchema::createSchema(const QSqlDatabase& db) {
         }
     }
 
+    // Tracks with their names resolved, for everything that reads whole tracks
+    {
+        const QString statement = QStringLiteral(
+            "CREATE VIEW IF NOT EXISTS `TrackView` AS "
+            "SELECT `Tracks`.`TrackID`, `Tracks`.`FileName`, `Tracks`.`Title`,"
+            "   `Artist`.`Name` AS `ArtistName`, `Albums`.`Title` AS `AlbumTitle`,"
+            "   `AlbumArtist`.`Name` AS `AlbumArtistName`, `Tracks`.`TrackNumber`, `Tracks`.`DiscNumber`,"
+            "   `Tracks`.`Duration`, `Genres`.`Name` AS `Genre`, `Tracks`.`Performer`, `Tracks`.`Composer`,"
+            "   `Tracks`.`Lyricist`, `Tracks`.`Year`, `Tracks`.`Channels`, `Tracks`.`Bitrate`, `Tracks`.`SampleRate`,"
+            "   `Tracks`.`HasEmbeddedCover`, `Tracks`.`FileSize`, `Tracks`.`FileModified`, `Tracks`.`FileInode`,"
+            "   `Tracks`.`TrackHash`, `Tracks`.`DateAdded`, `Tracks`.`AlbumID`, `Tracks`.`ContentHash`,"
+            "   `Tracks`.`ArtistID`, `Tracks`.`AlbumArtistID`, `Tracks`.`GenreID` "
+            "FROM `Tracks` "
+            "LEFT JOIN `Artists` AS `Artist` ON `Artist`.`ArtistID` = `Tracks`.`ArtistID` "
+            "LEFT JOIN `Artists` AS `AlbumArtist` ON `AlbumArtist`.`ArtistID` = `Tracks`.`AlbumArtistID` "
+            "LEFT JOIN `Albums` ON `Albums`.`AlbumID` = `Tracks`.`AlbumID` "
+            "LEFT JOIN `Genres` ON `Genres`.`GenreID` = `Tracks`.`GenreID`;"
+        );
+
+        SqlQuery query{db, statement};
+        if (!query.exec()) {
+            qWarning() << "Failed to create TrackView view: " << query.lastError().text();
+            setStatus(DbStatus::DatabaseError);
+            return false;
+        }
+    }
+
     {
         const QString statement = QStringLiteral(
             "CREATE TABLE IF NOT EXISTS `Playlists` ("
@@ -92,11 +456,11 @@ bool DbSchema::createSchema(const QSqlDatabase& db) {
     {
         const QString statement = QStringLiteral(
             "CREATE TABLE IF NOT EXISTS `PlaylistTracks` ("
+            "   `EntryID` INTEGER PRIMARY KEY AUTOINCREMENT,"
             "   `PlaylistID` INTEGER NOT NULL,"
             "   `TrackID` INTEGER NOT NULL,"
-            "   `TrackIndex` INTEGER NOT NULL,"
+            "   `Position` INTEGER NOT NULL," // sparse, entries are ordered by it
             "   `DateAdded` DATETIME NOT NULL DEFAULT (CURRENT_TIMESTAMP),"
-            "   PRIMARY KEY (`PlaylistID`, `TrackID`),"
             "   FOREIGN KEY (`PlaylistID`) REFERENCES `Playlists`(`PlaylistID`)"
             "       ON DELETE CASCADE,"
             "   FOREIGN KEY (`TrackID`) REFERENCES `Tracks`(`TrackID`)"
@@ -116,7 +480,15 @@ bool DbSchema::createSchema(const QSqlDatabase& db) {
     {
         const QStringList indexStatements = {
             "CREATE INDEX IF NOT EXISTS idx_tracks_filename ON `Tracks`(`FileName`);",
-            "CREATE INDEX IF NOT EXISTS idx_playlist_tracks_order ON `PlaylistTracks`(`PlaylistID`, `TrackIndex`);"
+            "CREATE INDEX IF NOT EXISTS idx_tracks_artist ON `Tracks`(`ArtistID`);",
+            "CREATE INDEX IF NOT EXISTS idx_tracks_album ON `Tracks`(`AlbumID`);",
+            "CREATE INDEX IF NOT EXISTS idx_tracks_album_artist ON `Tracks`(`AlbumArtistID`);",
+            "CREATE INDEX IF NOT EXISTS idx_tracks_genre ON `Tracks`(`GenreID`);",
+            "CREATE INDEX IF NOT EXISTS idx_albums_artist ON `Albums`(`ArtistID`);",
+            "CREATE INDEX IF NOT EXISTS idx_tracks_content_hash ON `Tracks`(`ContentHash`) WHERE `ContentHash` IS NOT NULL;",
+            "CREATE INDEX IF NOT EXISTS idx_playlist_tracks_order ON `PlaylistTracks`(`PlaylistID`, `Position`);",
+            // Deleting a track cascades into playlists
+            "CREATE INDEX IF NOT EXISTS idx_playlist_tracks_track ON `PlaylistTracks`(`TrackID`);"
         };
 
         for (const QString& statement : indexStatements) {
@@ -129,44 +501,33 @@ bool DbSchema::createSchema(const QSqlDatabase& db) {
         }
     }
 
-    // Create triggers
+    // Databases created before PlaylistDatabase touched the playlist once per edit rewrote it for every entry
     {
         const QStringList triggerStatements = {
-            "CREATE TRIGGER IF NOT EXISTS update_playlist_modified_insert "
-            "AFTER INSERT ON `PlaylistTracks` "
-            "BEGIN "
-            "   UPDATE `Playlists` "
-            "   SET `LastModified` = (CURRENT_TIMESTAMP) "
-            "   WHERE `PlaylistID` = NEW.PlaylistID; "
-            "END;",
-
-            "CREATE TRIGGER IF NOT EXISTS update_playlist_modified_delete "
-            "AFTER DELETE ON `PlaylistTracks` "
-            "BEGIN "
-            "   UPDATE `Playlists` "
-            "   SET `LastModified` = (CURRENT_TIMESTAMP) "
-            "   WHERE `PlaylistID` = OLD.PlaylistID; "
-            "END;",
-
-            "CREATE TRIGGER IF NOT EXISTS update_playlist_modified_update "
-            "AFTER UPDATE ON `PlaylistTracks` "
-            "BEGIN "
-            "   UPDATE `Playlists` "
-            "   SET `LastModified` = (CURRENT_TIMESTAMP) "
-            "   WHERE `PlaylistID` = NEW.PlaylistID; "
-            "END;"
+            "DROP TRIGGER IF EXISTS update_playlist_modified_insert;",
+            "DROP TRIGGER IF EXISTS update_playlist_modified_delete;",
+            "DROP TRIGGER IF EXISTS update_playlist_modified_update;"
         };
 
         for (const QString& statement : triggerStatements) {
             SqlQuery query{db, statement};
             if (!query.exec()) {
-                qWarning() << "Failed to create trigger: " << query.lastError().text();
+                qWarning() << "Failed to drop trigger: " << query.lastError().text();
                 setStatus(DbStatus::DatabaseError);
                 return false;
             }
         }
     }
 
+    {
+        SqlQuery query{db, QStringLiteral("PRAGMA user_version = %1;").arg(latestVersion)};
+        if (!query.exec()) {
+            qWarning() << "Failed to set schema version: " << query.lastError().text();
+            setStatus(DbStatus::DatabaseError);
+            return false;
+        }
+    }
+
     {
         SqlQuery query{db, "PRAGMA foreign_keys = ON;"};
         if (!query.exec()) {
@@ -178,3 +539,27 @@ bool DbSchema::createSchema(const QSqlDatabase& db) {
 
     return m_status == DbStatus::Ok;
 }
+
+bool DbSchema::upgradeSchema(const QSqlDatabase& db, const int version) {
+    // Foreign keys are off here, so tables can be rebuilt without cascading into the ones that refer to them
+    for (const Migration& migration : migrations) {
+        if (migration.version <= version) continue;
+
+        QSqlDatabase database = db;
+        if (!database.transaction()) {
+            qWarning() << "Failed to start schema upgrade: " << database.lastError().text();
+            return false;
+        }
+
+        if (!migration.apply(db) ||
+            !execAll(db, {QStringLiteral("PRAGMA user_version = %1;").arg(migration.version)}) || !database.commit()) {
+            qWarning() << "Failed to upgrade database to version " << migration.version;
+            database.rollback();
+            return false;
+        }
+
+        qInfo() << "Upgraded database to version " << migration.version;
+    }
+
+    return true;
+}
@@ -28,8 +28,14 @@ Q_SIGNALS:
     void statusChanged(DbStatus status);
     void schemaChanged(int newVersion);
 
+    // Raised by every change to the tables of an existing database, see upgradeSchema
+    static constexpr int latestVersion = 5;
+
 private:
     bool createSchema(const QSqlDatabase& db);
+    // Brings the tables of a database written by an older version up to `latestVersion`,
+    // one step per version, each in its own transaction
+    bool upgradeSchema(const QSqlDatabase& db, int version);
 
     DbStatus m_status;
 };
@@ -5,148 +5,110 @@
 
 #include <QSqlError>
 
-QList<Metadata::PlaylistRecord> PlaylistDatabase::getPlaylists() const {
-    const auto db = this->db();
+#include <limits>
+
+QList<Metadata::PlaylistHeader> PlaylistDatabase::getPlaylistHeaders() const {
+    const auto reader = readLease();
+    static const QString statement = QStringLiteral(
+        "SELECT `Playlists`.`PlaylistID`, `Playlists`.`PlaylistName`, `Playlists`.`DateCreated`, "
+        "`Playlists`.`LastModified`, COUNT(`PlaylistTracks`.`TrackID`), COALESCE(SUM(`Tracks`.`Duration`), 0) "
+        "FROM `Playlists` "
+        "LEFT JOIN `PlaylistTracks` ON `PlaylistTracks`.`PlaylistID` = `Playlists`.`PlaylistID` "
+        "LEFT JOIN `Tracks` ON `Tracks`.`TrackID` = `PlaylistTracks`.`TrackID` "
+        "GROUP BY `Playlists`.`PlaylistID` "
+        "ORDER BY `Playlists`.`DateCreated` DESC, `Playlists`.`PlaylistID` DESC;");
+    const auto query = cachedQuery(statement);
+
+    if (!query->exec()) {
+        qWarning() << "Failed to list playlists: " << query->lastError().text();
+        return {};
+    }
 
-    int count = 0;
-    {
-        const QString countStatement = QStringLiteral("SELECT COUNT(*) FROM `Playlists`;");
-        SqlQuery query{db, countStatement};
-        if (query.exec() && query.next()) {
-            count = query.value(0).toInt();
-            if (count == 0) return {};
-        }
+    QList<Metadata::PlaylistHeader> playlists;
+
+    while (query->next()) {
+        playlists.append({.id = query->value(0).toULongLong(),
+                          .name = query->value(1).toString(),
+                          .trackCount = query->value(4).toInt(),
+                          .totalDuration = query->value(5).toLongLong(),
+                          .dateCreated = query->value(2).toDateTime(),
+                          .lastModified = query->value(3).toDateTime()});
     }
 
-    const QString statement = QStringLiteral("SELECT `PlaylistID`, `PlaylistName`, `DateCreated`, `LastModified` "
-                                             "FROM `Playlists` ORDER BY `DateCreated` DESC;");
-    SqlQuery query{db, statement};
+    return playlists;
+}
 
-    if (!query.exec()) return {};
+QList<Metadata::PlaylistRecord> PlaylistDatabase::getPlaylists() const {
+    const auto reader = readLease();
+    // One row per track, playlists without tracks still get a row with a NULL track
+    static const QString statement = QStringLiteral(
+        "SELECT `Playlists`.`PlaylistID`, `Playlists`.`PlaylistName`, `Playlists`.`DateCreated`, "
+        "`Playlists`.`LastModified`, `PlaylistTracks`.`TrackID` "
+        "FROM `Playlists` "
+        "LEFT JOIN `PlaylistTracks` ON `PlaylistTracks`.`PlaylistID` = `Playlists`.`PlaylistID` "
+        "ORDER BY `Playlists`.`DateCreated` DESC, `Playlists`.`PlaylistID` DESC, `PlaylistTracks`.`Position`, "
+        "`PlaylistTracks`.`EntryID`;");
+    const auto query = cachedQuery(statement);
+
+    if (!query->exec()) return {};
 
     QList<Metadata::PlaylistRecord> playlists;
-    playlists.reserve(count);
-
-    const QString trackStatement = QStringLiteral(
-        "SELECT `TrackID` FROM `PlaylistTracks` WHERE `PlaylistID` = :playlistId ORDER BY `TrackIndex` ASC;");
-    SqlQuery trackQuery{db, trackStatement};
-
-    const QString countStatement =
-        QStringLiteral("SELECT COUNT(*) FROM `PlaylistTracks` WHERE `PlaylistID` = :playlistId;");
-    SqlQuery countQuery{db, countStatement};
-
-    while (query.next()) {
-        Metadata::PlaylistRecord rec{.id = query.value(0).toULongLong(),
-                                     .name = query.value(1).toString(),
-                                     .trackIds = {},
-                                     .dateCreated = query.value(2).toDateTime(),
-                                     .lastModified = query.value(3).toDateTime()};
-
-        trackQuery.bindValue(QStringLiteral(":playlistId"), rec.id);
-        countQuery.bindValue(QStringLiteral(":playlistId"), rec.id);
-
-        if (countQuery.exec() && countQuery.next()) {
-            const int trackCount = countQuery.value(0).toInt();
-            if (trackCount == 0) continue;
-            rec.trackIds.reserve(trackCount);
+
+    while (query->next()) {
+        const quint64 id = query->value(0).toULongLong();
+
+        if (playlists.isEmpty() || playlists.last().id != id) {
+            playlists.append({.id = id,
+                              .name = query->value(1).toString(),
+                              .trackIds = {},
+                              .dateCreated = query->value(2).toDateTime(),
+                              .lastModified = query->value(3).toDateTime()});
         }
 
-        if (trackQuery.exec()) {
-            while (trackQuery.next()) {
-                rec.trackIds.append(trackQuery.value(0).toULongLong());
-            }
+        if (!query->isNull(4)) {
+            playlists.last().trackIds.append(query->value(4).toULongLong());
         }
-        playlists.append(rec);
     }
 
     return playlists;
 }
 
 Metadata::PlaylistRecord PlaylistDatabase::getPlaylist(const QString& name) const {
-    const auto db = this->db();
-
-    const QString statement = QStringLiteral("SELECT `PlaylistID`, `DateCreated`, `LastModified` "
-                                             "FROM `Playlists` WHERE `PlaylistName` = :name;");
-    SqlQuery query{db, statement};
-    query.bindStringValue(QStringLiteral(":name"), name);
-
-    if (!query.exec() || !query.next()) return {};
-
-    Metadata::PlaylistRecord rec{.id = query.value(0).toULongLong(),
-                                 .name = name,
-                                 .trackIds = {},
-                                 .dateCreated = query.value(1).toDateTime(),
-                                 .lastModified = query.value(2).toDateTime()};
-
-    const QString trackStatement = QStringLiteral(
-        "SELECT `TrackID` FROM `PlaylistTracks` WHERE `PlaylistID` = :playlistId ORDER BY `TrackIndex` ASC;");
-    SqlQuery trackQuery{db, trackStatement};
-    trackQuery.bindValue(QStringLiteral(":playlistId"), rec.id);
-
-    const QString countStatement =
-        QStringLiteral("SELECT COUNT(*) FROM `PlaylistTracks` WHERE `PlaylistID` = :playlistId;");
-    SqlQuery countQuery{db, countStatement};
-    countQuery.bindValue(QStringLiteral(":playlistId"), rec.id);
-
-    if (countQuery.exec() && countQuery.next()) {
-        const int trackCount = countQuery.value(0).toInt();
-        if (trackCount == 0) return rec;
-        rec.trackIds.reserve(trackCount);
-    }
-
-    if (trackQuery.exec()) {
-        while (trackQuery.next()) {
-            rec.trackIds.append(trackQuery.value(0).toULongLong());
-        }
-    }
+    const auto reader = readLease();
+    static const QString statement = QStringLiteral("SELECT `PlaylistID`, `PlaylistName`, `DateCreated`, "
+                                                    "`LastModified` FROM `Playlists` WHERE `PlaylistName` = :name;");
+    const auto query = cachedQuery(statement);
+    query->bindStringValue(QStringLiteral(":name"), name);
 
-    return rec;
+    return readPlaylist(*query);
 }
 
 Metadata::PlaylistRecord PlaylistDatabase::getPlaylist(const quint64 id) const {
-    const auto db = this->db();
+    const auto reader = readLease();
+    static const QString statement = QStringLiteral("SELECT `PlaylistID`, `PlaylistName`, `DateCreated`, "
+                                                    "`LastModified` FROM `Playlists` WHERE `PlaylistID` = :id;");
+    const auto query = cachedQuery(statement);
+    query->bindValue(QStringLiteral(":id"), id);
 
-    const QString statement = QStringLiteral("SELECT `PlaylistName`, `DateCreated`, `LastModified` "
-                                             "FROM `Playlists` WHERE `PlaylistID` = :id;");
-    SqlQuery query{db, statement};
-    query.bindValue(QStringLiteral(":id"), id);
+    return readPlaylist(*query);
+}
 
+Metadata::PlaylistRecord PlaylistDatabase::readPlaylist(SqlQuery& query) const {
     if (!query.exec() || !query.next()) return {};
 
-    Metadata::PlaylistRecord rec{.id = id,
-                                 .name = query.value(0).toString(),
+    Metadata::PlaylistRecord rec{.id = query.value(0).toULongLong(),
+                                 .name = query.value(1).toString(),
                                  .trackIds = {},
-                                 .dateCreated = query.value(1).toDateTime(),
-                                 .lastModified = query.value(2).toDateTime()};
-
-    const QString trackStatement = QStringLiteral(
-        "SELECT `TrackID` FROM `PlaylistTracks` WHERE `PlaylistID` = :playlistId ORDER BY `TrackIndex` ASC;");
-    SqlQuery trackQuery{db, trackStatement};
-    trackQuery.bindValue(QStringLiteral(":playlistId"), id);
-
-    const QString countStatement =
-        QStringLiteral("SELECT COUNT(*) FROM `PlaylistTracks` WHERE `PlaylistID` = :playlistId;");
-    SqlQuery countQuery{db, countStatement};
-    countQuery.bindValue(QStringLiteral(":playlistId"), rec.id);
-
-    if (countQuery.exec() && countQuery.next()) {
-        const int trackCount = countQuery.value(0).toInt();
-        if (trackCount == 0) return rec;
-        rec.trackIds.reserve(trackCount);
-    }
-
-    if (trackQuery.exec()) {
-        while (trackQuery.next()) {
-            rec.trackIds.append(trackQuery.value(0).toULongLong());
-        }
-    }
+                                 .dateCreated = query.value(2).toDateTime(),
+                                 .lastModified = query.value(3).toDateTime()};
+    rec.trackIds = getPlaylistTracks(rec.id);
 
     return rec;
 }
 
 bool PlaylistDatabase::savePlaylist(const Metadata::PlaylistRecord& record) const {
+    SqlTransaction transaction{writeLease()};
     auto db = this->db();
-    SqlTransaction transaction{db};
 
     const QString statement = QStringLiteral("INSERT INTO `Playlists` (`PlaylistName`) VALUES (:name);");
     SqlQuery query{db, statement};
@@ -160,33 +122,17 @@ bool PlaylistDatabase::savePlaylist(const Metadata::PlaylistRecord& record) cons
 
     const quint64 playlistId = query.lastInsertId().toULongLong();
 
-    if (record.trackIds.isEmpty()) {
-        return transaction.commit();
-    }
-
-    const QString trackStatement = QStringLiteral("INSERT INTO `PlaylistTracks` (`PlaylistID`, `TrackID`, "
-                                                  "`TrackIndex`) VALUES (:playlistId, :trackId, :trackIndex);");
-    SqlQuery trackQuery{db, trackStatement};
-    trackQuery.bindValue(QStringLiteral(":playlistId"), playlistId);
-
-    for (int i = 0; i < record.trackIds.size(); ++i) {
-        trackQuery.bindValue(QStringLiteral(":trackId"), record.trackIds.at(i));
-        trackQuery.bindValue(QStringLiteral(":trackIndex"), i);
-
-        if (!trackQuery.exec()) {
-            qWarning() << "Failed to insert playlist track: " << trackQuery.lastError().text()
-                       << "\nLast query: " << trackQuery.lastQuery();
-            db.rollback();
-            return false;
-        }
+    if (!record.trackIds.isEmpty() && !insertEntries(playlistId, 0, record.trackIds)) {
+        db.rollback();
+        return false;
     }
 
     return transaction.commit();
 }
 
 bool PlaylistDatabase::updatePlaylist(const Metadata::PlaylistRecord& record) const {
+    SqlTransaction transaction{writeLease()};
     const auto db = this->db();
-    SqlTransaction transaction{db};
 
     const QString statement = QStringLiteral("UPDATE `Playlists` SET `PlaylistName` = :name WHERE `PlaylistID` = :id;");
     SqlQuery query{db, statement};
@@ -199,63 +145,30 @@ bool PlaylistDatabase::updatePlaylist(const Metadata::PlaylistRecord& record) co
         return false;
     }
 
-    const QList<quint64> currentTracks = getPlaylistTracks(record.id);
-
-    if (currentTracks != record.trackIds) {
-        const QString deleteStatement = QStringLiteral("DELETE FROM `PlaylistTracks` WHERE `PlaylistID` = :id;");
-        SqlQuery deleteQuery{db, deleteStatement};
-        deleteQuery.bindValue(QStringLiteral(":id"), record.id);
-
-        if (!deleteQuery.exec()) {
-            qWarning() << "Failed to delete playlist tracks: " << deleteQuery.lastError().text();
-            return false;
-        }
-
-        // TODO: is this faster than looping
-        if (!record.trackIds.isEmpty()) {
-            const QString trackStatement =
-                QStringLiteral("INSERT INTO `PlaylistTracks` (`PlaylistID`, `TrackID`, `TrackIndex`) VALUES (?, ?, ?)");
-
-            SqlQuery trackQuery{db, trackStatement};
-
-            QVariantList playlistIds;
-            playlistIds.fill(record.id, record.trackIds.size());
-
-            QVariantList trackIds;
-            QVariantList trackIndices;
-
-            trackIds.reserve(record.trackIds.size());
-            trackIndices.reserve(record.trackIds.size());
+    if (!replaceEntries(record.id, getPlaylistTracks(record.id), record.trackIds)) return false;
+    if (!touchPlaylist(record.id)) return false;
 
-            for (int i = 0; i < record.trackIds.size(); ++i) {
-                trackIds << record.trackIds.at(i);
-                trackIndices << i;
-            }
-
-            trackQuery.addBindValue(playlistIds);
-            trackQuery.addBindValue(trackIds);
-            trackQuery.addBindValue(trackIndices);
+    return transaction.commit();
+}
 
-            if (!trackQuery.execBatch()) {
-                qWarning() << "Failed to insert playlist tracks: " << trackQuery.lastError().text();
-                return false;
-            }
-        }
-    }
+bool PlaylistDatabase::renamePlaylist(const quint64 id, const QString& name) const {
+    const auto writer = writeLease();
+    static const QString statement = QStringLiteral(
+        "UPDATE `Playlists` SET `PlaylistName` = :name, `LastModified` = CURRENT_TIMESTAMP WHERE `PlaylistID` = :id;");
+    const auto query = cachedQuery(statement);
+    query->bindStringValue(QStringLiteral(":name"), name);
+    query->bindValue(QStringLiteral(":id"), id);
 
-    const QString updateStatement =
-        QStringLiteral("UPDATE `Playlists` SET `LastModified` = CURRENT_TIMESTAMP WHERE `PlaylistID` = :id;");
-    SqlQuery updateQuery{db, updateStatement};
-    updateQuery.bindValue(QStringLiteral(":id"), record.id);
-    if (!updateQuery.exec()) {
-        qWarning() << "Failed to update playlist last modified date: " << updateQuery.lastError().text();
+    if (!query->exec()) {
+        qWarning() << "Failed to rename playlist: " << query->lastError().text();
         return false;
     }
 
-    return transaction.commit();
+    return query->numRowsAffected() > 0;
 }
 
 bool PlaylistDatabase::removePlaylist(const quint64 id) const {
+    const auto writer = writeLease();
     const QString statement = QStringLiteral("DELETE FROM `PlaylistTracks` WHERE `PlaylistID` = :id;");
     SqlQuery query{db(), statement};
     query.bindValue(QStringLiteral(":id"), id);
@@ -277,66 +190,183 @@ bool PlaylistDatabase::removePlaylist(const quint64 id) const {
     return true;
 }
 
-// TODO: this can be optimized but it is currently unused
-bool PlaylistDatabase::addTracksToPlaylist(const quint64 playlistId, const QList<quint64>& trackIds) const {
-    const QString statement = QStringLiteral("INSERT INTO `PlaylistTracks` (`PlaylistID`, `TrackID`, `TrackIndex`) "
-                                             "VALUES (:playlistId, :trackId, :trackIndex);");
-    SqlQuery query{db(), statement};
-    query.bindValue(QStringLiteral(":playlistId"), playlistId);
+bool PlaylistDatabase::insertTracks(const quint64 playlistId, const qsizetype row,
+                                    const QList<quint64>& trackIds) const {
+    if (trackIds.isEmpty()) return true;
 
-    for (int i = 0; i < trackIds.size(); ++i) {
-        query.bindValue(QStringLiteral(":trackId"), trackIds.at(i));
-        query.bindValue(QStringLiteral(":trackIndex"), i);
+    SqlTransaction transaction{writeLease()};
+    if (!insertEntries(playlistId, row, trackIds) || !touchPlaylist(playlistId)) return false;
 
-        if (!query.exec()) {
-            qWarning() << "Failed to add track to playlist: " << query.lastError().text();
-            return false;
-        }
-    }
+    return transaction.commit();
+}
 
-    return true;
+bool PlaylistDatabase::moveTracks(const quint64 playlistId, const qsizetype first, const qsizetype count,
+                                  const qsizetype destination) const {
+    // Moving a range in front of itself or right behind itself changes nothing
+    if (count <= 0 || (destination >= first && destination <= first + count)) return true;
+
+    SqlTransaction transaction{writeLease()};
+    if (!moveEntries(playlistId, first, count, destination) || !touchPlaylist(playlistId)) return false;
+
+    return transaction.commit();
+}
+
+bool PlaylistDatabase::removeTracks(const quint64 playlistId, const qsizetype first, const qsizetype count) const {
+    if (count <= 0) return true;
+
+    SqlTransaction transaction{writeLease()};
+    if (!removeEntries(playlistId, first, count) || !touchPlaylist(playlistId)) return false;
+
+    return transaction.commit();
+}
+
+bool PlaylistDatabase::addTracksToPlaylist(const quint64 playlistId, const QList<quint64>& trackIds) const {
+    return insertTracks(playlistId, -1, trackIds);
 }
 
 bool PlaylistDatabase::removeTrackFromPlaylist(const quint64 playlistId, const quint64 trackId) const {
-    const QString statement =
+    SqlTransaction transaction{writeLease()};
+    // The remaining entries keep their positions, nothing has to be shifted
+    static const QString statement =
         QStringLiteral("DELETE FROM `PlaylistTracks` WHERE `PlaylistID` = :playlistId AND `TrackID` = :trackId;");
-    SqlQuery query{db(), statement};
-    query.bindValue(QStringLiteral(":playlistId"), playlistId);
-    query.bindValue(QStringLiteral(":trackId"), trackId);
+    const auto query = cachedQuery(statement);
+    query->bindValue(QStringLiteral(":playlistId"), playlistId);
+    query->bindValue(QStringLiteral(":trackId"), trackId);
 
-    if (!query.exec()) {
-        qWarning() << "Failed to remove track from playlist: " << query.lastError().text();
+    if (!query->exec()) {
+        qWarning() << "Failed to remove track from playlist: " << query->lastError().text();
         return false;
     }
 
-    const QString updateStatement = QStringLiteral(
-        "UPDATE `PlaylistTracks` SET `TrackIndex` = `TrackIndex` - 1 WHERE `PlaylistID` = :playlistId AND "
-        "`TrackIndex` > (SELECT `TrackIndex` FROM `PlaylistTracks` WHERE `PlaylistID` = :playlistId AND `TrackID` = "
-        ":trackId);");
-    SqlQuery updateQuery{db(), updateStatement};
-    updateQuery.bindValue(QStringLiteral(":playlistId"), playlistId);
+    if (!touchPlaylist(playlistId)) return false;
 
-    if (!updateQuery.exec()) {
-        qWarning() << "Failed to update playlist track indexes: " << updateQuery.lastError().text();
+    return transaction.commit();
+}
+
+bool PlaylistDatabase::reorderPlaylistTracks(const quint64 playlistId, const QList<quint64>& trackIds) const {
+    SqlTransaction transaction{writeLease()};
+    if (!replaceEntries(playlistId, getPlaylistTracks(playlistId), trackIds) || !touchPlaylist(playlistId)) {
+        return false;
+    }
+
+    return transaction.commit();
+}
+
+QList<quint64> PlaylistDatabase::getPlaylistTracks(const quint64 id) const {
+    const auto reader = readLease();
+    static const QString statement = QStringLiteral(
+        "SELECT `TrackID` FROM `PlaylistTracks` WHERE `PlaylistID` = :id ORDER BY `Position`, `EntryID`;");
+    const auto query = cachedQuery(statement);
+    query->bindValue(QStringLiteral(":id"), id);
+
+    if (!query->exec()) {
+        qWarning() << "Failed to get playlist tracks: " << query->lastError().text();
+        return {};
+    }
+
+    QList<quint64> tracks;
+
+    while (query->next()) {
+        tracks.append(query->value(0).toULongLong());
+    }
+
+    return tracks;
+}
+
+std::optional<qint64> PlaylistDatabase::positionAt(const quint64 playlistId, const qsizetype row) const {
+    static const QString statement = QStringLiteral("SELECT `Position` FROM `PlaylistTracks` WHERE `PlaylistID` = :id "
+                                                    "ORDER BY `Position`, `EntryID` LIMIT 1 OFFSET :row;");
+    const auto query = cachedQuery(statement);
+    query->bindValue(QStringLiteral(":id"), playlistId);
+    query->bindValue(QStringLiteral(":row"), row);
+
+    if (row < 0 || !query->exec() || !query->next()) return std::nullopt;
+    return query->value(0).toLongLong();
+}
+
+std::optional<qint64> PlaylistDatabase::lastPosition(const quint64 playlistId) const {
+    static const QString statement =
+        QStringLiteral("SELECT MAX(`Position`) FROM `PlaylistTracks` WHERE `PlaylistID` = :id;");
+    const auto query = cachedQuery(statement);
+    query->bindValue(QStringLiteral(":id"), playlistId);
+
+    if (!query->exec() || !query->next() || query->isNull(0)) return std::nullopt;
+    return query->value(0).toLongLong();
+}
+
+QList<qint64> PlaylistDatabase::allocatePositions(const quint64 playlistId, qsizetype row,
+                                                  const qsizetype count) const {
+    if (row < 0) row = std::numeric_limits<qsizetype>::max();
+
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        // Past the end there is no entry at the row, the new ones go behind the last entry
+        const std::optional<qint64> after = positionAt(playlistId, row);
+        const std::optional<qint64> before =
+            row == 0 ? std::nullopt : (after ? positionAt(playlistId, row - 1) : lastPosition(playlistId));
+
+        const qint64 span = PositionGap * (count + 1);
+        const qint64 low = before.value_or(after.value_or(span) - span);
+        const qint64 high = after.value_or(low + span);
+        const qint64 step = (high - low) / (count + 1);
+
+        if (step > 0) {
+            QList<qint64> positions;
+            positions.reserve(count);
+
+            for (qsizetype i = 1; i <= count; ++i) {
+                positions.append(low + step * i);
+            }
+
+            return positions;
+        }
+
+        // The neighbours are too close, spread the playlist out again with a hole where the entries go
+        if (attempt > 0 || !renumber(playlistId, row, count)) break;
+    }
+
+    qWarning() << "Failed to find room for playlist entries";
+    return {};
+}
+
+bool PlaylistDatabase::renumber(const quint64 playlistId, const qsizetype holeRow, const qsizetype holeSize) const {
+    static const QString statement = QStringLiteral(
+        "UPDATE `PlaylistTracks` "
+        "SET `Position` = (`Ranked`.`Rank` + CASE WHEN `Ranked`.`Rank` > :holeRow THEN :holeSize ELSE 0 END) * :gap "
+        "FROM (SELECT `EntryID`, ROW_NUMBER() OVER (ORDER BY `Position`, `EntryID`) AS `Rank` "
+        "      FROM `PlaylistTracks` WHERE `PlaylistID` = :id) AS `Ranked` "
+        "WHERE `PlaylistTracks`.`EntryID` = `Ranked`.`EntryID`;");
+    const auto query = cachedQuery(statement);
+    query->bindValue(QStringLiteral(":holeRow"), holeRow);
+    query->bindValue(QStringLiteral(":holeSize"), holeSize);
+    query->bindValue(QStringLiteral(":gap"), PositionGap);
+    query->bindValue(QStringLiteral(":id"), playlistId);
+
+    if (!query->exec()) {
+        qWarning() << "Failed to renumber playlist entries: " << query->lastError().text();
         return false;
     }
 
     return true;
 }
 
-bool PlaylistDatabase::reorderPlaylistTracks(const quint64 playlistId, const QList<quint64>& trackIds) const {
-    const QString statement =
-        QStringLiteral("UPDATE `PlaylistTracks` SET `TrackIndex` = :index WHERE `PlaylistID` = :id "
-                       "AND `TrackID` = :trackId;");
-    SqlQuery query{db(), statement};
-    query.bindValue(QStringLiteral(":id"), playlistId);
+bool PlaylistDatabase::insertEntries(const quint64 playlistId, const qsizetype row,
+                                     const QList<quint64>& trackIds) const {
+    const QList<qint64> positions = allocatePositions(playlistId, row, trackIds.size());
+    if (positions.isEmpty()) return false;
+
+    static const QString statement =
+        QStringLiteral("INSERT INTO `PlaylistTracks` (`PlaylistID`, `TrackID`, `Position`) "
+                       "VALUES (:playlistId, :trackId, :position);");
+    const auto query = cachedQuery(statement);
+    query->bindValue(QStringLiteral(":playlistId"), playlistId);
 
-    for (int i = 0; i < trackIds.size(); ++i) {
-        query.bindValue(QStringLiteral(":index"), i);
-        query.bindValue(QStringLiteral(":trackId"), trackIds.at(i));
+    for (qsizetype i = 0; i < trackIds.size(); ++i) {
+        query->bindValue(QStringLiteral(":trackId"), trackIds[i]);
+        query->bindValue(QStringLiteral(":position"), positions[i]);
 
-        if (!query.exec()) {
-            qWarning() << "Failed to reorder playlist tracks: " << query.lastError().text();
+        if (!query->exec()) {
+            qWarning() << "Failed to insert playlist track: " << query->lastError().text()
+                       << "\nLast query: " << query->lastQuery();
             return false;
         }
     }
@@ -344,36 +374,115 @@ bool PlaylistDatabase::reorderPlaylistTracks(const quint64 playlistId, const QLi
     return true;
 }
 
-QList<quint64> PlaylistDatabase::getPlaylistTracks(const quint64 id) const {
-    int count = 0;
+bool PlaylistDatabase::moveEntries(const quint64 playlistId, const qsizetype first, const qsizetype count,
+                                   const qsizetype destination) const {
+    QList<quint64> entryIds;
     {
-        const QString countStatement =
-            QStringLiteral("SELECT COUNT(*) FROM `PlaylistTracks` WHERE `PlaylistID` = :id;");
-        SqlQuery countQuery{db(), countStatement};
-        countQuery.bindValue(QStringLiteral(":id"), id);
-
-        if (countQuery.exec() && countQuery.next()) {
-            count = countQuery.value(0).toInt();
-            if (count == 0) return {};
+        static const QString statement = QStringLiteral(
+            "SELECT `EntryID` FROM `PlaylistTracks` WHERE `PlaylistID` = :id "
+            "ORDER BY `Position`, `EntryID` LIMIT :count OFFSET :first;");
+        const auto query = cachedQuery(statement);
+        query->bindValue(QStringLiteral(":id"), playlistId);
+        query->bindValue(QStringLiteral(":count"), count);
+        query->bindValue(QStringLiteral(":first"), first);
+
+        if (!query->exec()) return false;
+        while (query->next()) {
+            entryIds.append(query->value(0).toULongLong());
         }
     }
 
-    const QString statement =
-        QStringLiteral("SELECT `TrackID` FROM `PlaylistTracks` WHERE `PlaylistID` = :id ORDER BY `TrackIndex` ASC;");
-    SqlQuery query{db(), statement};
-    query.bindValue(QStringLiteral(":id"), id);
+    if (entryIds.size() != count) {
+        qWarning() << "Cannot move playlist entries " << first << " to " << first + count << ", out of range";
+        return false;
+    }
 
-    if (!query.exec()) {
-        qWarning() << "Failed to get playlist tracks: " << query.lastError().text();
-        return {};
+    // The entries around the destination are never among the moved ones
+    const QList<qint64> positions = allocatePositions(playlistId, destination, count);
+    if (positions.isEmpty()) return false;
+
+    static const QString statement =
+        QStringLiteral("UPDATE `PlaylistTracks` SET `Position` = :position WHERE `EntryID` = :entryId;");
+    const auto query = cachedQuery(statement);
+
+    for (qsizetype i = 0; i < count; ++i) {
+        query->bindValue(QStringLiteral(":position"), positions[i]);
+        query->bindValue(QStringLiteral(":entryId"), entryIds[i]);
+
+        if (!query->exec()) {
+            qWarning() << "Failed to move playlist entry: " << query->lastError().text();
+            return false;
+        }
     }
 
-    QList<quint64> tracks;
-    tracks.reserve(count);
+    return true;
+}
 
-    while (query.next()) {
-        tracks.append(query.value(0).toULongLong());
+bool PlaylistDatabase::removeEntries(const quint64 playlistId, const qsizetype first, const qsizetype count) const {
+    static const QString statement = QStringLiteral(
+        "DELETE FROM `PlaylistTracks` WHERE `EntryID` IN "
+        "(SELECT `EntryID` FROM `PlaylistTracks` WHERE `PlaylistID` = :id "
+        " ORDER BY `Position`, `EntryID` LIMIT :count OFFSET :first);");
+    const auto query = cachedQuery(statement);
+    query->bindValue(QStringLiteral(":id"), playlistId);
+    query->bindValue(QStringLiteral(":count"), count);
+    query->bindValue(QStringLiteral(":first"), first);
+
+    if (!query->exec()) {
+        qWarning() << "Failed to remove playlist entries: " << query->lastError().text();
+        return false;
     }
 
-    return tracks;
+    return true;
+}
+
+bool PlaylistDatabase::replaceEntries(const quint64 playlistId, const QList<quint64>& current,
+                                      const QList<quint64>& trackIds) const {
+    // Only the part between the common start and end changes
+    const qsizetype shorter = qMin(current.size(), trackIds.size());
+
+    qsizetype prefix = 0;
+    while (prefix < shorter && current[prefix] == trackIds[prefix]) ++prefix;
+
+    qsizetype suffix = 0;
+    while (suffix < shorter - prefix &&
+           current[current.size() - 1 - suffix] == trackIds[trackIds.size() - 1 - suffix]) {
+        ++suffix;
+    }
+
+    const QList<quint64> removed = current.sliced(prefix, current.size() - prefix - suffix);
+    const QList<quint64> added = trackIds.sliced(prefix, trackIds.size() - prefix - suffix);
+
+    if (removed.isEmpty() && added.isEmpty()) return true;
+
+    // A single track dragged to another place is one moved entry
+    if (removed.size() == added.size() && removed.size() > 1) {
+        const qsizetype last = removed.size() - 1;
+
+        if (removed.first() == added.last() && removed.sliced(1) == added.first(last)) {
+            return moveEntries(playlistId, prefix, 1, prefix + removed.size());
+        }
+        if (removed.last() == added.first() && removed.first(last) == added.sliced(1)) {
+            return moveEntries(playlistId, prefix + last, 1, prefix);
+        }
+    }
+
+    if (!removed.isEmpty() && !removeEntries(playlistId, prefix, removed.size())) return false;
+    if (!added.isEmpty() && !insertEntries(playlistId, prefix, added)) return false;
+
+    return true;
+}
+
+bool PlaylistDatabase::touchPlaylist(const quint64 playlistId) const {
+    static const QString statement =
+        QStringLiteral("UPDATE `Playlists` SET `LastModified` = CURRENT_TIMESTAMP WHERE `PlaylistID` = :id;");
+    const auto query = cachedQuery(statement);
+    query->bindValue(QStringLiteral(":id"), playlistId);
+
+    if (!query->exec()) {
+        qWarning() << "Failed to update playlist last modified date: " << query->lastError().text();
+        return false;
+    }
+
+    return true;
 }
@@ -4,20 +4,59 @@
 #include "database/basedatabase.h"
 #include "metadata.hpp"
 
+#include <optional>
+
+class SqlQuery;
+
 class PlaylistDatabase : public BaseDatabase {
 public:
+    // Room left between neighbouring entries, most inserts and moves fit between two of them without renumbering
+    static constexpr qint64 PositionGap = qint64{1} << 16;
+
+    // Every playlist with its track count and length, newest first, from a single query
+    [[nodiscard]] QList<Metadata::PlaylistHeader> getPlaylistHeaders() const;
     [[nodiscard]] QList<Metadata::PlaylistRecord> getPlaylists() const;
     [[nodiscard]] Metadata::PlaylistRecord getPlaylist(const QString& name) const;
     [[nodiscard]] Metadata::PlaylistRecord getPlaylist(quint64 id) const;
 
     [[nodiscard]] bool savePlaylist(const Metadata::PlaylistRecord& record) const;
     [[nodiscard]] bool updatePlaylist(const Metadata::PlaylistRecord& record) const;
+    // Leaves the entries alone
+    [[nodiscard]] bool renamePlaylist(quint64 id, const QString& name) const;
     [[nodiscard]] bool removePlaylist(quint64 id) const;
 
+    // Edits write only the entries they add or move, rows are indexes into the playlist's current order.
+    // A negative row, or one past the end, appends.
+    [[nodiscard]] bool insertTracks(quint64 playlistId, qsizetype row, const QList<quint64>& trackIds) const;
+    // Moves `count` entries from `first` in front of the entry at `destination`
+    [[nodiscard]] bool moveTracks(quint64 playlistId, qsizetype first, qsizetype count, qsizetype destination) const;
+    [[nodiscard]] bool removeTracks(quint64 playlistId, qsizetype first, qsizetype count) const;
+
     [[nodiscard]] bool addTracksToPlaylist(quint64 playlistId, const QList<quint64>& trackIds) const;
+    // Removes every entry of the track
     [[nodiscard]] bool removeTrackFromPlaylist(quint64 playlistId, quint64 trackId) const;
     [[nodiscard]] bool reorderPlaylistTracks(quint64 playlistId, const QList<quint64>& trackIds) const;
     [[nodiscard]] QList<quint64> getPlaylistTracks(quint64 id) const;
+
+private:
+    [[nodiscard]] Metadata::PlaylistRecord readPlaylist(SqlQuery& query) const;
+
+    // None past the end of the playlist
+    [[nodiscard]] std::optional<qint64> positionAt(quint64 playlistId, qsizetype row) const;
+    [[nodiscard]] std::optional<qint64> lastPosition(quint64 playlistId) const;
+    // Ascending positions for `count` entries in front of `row`, empty if there is no room
+    [[nodiscard]] QList<qint64> allocatePositions(quint64 playlistId, qsizetype row, qsizetype count) const;
+    // Evenly spaces the entries again, leaving room for `holeSize` entries in front of `holeRow`
+    [[nodiscard]] bool renumber(quint64 playlistId, qsizetype holeRow, qsizetype holeSize) const;
+
+    // Without a transaction of their own
+    [[nodiscard]] bool insertEntries(quint64 playlistId, qsizetype row, const QList<quint64>& trackIds) const;
+    [[nodiscard]] bool moveEntries(quint64 playlistId, qsizetype first, qsizetype count, qsizetype destination) const;
+    [[nodiscard]] bool removeEntries(quint64 playlistId, qsizetype first, qsizetype count) const;
+    // Turns `current` into `trackIds` by editing only the range between their common start and end
+    [[nodiscard]] bool replaceEntries(quint64 playlistId, const QList<quint64>& current,
+                                      const QList<quint64>& trackIds) const;
+    [[nodiscard]] bool touchPlaylist(quint64 playlistId) const;
 };
 
 #endif // PLAYLISTDATABASE_H
@@ -1,15 +1,38 @@
 #include "database/sqlquery.h"
 
+#include <QElapsedTimer>
+
+#include <atomic>
+
+namespace {
+
+std::atomic<SqlQuery::TimingHook> timingHook = nullptr;
+
+#ifdef CORPLAYER_SQL_QUERY_TEXT
+QString valueText(const QVariant& value) {
+    return value.isNull() ? QStringLiteral("NULL") : value.toString();
+}
+
+bool isNameChar(const QChar c) {
+    return c.isLetterOrNumber() || c == u'_';
+}
+#endif
+
+} // namespace
+
 SqlQuery::SqlQuery(const QSqlDatabase& db, const QString& statement) : QSqlQuery(db) {
     setForwardOnly(true);
-    prepare(statement);
+    m_prepared = prepare(statement);
 }
 
 void SqlQuery::bindValue(const QString& placeholder, const QVariant& value) {
-    m_boundValues.insert(placeholder, value);
     QSqlQuery::bindValue(placeholder, value);
 }
 
+void SqlQuery::bindValue(const int position, const QVariant& value) {
+    QSqlQuery::bindValue(position, value);
+}
+
 void SqlQuery::bindStringValue(const QString& placeholder, const QString& value) {
     bindValue(placeholder, value.isNull() ? QLatin1String("") : value);
 }
@@ -19,20 +42,67 @@ void SqlQuery::bindBoolValue(const QString& placeholder, const bool value) {
 }
 
 bool SqlQuery::exec() {
+    const TimingHook hook = timingHook.load(std::memory_order_relaxed);
+    if (hook == nullptr) return QSqlQuery::exec();
+
+    QElapsedTimer timer;
+    timer.start();
     const bool success = QSqlQuery::exec();
-    m_lastQuery = executedQuery();
+    hook(*this, timer.nsecsElapsed(), success);
 
-    const QList<QString> keys = m_boundValues.keys();
+    return success;
+}
 
-    for (const QString& key : keys) {
-        m_lastQuery.replace(key, m_boundValues.value(key).toString());
-    }
+bool SqlQuery::isPrepared() const {
+    return m_prepared;
+}
+
+QString SqlQuery::lastQuery() const {
+    const QString statement = executedQuery();
 
-    m_boundValues.clear();
+#ifdef CORPLAYER_SQL_QUERY_TEXT
+    // The values are still held by the query, nothing is recorded while binding
+    const QStringList names = boundValueNames();
+    const QVariantList values = boundValues();
 
-    return success;
+    QString text;
+    text.reserve(statement.size());
+
+    qsizetype position = 0;
+    bool quoted = false;
+
+    for (qsizetype i = 0; i < statement.size(); ++i) {
+        const QChar c = statement[i];
+
+        if (c == u'\'') quoted = !quoted;
+
+        if (!quoted && c == u'?' && position < values.size()) {
+            text += valueText(values[position++]);
+            continue;
+        }
+
+        if (!quoted && c == u':' && i + 1 < statement.size() && isNameChar(statement[i + 1])) {
+            qsizetype end = i + 1;
+            while (end < statement.size() && isNameChar(statement[end])) ++end;
+
+            // Matched whole, so `:track` never replaces the start of `:trackId`
+            const qsizetype index = names.indexOf(QStringView{statement}.sliced(i, end - i));
+            if (index >= 0 && index < values.size()) {
+                text += valueText(values[index]);
+                i = end - 1;
+                continue;
+            }
+        }
+
+        text += c;
+    }
+
+    return text;
+#else
+    return statement;
+#endif
 }
 
-QString SqlQuery::lastQuery() const {
-    return m_lastQuery;
+void SqlQuery::setTimingHook(const TimingHook hook) {
+    timingHook.store(hook, std::memory_order_relaxed);
 }
@@ -5,18 +5,27 @@
 
 class SqlQuery : public QSqlQuery {
 public:
+    // Called after every execution while set, with the time the statement took
+    using TimingHook = void (*)(const SqlQuery& query, qint64 nanoseconds, bool success);
+
     explicit SqlQuery(const QSqlDatabase& db, const QString& statement);
 
     void bindValue(const QString& placeholder, const QVariant& value);
+    // For `?` placeholders
+    void bindValue(int position, const QVariant& value);
     void bindStringValue(const QString& placeholder, const QString& value);
     void bindBoolValue(const QString& placeholder, bool value);
 
     [[nodiscard]] bool exec();
+    [[nodiscard]] bool isPrepared() const;
+    // The executed statement with its bound values filled in, built only when asked for.
+    // Without SQL_QUERY_TEXT the placeholders are left as they are.
     [[nodiscard]] QString lastQuery() const;
 
+    static void setTimingHook(TimingHook hook);
+
 private:
-    QString m_lastQuery;
-    QMap<QString, QVariant> m_boundValues;
+    bool m_prepared = false;
 };
 
 #endif // SQLQUERY_H
@@ -3,7 +3,9 @@
 #include <QDebug>
 #include <QSqlDatabase>
 
-SqlTransaction::SqlTransaction(const QSqlDatabase& db) : m_db(db) {
+#include <utility>
+
+SqlTransaction::SqlTransaction(DbConnectionPool::WriteLease writer) : m_writer(std::move(writer)), m_db(m_writer.db()) {
     m_db.transaction();
 }
 
@@ -31,3 +33,7 @@ bool SqlTransaction::commit() {
     m_commited = true;
     return true;
 }
+
+const DbConnectionPool::WriteLease& SqlTransaction::connection() const {
+    return m_writer;
+}
@@ -1,18 +1,25 @@
 #ifndef SQLTRANSACTION_H
 #define SQLTRANSACTION_H
 
+#include "database/dbconnectionpool.h"
+
 #include <QSqlDatabase>
 
+// Holds the pool's writer lock until it is committed or rolled back, so transactions never wait on each other
+// inside SQLite
 class SqlTransaction {
 public:
-    explicit SqlTransaction(const QSqlDatabase& db);
+    explicit SqlTransaction(DbConnectionPool::WriteLease writer);
     ~SqlTransaction();
     [[nodiscard]] bool commit();
+    // The connection the transaction runs on, for statements that are prepared once and run for every row
+    [[nodiscard]] const DbConnectionPool::WriteLease& connection() const;
 
     SqlTransaction(const SqlTransaction& other) = delete;
     SqlTransaction& operator=(const SqlTransaction& other) = delete;
 
 private:
+    DbConnectionPool::WriteLease m_writer;
     QSqlDatabase m_db;
     bool m_commited{false};
 };
@@ -0,0 +1,75 @@
+#include "database/statementcache.h"
+
+#include <utility>
+
+StatementCache::Lease::Lease(StatementCache* cache, QString statement, std::unique_ptr<SqlQuery> query)
+    : m_cache(cache), m_statement(std::move(statement)), m_query(std::move(query)) {}
+
+StatementCache::Lease::~Lease() {
+    if (m_query == nullptr) return;
+
+    if (m_cache != nullptr) {
+        m_cache->release(m_statement, std::move(m_query));
+    }
+}
+
+StatementCache::Lease::Lease(Lease&& other) noexcept
+    : m_cache(std::exchange(other.m_cache, nullptr)), m_statement(std::move(other.m_statement)),
+      m_query(std::move(other.m_query)) {}
+
+SqlQuery& StatementCache::Lease::operator*() const {
+    return *m_query;
+}
+
+SqlQuery* StatementCache::Lease::operator->() const {
+    return m_query.get();
+}
+
+StatementCache::~StatementCache() {
+    clear();
+}
+
+StatementCache::Lease StatementCache::acquire(const QSqlDatabase& db, const QString& statement) {
+    ++m_leased;
+
+    if (const auto it = m_idle.find(statement); it != m_idle.end() && !it->second.empty()) {
+        std::unique_ptr<SqlQuery> query = std::move(it->second.back());
+        it->second.pop_back();
+        return {this, statement, std::move(query)};
+    }
+
+    return {this, statement, std::make_unique<SqlQuery>(db, statement)};
+}
+
+void StatementCache::clear() {
+    m_idle.clear();
+}
+
+qsizetype StatementCache::size() const {
+    return static_cast<qsizetype>(m_idle.size());
+}
+
+bool StatementCache::hasLeases() const {
+    return m_leased > 0;
+}
+
+void StatementCache::release(const QString& statement, std::unique_ptr<SqlQuery> query) {
+    --m_leased;
+
+    // Statements that failed to prepare are not worth keeping
+    if (!query->isPrepared()) return;
+
+    // Leaves the statement reset with its locks released, the next user only binds and executes it
+    query->finish();
+
+    auto it = m_idle.find(statement);
+    if (it == m_idle.end()) {
+        // Built statements (IN lists and the like) would otherwise fill the cache with one-off entries
+        if (size() >= maxStatements) return;
+        it = m_idle.try_emplace(statement).first;
+    }
+
+    if (it->second.size() < maxIdlePerStatement) {
+        it->second.push_back(std::move(query));
+    }
+}
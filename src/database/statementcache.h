@@ -0,0 +1,59 @@
+#ifndef STATEMENTCACHE_H
+#define STATEMENTCACHE_H
+
+#include "database/sqlquery.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Prepared statements of one connection, keyed by their text. A statement is parsed and planned the first time
+// it is used, later users get the same statement back, reset and ready to be bound again.
+class StatementCache {
+public:
+    // Hands the statement back to the cache when it goes out of scope
+    class Lease {
+    public:
+        Lease(StatementCache* cache, QString statement, std::unique_ptr<SqlQuery> query);
+        ~Lease();
+
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) = delete;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        [[nodiscard]] SqlQuery& operator*() const;
+        [[nodiscard]] SqlQuery* operator->() const;
+
+    private:
+        StatementCache* m_cache;
+        QString m_statement;
+        std::unique_ptr<SqlQuery> m_query;
+    };
+
+    StatementCache() = default;
+    ~StatementCache();
+
+    StatementCache(const StatementCache&) = delete;
+    StatementCache& operator=(const StatementCache&) = delete;
+
+    // A statement that is already leased out is prepared once more, so nested users never share one
+    [[nodiscard]] Lease acquire(const QSqlDatabase& db, const QString& statement);
+    // Must run before the connection is closed
+    void clear();
+
+    [[nodiscard]] qsizetype size() const;
+    // Statements handed out and not returned yet, the connection has to stay open while there are any
+    [[nodiscard]] bool hasLeases() const;
+
+private:
+    void release(const QString& statement, std::unique_ptr<SqlQuery> query);
+
+    static constexpr qsizetype maxStatements = 64;
+    static constexpr std::size_t maxIdlePerStatement = 2;
+
+    std::unordered_map<QString, std::vector<std::unique_ptr<SqlQuery>>> m_idle;
+    qsizetype m_leased = 0;
+};
+
+#endif // STATEMENTCACHE_H
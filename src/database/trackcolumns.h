@@ -0,0 +1,137 @@
+#ifndef TRACKCOLUMNS_H
+#define TRACKCOLUMNS_H
+
+#include "metadata.hpp"
+
+#include <QStringList>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+// The one place that maps track fields to database columns. Statements, bind positions and the order
+// rows are read back in are all generated from these tables, so they cannot drift apart.
+namespace TrackColumns {
+
+enum class Type : std::uint8_t {
+    Value,     // bound and read as the field's own variant
+    Url,       // the URL as a string, how files are identified
+    TimeMs,    // a QTime stored as milliseconds
+    Hash,      // an unsigned 64-bit hash stored in a signed INTEGER
+    Reference, // the id of an artist, album or genre row, resolved from the field's name
+};
+
+struct Column {
+    std::string_view name;
+    Metadata::Fields field;
+    Type type;
+};
+
+using enum Metadata::Fields;
+
+// Written by insert and update, in bind order. `DateAdded` is left to its default.
+inline constexpr std::array stored{
+    Column{std::string_view("FileName"), ResourceUrl, Type::Url},
+    Column{std::string_view("Title"), Title, Type::Value},
+    Column{std::string_view("ArtistID"), Artist, Type::Reference},
+    Column{std::string_view("AlbumID"), Album, Type::Reference},
+    Column{std::string_view("AlbumArtistID"), AlbumArtist, Type::Reference},
+    Column{std::string_view("TrackNumber"), TrackNumber, Type::Value},
+    Column{std::string_view("DiscNumber"), DiscNumber, Type::Value},
+    Column{std::string_view("Duration"), Duration, Type::TimeMs},
+    Column{std::string_view("GenreID"), Genre, Type::Reference},
+    Column{std::string_view("Performer"), Performer, Type::Value},
+    Column{std::string_view("Composer"), Composer, Type::Value},
+    Column{std::string_view("Lyricist"), Lyricist, Type::Value},
+    Column{std::string_view("Year"), Year, Type::Value},
+    Column{std::string_view("Channels"), Channels, Type::Value},
+    Column{std::string_view("Bitrate"), BitRate, Type::Value},
+    Column{std::string_view("SampleRate"), SampleRate, Type::Value},
+    Column{std::string_view("HasEmbeddedCover"), HasEmbeddedCover, Type::Value},
+    Column{std::string_view("FileSize"), FileSize, Type::Value},
+    Column{std::string_view("FileModified"), FileModified, Type::Value},
+    Column{std::string_view("FileInode"), FileInode, Type::Value},
+    Column{std::string_view("TrackHash"), Hash, Type::Hash},
+    Column{std::string_view("ContentHash"), ContentHash, Type::Hash},
+};
+
+// Read from TrackView, which resolves the references back to names. `TrackID` comes first, before these.
+inline constexpr std::array selected{
+    Column{std::string_view("FileName"), ResourceUrl, Type::Url},
+    Column{std::string_view("Title"), Title, Type::Value},
+    Column{std::string_view("ArtistName"), Artist, Type::Value},
+    Column{std::string_view("AlbumTitle"), Album, Type::Value},
+    Column{std::string_view("AlbumArtistName"), AlbumArtist, Type::Value},
+    Column{std::string_view("TrackNumber"), TrackNumber, Type::Value},
+    Column{std::string_view("DiscNumber"), DiscNumber, Type::Value},
+    Column{std::string_view("Duration"), Duration, Type::TimeMs},
+    Column{std::string_view("Genre"), Genre, Type::Value},
+    Column{std::string_view("Performer"), Performer, Type::Value},
+    Column{std::string_view("Composer"), Composer, Type::Value},
+    Column{std::string_view("Lyricist"), Lyricist, Type::Value},
+    Column{std::string_view("Year"), Year, Type::Value},
+    Column{std::string_view("Channels"), Channels, Type::Value},
+    Column{std::string_view("Bitrate"), BitRate, Type::Value},
+    Column{std::string_view("SampleRate"), SampleRate, Type::Value},
+    Column{std::string_view("HasEmbeddedCover"), HasEmbeddedCover, Type::Value},
+    Column{std::string_view("FileSize"), FileSize, Type::Value},
+    Column{std::string_view("FileModified"), FileModified, Type::Value},
+    Column{std::string_view("FileInode"), FileInode, Type::Value},
+    Column{std::string_view("TrackHash"), Hash, Type::Hash},
+    Column{std::string_view("DateAdded"), DateAdded, Type::Value},
+    Column{std::string_view("AlbumID"), AlbumId, Type::Value},
+    Column{std::string_view("ContentHash"), ContentHash, Type::Hash},
+};
+
+template <std::size_t N>
+constexpr bool hasUniqueFields(const std::array<Column, N>& columns) {
+    for (std::size_t i = 0; i < N; ++i) {
+        for (std::size_t j = i + 1; j < N; ++j) {
+            if (columns[i].field == columns[j].field || columns[i].name == columns[j].name) return false;
+        }
+    }
+    return true;
+}
+
+// Everything that is written has to come back when the track is read
+template <std::size_t N, std::size_t M>
+constexpr bool readsBack(const std::array<Column, N>& written, const std::array<Column, M>& read) {
+    return std::ranges::all_of(written, [&read](const Column& column) {
+        return std::ranges::any_of(read, [&column](const Column& other) {
+            return other.field == column.field;
+        });
+    });
+}
+
+static_assert(hasUniqueFields(stored));
+static_assert(hasUniqueFields(selected));
+static_assert(readsBack(stored, selected));
+
+inline QString quoted(const Column& column) {
+    return QLatin1Char('`') + QLatin1StringView{column.name.data(), static_cast<qsizetype>(column.name.size())} +
+           QLatin1Char('`');
+}
+
+// Joins `format` filled in with each quoted column name
+template <std::size_t N>
+QString join(const std::array<Column, N>& columns, const QString& format = QStringLiteral("%1")) {
+    QStringList parts;
+    parts.reserve(static_cast<qsizetype>(N));
+
+    for (const Column& column : columns) {
+        parts.append(format.arg(quoted(column)));
+    }
+
+    return parts.join(QLatin1StringView(", "));
+}
+
+// One positional placeholder per column
+template <std::size_t N>
+QString placeholders(const std::array<Column, N>& /*columns*/) {
+    return QStringList(static_cast<qsizetype>(N), QStringLiteral("?")).join(QLatin1StringView(", "));
+}
+
+} // namespace TrackColumns
+
+#endif // TRACKCOLUMNS_H
@@ -2,85 +2,266 @@
 
 #include "database/sqlquery.h"
 #include "database/sqltransaction.h"
+#include "database/trackcolumns.h"
 
+#include <QSet>
 #include <QSqlError>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <utility>
 
 namespace {
 
-QString getTrackColumns() {
-    static const QString columns = QStringLiteral(
-        "`FileName`, `Title`, `ArtistName`, `AlbumTitle`, `AlbumArtistName`, `TrackNumber`, "
-        "`DiscNumber`, `Duration`, `Genre`, `Performer`, `Composer`, `Lyricist`, `Year`, `Channels`, `Bitrate`, "
-        "`SampleRate`, `HasEmbeddedCover`, `TrackHash`, `DateAdded`");
+struct NameIds {
+    quint64 artistId = 0;
+    quint64 albumId = 0;
+    quint64 albumArtistId = 0;
+    quint64 genreId = 0;
+
+    [[nodiscard]] quint64 id(const Metadata::Fields field) const {
+        switch (field) {
+        case Metadata::Fields::Artist:
+            return artistId;
+        case Metadata::Fields::Album:
+            return albumId;
+        case Metadata::Fields::AlbumArtist:
+            return albumArtistId;
+        case Metadata::Fields::Genre:
+            return genreId;
+        default:
+            return 0;
+        }
+    }
+};
+
+// Unknown names are stored as NULL
+QVariant idValue(const quint64 id) {
+    return id != 0 ? QVariant{id} : QVariant{};
+}
 
+// SQLite integers are signed, the hash keeps its bits
+QVariant hashValue(const Metadata::TrackFields& track, const Metadata::Fields field) {
+    return track.contains(field) ? QVariant{static_cast<qint64>(track.get(field).toULongLong())} : QVariant{};
+}
+
+QString selectColumns() {
+    static const QString columns = QStringLiteral("`TrackID`, ") + TrackColumns::join(TrackColumns::selected);
     return columns;
 }
 
-QString getTrackColumnBinds() {
-    static const QString values = QStringLiteral(
-        ":fileName, :title, :artist, :album, :albumArtist, :trackNumber, :discNumber, :duration, :genre, "
-        ":performer, :composer, :lyricist, :year, :channels, :bitRate, :sampleRate, :hasEmbeddedCover, :trackHash");
+constexpr int StoredColumnCount = static_cast<int>(TrackColumns::stored.size());
+
+// SQLITE_MAX_VARIABLE_NUMBER since 3.32, RETURNING needs 3.35 anyway. Inserts use power of two row counts,
+// so a batch of any size prepares at most a dozen distinct statements.
+constexpr std::size_t MaxInsertRows = std::bit_floor(std::size_t{32766} / TrackColumns::stored.size());
 
-    return values;
+qsizetype insertRowCount(const qsizetype remaining) {
+    return static_cast<qsizetype>(std::bit_floor(std::min(static_cast<std::size_t>(remaining), MaxInsertRows)));
 }
 
-Metadata::TrackFields insertTrackMetadata(const SqlQuery& query) {
-    Metadata::TrackFields track;
+// Rows that would break a unique constraint are skipped, only the inserted ones are returned
+const QString& insertStatement(const qsizetype rows) {
+    static const auto statements = [] {
+        std::array<QString, std::bit_width(MaxInsertRows)> result;
+        const QString row = QLatin1Char('(') + TrackColumns::placeholders(TrackColumns::stored) + QLatin1Char(')');
+
+        for (std::size_t i = 0; i < result.size(); ++i) {
+            const QStringList values(static_cast<qsizetype>(std::size_t{1} << i), row);
+            result[i] = QStringLiteral("INSERT INTO `Tracks` (%1) VALUES %2 ON CONFLICT DO NOTHING "
+                                       "RETURNING `TrackID`, `FileName`;")
+                            .arg(TrackColumns::join(TrackColumns::stored), values.join(QLatin1StringView(", ")));
+        }
+
+        return result;
+    }();
 
-    using enum Metadata::Fields;
-    track.insert(DatabaseId, query.value(0));
-    track.insert(ResourceUrl, query.value(1));
-    track.insert(Title, query.value(2));
-    track.insert(Artist, query.value(3));
-    track.insert(Album, query.value(4));
-    track.insert(AlbumArtist, query.value(5));
-    track.insert(TrackNumber, query.value(6));
-    track.insert(DiscNumber, query.value(7));
-    track.insert(Duration, query.value(8));
-    track.insert(Genre, query.value(9));
-    track.insert(Performer, query.value(10));
-    track.insert(Composer, query.value(11));
-    track.insert(Lyricist, query.value(12));
-    track.insert(Year, query.value(13));
-    track.insert(Channels, query.value(14));
-    track.insert(BitRate, query.value(15));
-    track.insert(SampleRate, query.value(16));
-    track.insert(HasEmbeddedCover, query.value(17));
-    track.insert(CoverImage,
-                 QVariant{"image://cover/" +
-                          query.value(1).toUrl().toLocalFile()}); // TODO: handle this better when introducing caching
-    track.insert(Hash, query.value(18));
-    track.insert(DateAdded, query.value(19));
+    return statements[static_cast<std::size_t>(std::countr_zero(static_cast<std::size_t>(rows)))];
+}
 
-    return track;
+// The id follows the stored columns
+const QString& updateStatement() {
+    static const QString statement = QStringLiteral("UPDATE `Tracks` SET %1 WHERE `TrackID` = ?;")
+                                         .arg(TrackColumns::join(TrackColumns::stored, QStringLiteral("%1 = ?")));
+    return statement;
+}
+
+const QString& deleteStatement() {
+    static const QString statement = QStringLiteral("DELETE FROM `Tracks` WHERE `TrackID` = :trackId;");
+    return statement;
+}
+
+// Binds every stored column by position, starting at `position`
+void bindTrack(SqlQuery& query, int position, const Metadata::TrackFields& track, const NameIds& ids) {
+    using TrackColumns::Type;
+
+    for (const TrackColumns::Column& column : TrackColumns::stored) {
+        QVariant value;
+
+        switch (column.type) {
+        case Type::Url:
+            value = track.get(column.field).toUrl().toString();
+            break;
+        case Type::TimeMs: {
+            // The column cannot be NULL, an unknown duration is stored as 0
+            const QTime time = track.get(column.field).toTime();
+            value = time.isValid() ? time.msecsSinceStartOfDay() : 0;
+            break;
+        }
+        case Type::Hash:
+            value = hashValue(track, column.field);
+            break;
+        case Type::Reference:
+            value = idValue(ids.id(column.field));
+            break;
+        case Type::Value:
+        default:
+            value = track.get(column.field);
+            break;
+        }
+
+        query.bindValue(position++, value);
+    }
 }
 
-std::map<QString, QVariant> getTrackBindings(const Metadata::TrackFields& track) {
-    using enum Metadata::Fields;
-    return {{QStringLiteral(":fileName"), track.get(ResourceUrl)},
-            {QStringLiteral(":title"), track.get(Title)},
-            {QStringLiteral(":artist"), track.get(Artist)},
-            {QStringLiteral(":album"), track.get(Album)},
-            {QStringLiteral(":albumArtist"), track.get(AlbumArtist)},
-            {QStringLiteral(":trackNumber"), track.get(TrackNumber)},
-            {QStringLiteral(":discNumber"), track.get(DiscNumber)},
-            {QStringLiteral(":duration"), track.get(Duration)},
-            {QStringLiteral(":genre"), track.get(Genre)},
-            {QStringLiteral(":performer"), track.get(Performer)},
-            {QStringLiteral(":composer"), track.get(Composer)},
-            {QStringLiteral(":lyricist"), track.get(Lyricist)},
-            {QStringLiteral(":year"), track.get(Year)},
-            {QStringLiteral(":channels"), track.get(Channels)},
-            {QStringLiteral(":bitRate"), track.get(BitRate)},
-            {QStringLiteral(":sampleRate"), track.get(SampleRate)},
-            {QStringLiteral(":hasEmbeddedCover"), track.get(HasEmbeddedCover)},
-            {QStringLiteral(":trackHash"), track.get(Hash)}};
+// Reads a row selected with `selectColumns()`
+Metadata::TrackFields readTrack(const SqlQuery& query) {
+    using TrackColumns::Type;
+
+    Metadata::TrackFields track;
+    track.insert(Metadata::Fields::DatabaseId, query.value(0));
+
+    int position = 1;
+    for (const TrackColumns::Column& column : TrackColumns::selected) {
+        const QVariant value = query.value(position++);
+
+        if (column.type == Type::TimeMs) {
+            if (value.toInt() > 0) {
+                track.insert(column.field, QTime::fromMSecsSinceStartOfDay(value.toInt()));
+            }
+        } else {
+            track.insert(column.field, value);
+        }
+    }
+
+    return track;
 }
 
 } // namespace
 
+// Resolves artist, album and genre names to their row ids and adds the missing ones.
+// Lives for one transaction, so every name of a batch is looked up in the database only once,
+// with statements prepared on the transaction's connection.
+class TrackDatabase::NameCache {
+public:
+    explicit NameCache(const DbConnectionPool::Lease& connection)
+        : m_selectArtist(
+              connection.statement(QStringLiteral("SELECT `ArtistID` FROM `Artists` WHERE `Name` = :name;"))),
+          m_insertArtist(connection.statement(QStringLiteral("INSERT INTO `Artists` (`Name`) VALUES (:name);"))),
+          m_selectGenre(connection.statement(QStringLiteral("SELECT `GenreID` FROM `Genres` WHERE `Name` = :name;"))),
+          m_insertGenre(connection.statement(QStringLiteral("INSERT INTO `Genres` (`Name`) VALUES (:name);"))),
+          m_selectAlbum(connection.statement(
+              QStringLiteral("SELECT `AlbumID` FROM `Albums` WHERE `Title` = :title AND `ArtistID` IS :artistId;"))),
+          m_insertAlbum(connection.statement(
+              QStringLiteral("INSERT INTO `Albums` (`Title`, `ArtistID`) VALUES (:title, :artistId);"))) {}
+
+    [[nodiscard]] NameIds resolve(const Metadata::TrackFields& track) {
+        NameIds ids;
+
+        ids.artistId = nameId(m_artists, *m_selectArtist, *m_insertArtist, track.artist(), m_added.artistIds);
+        ids.albumArtistId =
+            nameId(m_artists, *m_selectArtist, *m_insertArtist, track.albumArtist(), m_added.artistIds);
+        ids.genreId = nameId(m_genres, *m_selectGenre, *m_insertGenre, track.genre(), m_added.genreIds);
+
+        // An album belongs to its album artist, or to the track artist when the tags do not name one
+        ids.albumId = albumId(track.album(), ids.albumArtistId != 0 ? ids.albumArtistId : ids.artistId);
+
+        return ids;
+    }
+
+    // Names that were not stored before this cache added them
+    [[nodiscard]] const NameRefs& added() const {
+        return m_added;
+    }
+
+private:
+    static quint64 nameId(QHash<QString, quint64>& cache, SqlQuery& select, SqlQuery& insert, const QString& name,
+                          QSet<quint64>& added) {
+        if (name.isEmpty()) return 0;
+        if (const auto it = cache.constFind(name); it != cache.cend()) return it.value();
+
+        quint64 id = 0;
+
+        select.bindValue(QStringLiteral(":name"), name);
+        if (select.exec() && select.next()) {
+            id = select.value(0).toULongLong();
+        }
+        select.finish();
+
+        if (id == 0) {
+            insert.bindValue(QStringLiteral(":name"), name);
+            if (!insert.exec()) {
+                qWarning() << "Failed to insert name: " << insert.lastError().text() << "\nLast query: "
+                           << insert.lastQuery();
+                return 0;
+            }
+            id = insert.lastInsertId().toULongLong();
+            added.insert(id);
+        }
+
+        cache.insert(name, id);
+        return id;
+    }
+
+    quint64 albumId(const QString& title, const quint64 artistId) {
+        if (title.isEmpty()) return 0;
+
+        const auto key = std::make_pair(title, artistId);
+        if (const auto it = m_albums.constFind(key); it != m_albums.cend()) return it.value();
+
+        quint64 id = 0;
+
+        m_selectAlbum->bindValue(QStringLiteral(":title"), title);
+        m_selectAlbum->bindValue(QStringLiteral(":artistId"), idValue(artistId));
+        if (m_selectAlbum->exec() && m_selectAlbum->next()) {
+            id = m_selectAlbum->value(0).toULongLong();
+        }
+        m_selectAlbum->finish();
+
+        if (id == 0) {
+            m_insertAlbum->bindValue(QStringLiteral(":title"), title);
+            m_insertAlbum->bindValue(QStringLiteral(":artistId"), idValue(artistId));
+            if (!m_insertAlbum->exec()) {
+                qWarning() << "Failed to insert album: " << m_insertAlbum->lastError().text() << "\nLast query: "
+                           << m_insertAlbum->lastQuery();
+                return 0;
+            }
+            id = m_insertAlbum->lastInsertId().toULongLong();
+            m_added.albumIds.insert(id);
+        }
+
+        m_albums.insert(key, id);
+        return id;
+    }
+
+    StatementCache::Lease m_selectArtist;
+    StatementCache::Lease m_insertArtist;
+    StatementCache::Lease m_selectGenre;
+    StatementCache::Lease m_insertGenre;
+    StatementCache::Lease m_selectAlbum;
+    StatementCache::Lease m_insertAlbum;
+
+    QHash<QString, quint64> m_artists;
+    QHash<QString, quint64> m_genres;
+    QHash<std::pair<QString, quint64>, quint64> m_albums;
+    NameRefs m_added;
+};
+
 TrackDatabase::TrackFieldsList TrackDatabase::getTracks() const {
-    const auto db = this->db();
+    const auto reader = readLease();
+    const auto db = reader.db();
 
     int count = 0;
     {
@@ -92,7 +273,7 @@ TrackDatabase::TrackFieldsList TrackDatabase::getTracks() const {
         }
     }
 
-    const QString statement = QStringLiteral("SELECT `TrackID`, %1 FROM Tracks;").arg(getTrackColumns());
+    const QString statement = QStringLiteral("SELECT %1 FROM `TrackView`;").arg(selectColumns());
     SqlQuery query{db, statement};
 
     if (!query.exec()) return {};
@@ -101,24 +282,63 @@ TrackDatabase::TrackFieldsList TrackDatabase::getTracks() const {
     tracks.reserve(count);
 
     while (query.next()) {
-        tracks.append(insertTrackMetadata(query));
+        tracks.append(readTrack(query));
     }
 
     return tracks;
 }
 
 // Returning true does not mean that all tracks were inserted successfully
-bool TrackDatabase::insertTracks(TrackFieldsList& tracks) const {
+bool TrackDatabase::insertTracks(TrackFieldsList& tracks, QList<QUrl>* conflicts) const {
     if (tracks.isEmpty()) return true;
 
-    SqlTransaction transaction{db()};
+    SqlTransaction transaction{writeLease()};
+    NameCache names{transaction.connection()};
+
+    QList<Metadata::TrackFields*> pending;
+    pending.reserve(tracks.size());
 
     for (auto& track : tracks) {
         if (!track.contains(Metadata::Fields::DatabaseId)) {
-            insertTrack(track);
+            pending.append(&track);
+        }
+    }
+
+    QSet<const Metadata::TrackFields*> failed;
+    const std::span<Metadata::TrackFields* const> all{pending.constData(), static_cast<std::size_t>(pending.size())};
+
+    for (std::size_t first = 0; first < all.size();) {
+        const auto rows = static_cast<std::size_t>(insertRowCount(static_cast<qsizetype>(all.size() - first)));
+        const auto chunk = all.subspan(first, rows);
+
+        // A row that fails a NOT NULL constraint fails its whole statement, the others are retried alone
+        if (!insertRows(transaction.connection(), chunk, names)) {
+            for (std::size_t i = 0; i < rows; ++i) {
+                if (rows == 1 || !insertRows(transaction.connection(), chunk.subspan(i, 1), names)) {
+                    failed.insert(chunk[i]);
+                }
+            }
+        }
+
+        first += rows;
+    }
+
+    bool skipped = !failed.isEmpty();
+
+    for (const Metadata::TrackFields* track : std::as_const(pending)) {
+        if (!track->contains(Metadata::Fields::DatabaseId) && !failed.contains(track)) {
+            skipped = true;
+            if (conflicts != nullptr) {
+                conflicts->append(track->get(Metadata::Fields::ResourceUrl).toUrl());
+            }
         }
     }
 
+    // Names were added for every row before it was written, the ones only skipped rows used go again
+    if (skipped) {
+        pruneNames(names.added());
+    }
+
     return transaction.commit();
 }
 
@@ -127,25 +347,28 @@ bool TrackDatabase::updateTracks(TrackFieldsList& tracks) const {
         return true;
     }
 
-    SqlTransaction transaction{db()};
+    SqlTransaction transaction{writeLease()};
+    NameCache names{transaction.connection()};
+    const auto query = transaction.connection().statement(updateStatement());
+    // Retagging can leave the old names without tracks
+    NameRefs oldNames;
 
     for (auto& track : tracks) {
         if (track.contains(Metadata::Fields::DatabaseId)) {
-            if (!updateTrack(track)) {
+            collectNames(track.get(Metadata::Fields::DatabaseId).toULongLong(), oldNames);
+            if (!updateTrack(*query, track, names)) {
                 qWarning() << "Failed to update track: " << track.get(Metadata::Fields::Title).toString();
             }
         }
     }
 
+    pruneNames(oldNames);
+
     return transaction.commit();
 }
 
 bool TrackDatabase::deleteTrack(const quint64 trackId) const {
-    const QString statement = QStringLiteral("DELETE FROM `Tracks` WHERE `TrackID` = :trackId;");
-    SqlQuery query{db(), statement};
-    query.bindValue(QStringLiteral(":trackId"), trackId);
-
-    return query.exec();
+    return deleteTracks(QList{trackId});
 }
 
 bool TrackDatabase::deleteTracks(TrackFieldsList& tracks) const {
@@ -153,25 +376,134 @@ bool TrackDatabase::deleteTracks(TrackFieldsList& tracks) const {
         return true;
     }
 
-    SqlTransaction transaction{db()};
+    SqlTransaction transaction{writeLease()};
+    const auto query = transaction.connection().statement(deleteStatement());
+    NameRefs oldNames;
 
     int deletedCount = 0;
 
     for (const auto& track : tracks) {
-        if (track.contains(Metadata::Fields::DatabaseId) &&
-            deleteTrack(track.get(Metadata::Fields::DatabaseId).toULongLong())) {
+        if (!track.contains(Metadata::Fields::DatabaseId)) continue;
+
+        const quint64 trackId = track.get(Metadata::Fields::DatabaseId).toULongLong();
+        collectNames(trackId, oldNames);
+
+        query->bindValue(QStringLiteral(":trackId"), trackId);
+        if (query->exec()) {
             ++deletedCount;
         }
     }
 
+    pruneNames(oldNames);
+
     return transaction.commit() && deletedCount == tracks.size();
 }
 
+bool TrackDatabase::deleteTracks(const QList<quint64>& trackIds) const {
+    if (trackIds.isEmpty()) {
+        return true;
+    }
+
+    SqlTransaction transaction{writeLease()};
+    const auto query = transaction.connection().statement(deleteStatement());
+    NameRefs oldNames;
+
+    int deletedCount = 0;
+
+    for (const quint64 trackId : trackIds) {
+        collectNames(trackId, oldNames);
+
+        query->bindValue(QStringLiteral(":trackId"), trackId);
+        if (query->exec()) {
+            ++deletedCount;
+        }
+    }
+
+    pruneNames(oldNames);
+
+    return transaction.commit() && deletedCount == trackIds.size();
+}
+
+QList<TrackDatabase::TrackFingerprint> TrackDatabase::fetchFingerprints() const {
+    const auto reader = readLease();
+    const QString statement =
+        QStringLiteral("SELECT `TrackID`, `FileName`, `FileSize`, `FileModified`, `FileInode` FROM `Tracks`;");
+    SqlQuery query{db(), statement};
+
+    if (!query.exec()) {
+        qWarning() << "Failed to fetch track fingerprints: " << query.lastError().text();
+        return {};
+    }
+
+    QList<TrackFingerprint> result;
+
+    while (query.next()) {
+        // Rows written before fingerprints existed have NULL columns and will never match a file on disk
+        result.append({.trackId = query.value(0).toULongLong(),
+                       .url = QUrl{query.value(1).toString()},
+                       .fingerprint = {.size = query.value(2).isNull() ? -1 : query.value(2).toLongLong(),
+                                       .modifiedNs = query.value(3).toLongLong(),
+                                       .inode = query.value(4).toULongLong()}});
+    }
+
+    return result;
+}
+
+QList<QList<quint64>> TrackDatabase::fetchDuplicateTrackIds() const {
+    const auto reader = readLease();
+    const QString statement = QStringLiteral(
+        "SELECT `ContentHash`, `TrackID` FROM `Tracks` WHERE `ContentHash` IN ("
+        "   SELECT `ContentHash` FROM `Tracks` WHERE `ContentHash` IS NOT NULL "
+        "   GROUP BY `ContentHash` HAVING COUNT(*) > 1) "
+        "ORDER BY `ContentHash`, `TrackID`;");
+    SqlQuery query{db(), statement};
+
+    if (!query.exec()) {
+        qWarning() << "Failed to fetch duplicate tracks: " << query.lastError().text();
+        return {};
+    }
+
+    QList<QList<quint64>> result;
+    qint64 currentHash = 0;
+
+    while (query.next()) {
+        const qint64 contentHash = query.value(0).toLongLong();
+        if (result.isEmpty() || contentHash != currentHash) {
+            result.append({});
+            currentHash = contentHash;
+        }
+        result.last().append(query.value(1).toULongLong());
+    }
+
+    return result;
+}
+
+QHash<QUrl, quint64> TrackDatabase::fetchTrackIds() const {
+    const auto reader = readLease();
+    QHash<QUrl, quint64> result;
+
+    const QString statement = QStringLiteral("SELECT `TrackID`, `FileName` FROM `Tracks`;");
+    SqlQuery query{db(), statement};
+
+    if (!query.exec()) {
+        qWarning() << "Failed to fetch track IDs: " << query.lastError().text();
+        return result;
+    }
+
+    while (query.next()) {
+        result.emplace(QUrl{query.value(1).toString()}, query.value(0).toULongLong());
+    }
+
+    return result;
+}
+
 QHash<QUrl, quint64> TrackDatabase::fetchTrackIdsFromFileNames(const QList<QUrl>& fileNames) const {
     QHash<QUrl, quint64> result;
 
     if (fileNames.isEmpty()) return result;
 
+    const auto reader = readLease();
+
     QStringList placeholders;
     placeholders.reserve(fileNames.size());
     for (int i = 0; i < fileNames.size(); ++i) {
@@ -202,69 +534,174 @@ QHash<QUrl, quint64> TrackDatabase::fetchTrackIdsFromFileNames(const QList<QUrl>
 }
 
 quint64 TrackDatabase::fetchTrackIdFromFileName(const QUrl& fileName) const {
-    const QString statement = QStringLiteral("SELECT `TrackID` FROM `Tracks` WHERE `FileName` = :fileName;");
-    SqlQuery query{db(), statement};
-    query.bindStringValue(QStringLiteral(":fileName"), fileName.toString());
+    const auto reader = readLease();
+    const auto query = cachedQuery(QStringLiteral("SELECT `TrackID` FROM `Tracks` WHERE `FileName` = :fileName;"));
+    query->bindStringValue(QStringLiteral(":fileName"), fileName.toString());
 
-    if (!query.exec()) return {};
+    if (!query->exec()) return {};
 
-    if (query.next()) {
-        return query.value(0).toULongLong();
+    if (query->next()) {
+        return query->value(0).toULongLong();
     }
 
     return {};
 }
 
-Metadata::TrackFields TrackDatabase::fetchTrackFromId(const quint64 trackId) const {
-    const QString statement =
-        QStringLiteral("SELECT `TrackID`, %1 FROM `Tracks` WHERE `TrackID` = :trackId;").arg(getTrackColumns());
+QList<quint64> TrackDatabase::fetchTrackIdsUnderPath(const QUrl& path) const {
+    const auto reader = readLease();
+    QList<quint64> result;
+
+    // The path is either a single file or a directory with any number of tracks below it. Everything below the
+    // directory sorts between "<path>/" and "<path>0", '0' follows '/', and the comparison is case-sensitive
+    // and can use the file name index, unlike LIKE.
+    const QString statement = QStringLiteral(
+        "SELECT `TrackID` FROM `Tracks` WHERE `FileName` = :fileName OR "
+        "(`FileName` >= :first AND `FileName` < :last);");
     SqlQuery query{db(), statement};
-    query.bindValue(QStringLiteral(":trackId"), trackId);
 
-    if (!query.exec()) return {};
+    const QString directory = path.toString(QUrl::StripTrailingSlash);
+    query.bindStringValue(QStringLiteral(":fileName"), path.toString());
+    query.bindStringValue(QStringLiteral(":first"), directory + QLatin1Char('/'));
+    query.bindStringValue(QStringLiteral(":last"), directory + QLatin1Char('0'));
 
-    if (query.next()) {
-        return insertTrackMetadata(query);
+    if (!query.exec()) {
+        qWarning() << "Failed to fetch track IDs under path: " << query.lastError().text();
+        return result;
     }
 
-    return {};
+    while (query.next()) {
+        result.append(query.value(0).toULongLong());
+    }
+
+    return result;
 }
 
-bool TrackDatabase::insertTrack(Metadata::TrackFields& track) const {
-    // FIXME: Workaround to ensure that the `DateAdded` column is populated with the current time
-    const QString statement =
-        QStringLiteral("INSERT INTO `Tracks` (%1) VALUES (%2);")
-            .arg(getTrackColumns().remove(QStringLiteral(", `DateAdded`")), getTrackColumnBinds());
+Metadata::TrackFields TrackDatabase::fetchTrackFromId(const quint64 trackId) const {
+    const auto reader = readLease();
+    static const QString statement =
+        QStringLiteral("SELECT %1 FROM `TrackView` WHERE `TrackID` = :trackId;").arg(selectColumns());
+    const auto query = cachedQuery(statement);
+    query->bindValue(QStringLiteral(":trackId"), trackId);
 
-    SqlQuery query{db(), statement};
+    if (!query->exec()) return {};
 
-    const auto bindings = getTrackBindings(track);
-    for (const auto& [key, value] : bindings) {
-        query.bindValue(key, value);
+    if (query->next()) {
+        return readTrack(*query);
     }
 
-    if (!query.exec()) {
-        qWarning() << "Failed to insert track: " << query.lastError().text() << "\nLast query: " << query.lastQuery();
+    return {};
+}
+
+bool TrackDatabase::insertRows(const DbConnectionPool::Lease& connection,
+                               const std::span<Metadata::TrackFields* const> tracks, NameCache& names) {
+    const auto rows = static_cast<qsizetype>(tracks.size());
+    const auto query = connection.statement(insertStatement(rows));
+
+    QVarLengthArray<NameIds, 64> ids;
+    ids.reserve(rows);
+    // Rows come back in no particular order, the file name tells which track got which id
+    QHash<QString, qsizetype> rowOfFileName;
+    rowOfFileName.reserve(rows);
+
+    for (qsizetype row = 0; row < rows; ++row) {
+        const Metadata::TrackFields& track = *tracks[static_cast<std::size_t>(row)];
+        ids.append(names.resolve(track));
+        bindTrack(*query, static_cast<int>(row) * StoredColumnCount, track, ids.back());
+        // A file listed twice is only inserted the first time
+        const QString fileName = track.get(Metadata::Fields::ResourceUrl).toUrl().toString();
+        if (!rowOfFileName.contains(fileName)) {
+            rowOfFileName.insert(fileName, row);
+        }
+    }
+
+    if (!query->exec()) {
+        qWarning() << "Failed to insert tracks: " << query->lastError().text();
         return false;
     }
 
-    track.insert(Metadata::Fields::DatabaseId, query.lastInsertId().toULongLong());
+    while (query->next()) {
+        const qsizetype row = rowOfFileName.value(query->value(1).toString(), -1);
+        if (row < 0) continue;
+
+        Metadata::TrackFields& track = *tracks[static_cast<std::size_t>(row)];
+        track.insert(Metadata::Fields::DatabaseId, query->value(0).toULongLong());
+        track.insert(Metadata::Fields::AlbumId, idValue(ids[row].albumId));
+    }
 
     return true;
 }
 
-bool TrackDatabase::updateTrack(const Metadata::TrackFields& track) const {
-    const QString statement = QStringLiteral(
-        "UPDATE `Tracks` SET `Title` = :title, `ArtistName` = :artist, `AlbumTitle` = :album, `Genre` = :genre, "
-        "`Duration` = :duration, `TrackNumber` = :track_number, `Year` = :year, `FileName` = :fileName "
-        "WHERE `TrackID` = :trackId;");
-    SqlQuery query{db(), statement};
-    query.bindValue(QStringLiteral(":trackId"), track.get(Metadata::Fields::DatabaseId).toULongLong());
+bool TrackDatabase::updateTrack(SqlQuery& query, Metadata::TrackFields& track, NameCache& names) {
+    const NameIds ids = names.resolve(track);
+    bindTrack(query, 0, track, ids);
+    query.bindValue(StoredColumnCount, track.get(Metadata::Fields::DatabaseId).toULongLong());
+
+    if (!query.exec()) return false;
 
-    const auto bindings = getTrackBindings(track);
-    for (const auto& [key, value] : bindings) {
-        query.bindValue(key, value);
+    track.insert(Metadata::Fields::AlbumId, idValue(ids.albumId));
+
+    return true;
+}
+
+bool TrackDatabase::collectNames(const quint64 trackId, NameRefs& names) const {
+    // The album's artist too, it goes with the album
+    static const QString statement =
+        QStringLiteral("SELECT `Tracks`.`ArtistID`, `Tracks`.`AlbumArtistID`, `Albums`.`ArtistID`, `Tracks`.`AlbumID`,"
+                       "   `Tracks`.`GenreID` "
+                       "FROM `Tracks` LEFT JOIN `Albums` ON `Albums`.`AlbumID` = `Tracks`.`AlbumID` "
+                       "WHERE `Tracks`.`TrackID` = :trackId;");
+    const auto query = cachedQuery(statement);
+    query->bindValue(QStringLiteral(":trackId"), trackId);
+
+    if (!query->exec()) {
+        qWarning() << "Failed to read track names: " << query->lastError().text();
+        return false;
     }
 
-    return query.exec();
+    if (query->next()) {
+        // NULL reads as 0
+        const auto add = [&query](QSet<quint64>& ids, const int column) {
+            if (const quint64 id = query->value(column).toULongLong(); id != 0) ids.insert(id);
+        };
+
+        add(names.artistIds, 0);
+        add(names.artistIds, 1);
+        add(names.artistIds, 2);
+        add(names.albumIds, 3);
+        add(names.genreIds, 4);
+    }
+
+    query->finish();
+    return true;
+}
+
+bool TrackDatabase::pruneNames(const NameRefs& names) const {
+    // Albums first, they hold on to their artist
+    static const std::array statements = {
+        QStringLiteral("DELETE FROM `Albums` WHERE `AlbumID` = :id AND NOT EXISTS "
+                       "(SELECT 1 FROM `Tracks` WHERE `Tracks`.`AlbumID` = `Albums`.`AlbumID`);"),
+        QStringLiteral("DELETE FROM `Artists` WHERE `ArtistID` = :id AND "
+                       "NOT EXISTS (SELECT 1 FROM `Tracks` WHERE `Tracks`.`ArtistID` = `Artists`.`ArtistID`) AND "
+                       "NOT EXISTS (SELECT 1 FROM `Tracks` WHERE `Tracks`.`AlbumArtistID` = `Artists`.`ArtistID`) AND "
+                       "NOT EXISTS (SELECT 1 FROM `Albums` WHERE `Albums`.`ArtistID` = `Artists`.`ArtistID`);"),
+        QStringLiteral("DELETE FROM `Genres` WHERE `GenreID` = :id AND NOT EXISTS "
+                       "(SELECT 1 FROM `Tracks` WHERE `Tracks`.`GenreID` = `Genres`.`GenreID`);"),
+    };
+    const std::array ids = {&names.albumIds, &names.artistIds, &names.genreIds};
+
+    for (std::size_t i = 0; i < statements.size(); ++i) {
+        if (ids[i]->isEmpty()) continue;
+
+        const auto query = cachedQuery(statements[i]);
+
+        for (const quint64 id : *ids[i]) {
+            query->bindValue(QStringLiteral(":id"), id);
+            if (!query->exec()) {
+                qWarning() << "Failed to prune unused names: " << query->lastError().text();
+                return false;
+            }
+        }
+    }
+
+    return true;
 }
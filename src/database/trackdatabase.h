@@ -2,25 +2,59 @@
 #define TRACKDATABASE_H
 
 #include "database/basedatabase.h"
+#include "library/filefingerprint.h"
 #include "metadata.hpp"
 
+#include <QSet>
+
+#include <span>
+
 class TrackDatabase : public BaseDatabase {
 public:
     using TrackFieldsList = QList<Metadata::TrackFields>;
 
+    struct TrackFingerprint {
+        quint64 trackId = 0;
+        QUrl url;
+        FileFingerprint fingerprint;
+    };
+
     [[nodiscard]] TrackFieldsList getTracks() const;
-    bool insertTracks(TrackFieldsList& tracks) const;
+    // Tracks that are not inserted because one with the same file name or hash is stored already
+    // keep no database id and are added to `conflicts`
+    bool insertTracks(TrackFieldsList& tracks, QList<QUrl>* conflicts = nullptr) const;
     bool updateTracks(TrackFieldsList& tracks) const;
     [[nodiscard]] bool deleteTrack(quint64 trackId) const;
     bool deleteTracks(TrackFieldsList& tracks) const;
+    bool deleteTracks(const QList<quint64>& trackIds) const;
 
+    [[nodiscard]] QHash<QUrl, quint64> fetchTrackIds() const;
     [[nodiscard]] QHash<QUrl, quint64> fetchTrackIdsFromFileNames(const QList<QUrl>& fileNames) const;
     [[nodiscard]] quint64 fetchTrackIdFromFileName(const QUrl& fileName) const;
+    [[nodiscard]] QList<quint64> fetchTrackIdsUnderPath(const QUrl& path) const;
     [[nodiscard]] Metadata::TrackFields fetchTrackFromId(quint64 trackId) const;
+    [[nodiscard]] QList<TrackFingerprint> fetchFingerprints() const;
+    // Tracks sharing a content hash, one list per group of copies
+    [[nodiscard]] QList<QList<quint64>> fetchDuplicateTrackIds() const;
 
 private:
-    bool insertTrack(Metadata::TrackFields& track) const;
-    [[nodiscard]] bool updateTrack(const Metadata::TrackFields& track) const;
+    class NameCache;
+
+    // Artists, albums and genres that may have lost the last track referring to them
+    struct NameRefs {
+        QSet<quint64> artistIds;
+        QSet<quint64> albumIds;
+        QSet<quint64> genreIds;
+    };
+
+    // One statement for all rows, ids are set on the tracks that were inserted
+    [[nodiscard]] static bool insertRows(const DbConnectionPool::Lease& connection,
+                                         std::span<Metadata::TrackFields* const> tracks, NameCache& names);
+    [[nodiscard]] static bool updateTrack(SqlQuery& query, Metadata::TrackFields& track, NameCache& names);
+    // Adds the names the track refers to before it is changed or deleted
+    bool collectNames(quint64 trackId, NameRefs& names) const;
+    // Drops those of the names no track refers to anymore
+    bool pruneNames(const NameRefs& names) const;
 };
 
 #endif // TRACKDATABASE_H
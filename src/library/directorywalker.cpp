@@ -0,0 +1,242 @@
+#include "library/directorywalker.h"
+
+#include "taglib/audioclassifier.h"
+
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+#include <atomic>
+#include <deque>
+#include <optional>
+#include <vector>
+
+namespace {
+
+constexpr qsizetype batchSize = 256;
+
+struct DirectoryKey {
+    quint64 device = 0;
+    quint64 inode = 0;
+
+    bool operator==(const DirectoryKey& other) const = default;
+};
+
+size_t qHash(const DirectoryKey& key, const size_t seed = 0) {
+    return qHashMulti(seed, key.device, key.inode);
+}
+
+// Identity of the directory a path resolves to, so symlinked directories are only walked once
+std::optional<DirectoryKey> directoryKey(const QString& path) {
+#ifdef Q_OS_UNIX
+    struct stat buffer{};
+    if (::stat(QFile::encodeName(path).constData(), &buffer) != 0 || !S_ISDIR(buffer.st_mode)) return std::nullopt;
+
+    return DirectoryKey{.device = static_cast<quint64>(buffer.st_dev), .inode = static_cast<quint64>(buffer.st_ino)};
+#else
+    const QString canonicalPath = QFileInfo(path).canonicalFilePath();
+    if (canonicalPath.isEmpty()) return std::nullopt;
+
+    return DirectoryKey{.device = 0, .inode = qHash(canonicalPath)};
+#endif
+}
+
+struct WorkQueue {
+    QMutex mutex;
+    std::deque<QString> directories;
+};
+
+} // namespace
+
+class DirectoryWalkerPrivate {
+public:
+    int m_workerCount = 1;
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+
+    // Directories that are queued or being listed, the walk is done once this drops to zero
+    std::atomic<qsizetype> m_pending{0};
+    std::atomic<qsizetype> m_queued{0};
+
+    QMutex m_idleMutex;
+    QWaitCondition m_idleCondition;
+
+    QMutex m_visitedMutex;
+    QSet<DirectoryKey> m_visited;
+
+    DirectoryWalker::FileBatchCallback m_onFiles;
+
+    bool markVisited(const QString& path);
+    void push(int worker, const QString& directory);
+    std::optional<QString> pop(int worker);
+    std::optional<QString> steal(int worker);
+    void wakeIdleWorkers();
+
+    void run(int worker);
+    void listDirectory(int worker, const QString& directory, QList<QUrl>& batch);
+};
+
+bool DirectoryWalkerPrivate::markVisited(const QString& path) {
+    const auto key = directoryKey(path);
+    if (!key) return false;
+
+    const QMutexLocker locker(&m_visitedMutex);
+
+    if (m_visited.contains(*key)) return false;
+
+    m_visited.insert(*key);
+    return true;
+}
+
+void DirectoryWalkerPrivate::push(const int worker, const QString& directory) {
+    ++m_pending;
+
+    {
+        auto& queue = *m_queues[worker];
+        const QMutexLocker locker(&queue.mutex);
+        queue.directories.push_back(directory);
+        ++m_queued;
+    }
+
+    wakeIdleWorkers();
+}
+
+std::optional<QString> DirectoryWalkerPrivate::pop(const int worker) {
+    auto& queue = *m_queues[worker];
+    const QMutexLocker locker(&queue.mutex);
+
+    if (queue.directories.empty()) return std::nullopt;
+
+    // Depth first on the own queue keeps the working set small
+    QString directory = std::move(queue.directories.back());
+    queue.directories.pop_back();
+    --m_queued;
+
+    return directory;
+}
+
+std::optional<QString> DirectoryWalkerPrivate::steal(const int worker) {
+    for (int offset = 1; offset < m_workerCount; ++offset) {
+        auto& queue = *m_queues[(worker + offset) % m_workerCount];
+        const QMutexLocker locker(&queue.mutex);
+
+        if (queue.directories.empty()) continue;
+
+        // Take from the other end, those are the shallowest and therefore largest subtrees
+        QString directory = std::move(queue.directories.front());
+        queue.directories.pop_front();
+        --m_queued;
+
+        return directory;
+    }
+
+    return std::nullopt;
+}
+
+void DirectoryWalkerPrivate::wakeIdleWorkers() {
+    const QMutexLocker locker(&m_idleMutex);
+    m_idleCondition.wakeAll();
+}
+
+void DirectoryWalkerPrivate::run(const int worker) {
+    QList<QUrl> batch;
+
+    while (true) {
+        auto directory = pop(worker);
+        if (!directory) {
+            directory = steal(worker);
+        }
+
+        if (directory) {
+            listDirectory(worker, *directory, batch);
+
+            if (--m_pending == 0) {
+                wakeIdleWorkers();
+            }
+            continue;
+        }
+
+        const QMutexLocker locker(&m_idleMutex);
+
+        if (m_pending.load() == 0) break;
+        if (m_queued.load() > 0) continue;
+
+        m_idleCondition.wait(&m_idleMutex);
+    }
+
+    if (!batch.isEmpty()) {
+        m_onFiles(batch);
+    }
+}
+
+void DirectoryWalkerPrivate::listDirectory(const int worker, const QString& directory, QList<QUrl>& batch) {
+    QDirIterator iterator(directory, QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot | QDir::Readable);
+
+    while (iterator.hasNext()) {
+        // The entry type comes from readdir, so this does not stat regular files
+        const QFileInfo fileInfo = iterator.nextFileInfo();
+
+        if (fileInfo.isDir()) {
+            if (markVisited(fileInfo.filePath())) {
+                push(worker, fileInfo.filePath());
+            }
+            continue;
+        }
+
+        // Sniffing every cover and cue sheet would cost an open per file, the scanner checks the content later
+        if (!AudioClassifier::isAudio(AudioClassifier::fromFileName(fileInfo.fileName()))) continue;
+
+        batch.append(QUrl::fromLocalFile(fileInfo.filePath()));
+
+        if (batch.size() >= batchSize) {
+            m_onFiles(batch);
+            batch.clear();
+        }
+    }
+}
+
+DirectoryWalker::DirectoryWalker(const int workerCount) : dw(std::make_unique<DirectoryWalkerPrivate>()) {
+    dw->m_workerCount = workerCount > 0 ? workerCount : QThread::idealThreadCount();
+
+    dw->m_queues.reserve(dw->m_workerCount);
+    for (int i = 0; i < dw->m_workerCount; ++i) {
+        dw->m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+}
+
+DirectoryWalker::~DirectoryWalker() = default;
+
+void DirectoryWalker::walk(const QList<QString>& roots, const FileBatchCallback& onFiles) {
+    dw->m_onFiles = onFiles;
+    dw->m_visited.clear();
+
+    int nextQueue = 0;
+    for (const QString& root : roots) {
+        if (dw->markVisited(root)) {
+            dw->push(nextQueue, root);
+            nextQueue = (nextQueue + 1) % dw->m_workerCount;
+        }
+    }
+
+    if (dw->m_pending.load() == 0) return;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(dw->m_workerCount);
+
+    for (int worker = 0; worker < dw->m_workerCount; ++worker) {
+        pool.start([this, worker] {
+            dw->run(worker);
+        });
+    }
+
+    pool.waitForDone();
+    dw->m_onFiles = nullptr;
+}
@@ -0,0 +1,31 @@
+#ifndef DIRECTORYWALKER_H
+#define DIRECTORYWALKER_H
+
+#include <QList>
+#include <QString>
+#include <QUrl>
+
+#include <functional>
+#include <memory>
+
+class DirectoryWalkerPrivate;
+
+class DirectoryWalker {
+public:
+    // Called from the walker threads, possibly concurrently, with batches of audio files
+    using FileBatchCallback = std::function<void(const QList<QUrl>& files)>;
+
+    explicit DirectoryWalker(int workerCount = 0);
+    ~DirectoryWalker();
+
+    DirectoryWalker(const DirectoryWalker&) = delete;
+    DirectoryWalker& operator=(const DirectoryWalker&) = delete;
+
+    // Blocks until every directory below the roots has been visited
+    void walk(const QList<QString>& roots, const FileBatchCallback& onFiles);
+
+private:
+    std::unique_ptr<DirectoryWalkerPrivate> dw;
+};
+
+#endif // DIRECTORYWALKER_H
@@ -0,0 +1,151 @@
+#include "library/disklocality.h"
+
+#include <QFile>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <optional>
+
+namespace DiskLocality {
+
+namespace {
+
+// ID3v2, FLAC metadata blocks and Vorbis comments sit at the start, ID3v1 and APE tags at the end
+constexpr qint64 headRegion = 256 * 1024;
+constexpr qint64 tailRegion = 128 * 1024;
+
+#ifdef Q_OS_LINUX
+class FileDescriptor {
+public:
+    explicit FileDescriptor(const QString& filePath)
+        : m_fd(::open(QFile::encodeName(filePath).constData(), O_RDONLY | O_CLOEXEC | O_NOATIME)) {
+        // O_NOATIME is only allowed for the owner of the file
+        if (m_fd < 0 && errno == EPERM) {
+            m_fd = ::open(QFile::encodeName(filePath).constData(), O_RDONLY | O_CLOEXEC);
+        }
+    }
+
+    ~FileDescriptor() {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+    }
+
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+    [[nodiscard]] int get() const {
+        return m_fd;
+    }
+
+private:
+    int m_fd = -1;
+};
+
+std::optional<quint64> firstExtent(const int fd) {
+    // Room for exactly one extent after the header
+    alignas(fiemap) std::array<char, sizeof(fiemap) + sizeof(fiemap_extent)> buffer{};
+    auto* request = reinterpret_cast<fiemap*>(buffer.data());
+
+    request->fm_start = 0;
+    request->fm_length = FIEMAP_MAX_OFFSET;
+    request->fm_extent_count = 1;
+
+    if (::ioctl(fd, FS_IOC_FIEMAP, request) != 0 || request->fm_mapped_extents == 0) return std::nullopt;
+
+    const fiemap_extent& extent = request->fm_extents[0];
+
+    // Inline and not yet allocated data has no meaningful physical address
+    if ((extent.fe_flags & (FIEMAP_EXTENT_UNKNOWN | FIEMAP_EXTENT_DATA_INLINE)) != 0) return std::nullopt;
+
+    return static_cast<quint64>(extent.fe_physical);
+}
+#endif
+
+} // namespace
+
+bool Placement::operator<(const Placement& other) const {
+    if (device != other.device) return device < other.device;
+    if (isPhysical != other.isPhysical) return isPhysical;
+    return position < other.position;
+}
+
+Placement placement(const QString& filePath) {
+#ifdef Q_OS_LINUX
+    const FileDescriptor fd(filePath);
+    if (fd.get() < 0) return {};
+
+    struct stat buffer{};
+    if (::fstat(fd.get(), &buffer) != 0) return {};
+
+    Placement result{.device = static_cast<quint64>(buffer.st_dev),
+                     .isPhysical = false,
+                     .position = static_cast<quint64>(buffer.st_ino)};
+
+    if (const auto extent = firstExtent(fd.get())) {
+        result.isPhysical = true;
+        result.position = *extent;
+    }
+
+    return result;
+#else
+    Q_UNUSED(filePath)
+    return {};
+#endif
+}
+
+void sortByPlacement(QList<QUrl>& urls) {
+    struct Entry {
+        Placement placement;
+        QUrl url;
+    };
+
+    QList<Entry> entries;
+    entries.reserve(urls.size());
+
+    for (QUrl& url : urls) {
+        entries.append({.placement = url.isLocalFile() ? placement(url.toLocalFile()) : Placement{},
+                        .url = std::move(url)});
+    }
+
+    std::ranges::stable_sort(entries, [](const Entry& a, const Entry& b) {
+        return a.placement < b.placement;
+    });
+
+    for (qsizetype i = 0; i < entries.size(); ++i) {
+        urls[i] = std::move(entries[i].url);
+    }
+}
+
+void prefetchTags(const QString& filePath) {
+#ifdef Q_OS_LINUX
+    const FileDescriptor fd(filePath);
+    if (fd.get() < 0) return;
+
+    struct stat buffer{};
+    if (::fstat(fd.get(), &buffer) != 0) return;
+
+    const qint64 size = buffer.st_size;
+
+    ::posix_fadvise(fd.get(), 0, qMin(size, headRegion), POSIX_FADV_WILLNEED);
+
+    if (size > headRegion) {
+        const qint64 tailStart = qMax(headRegion, size - tailRegion);
+        ::posix_fadvise(fd.get(), tailStart, size - tailStart, POSIX_FADV_WILLNEED);
+    }
+#else
+    Q_UNUSED(filePath)
+#endif
+}
+
+} // namespace DiskLocality
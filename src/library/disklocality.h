@@ -0,0 +1,32 @@
+#ifndef DISKLOCALITY_H
+#define DISKLOCALITY_H
+
+#include <QList>
+#include <QString>
+#include <QUrl>
+
+#include <limits>
+
+// Helpers for reading many files from a rotational disk without seeking back and forth
+namespace DiskLocality {
+
+struct Placement {
+    quint64 device = std::numeric_limits<quint64>::max(); // files that could not be examined sort last
+    bool isPhysical = false; // offset of the first extent, otherwise only the inode number is known
+    quint64 position = 0;
+
+    bool operator<(const Placement& other) const;
+};
+
+// Uses FIEMAP where the file system supports it and falls back to the inode number
+[[nodiscard]] Placement placement(const QString& filePath);
+
+// Stable, files that cannot be examined keep their relative order at the end
+void sortByPlacement(QList<QUrl>& urls);
+
+// Asks the kernel to start reading the regions where tags are stored, without waiting for it
+void prefetchTags(const QString& filePath);
+
+} // namespace DiskLocality
+
+#endif // DISKLOCALITY_H
@@ -0,0 +1,71 @@
+#include "library/filefingerprint.h"
+
+#include "xxhash64.h"
+
+#include <QFile>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <QDateTime>
+#include <QFileInfo>
+#endif
+
+bool FileFingerprint::isValid() const {
+    return size >= 0;
+}
+
+FileFingerprint FileFingerprint::fromPath(const QString& filePath) {
+    if (filePath.isEmpty()) return {};
+
+#ifdef Q_OS_LINUX
+    const QByteArray encodedPath = QFile::encodeName(filePath);
+
+    struct statx buffer{};
+    constexpr unsigned int mask = STATX_TYPE | STATX_SIZE | STATX_MTIME | STATX_INO;
+
+    if (statx(AT_FDCWD, encodedPath.constData(), AT_STATX_SYNC_AS_STAT, mask, &buffer) != 0) return {};
+    if (!S_ISREG(buffer.stx_mode)) return {};
+
+    return {.size = static_cast<qint64>(buffer.stx_size),
+            .modifiedNs = static_cast<qint64>(buffer.stx_mtime.tv_sec) * 1'000'000'000 + buffer.stx_mtime.tv_nsec,
+            .inode = buffer.stx_ino};
+#else
+    const QFileInfo fileInfo(filePath);
+    if (!fileInfo.isFile()) return {};
+
+    return {.size = fileInfo.size(),
+            .modifiedNs = fileInfo.lastModified().toMSecsSinceEpoch() * 1'000'000,
+            .inode = 0};
+#endif
+}
+
+quint64 FileFingerprint::contentHash(const QString& filePath) {
+    constexpr qint64 sampleSize = 64 * 1024;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) return 0;
+
+    const qint64 size = file.size();
+
+    XxHash64 hash;
+    hash.addValue(size);
+
+    QByteArray buffer(qMin(size, sampleSize), Qt::Uninitialized);
+    if (file.read(buffer.data(), buffer.size()) != buffer.size()) return 0;
+    hash.addData(buffer);
+
+    // Small files were read whole by the first sample
+    if (size > sampleSize) {
+        const qint64 tailStart = qMax(sampleSize, size - sampleSize);
+        buffer.resize(size - tailStart);
+
+        if (!file.seek(tailStart) || file.read(buffer.data(), buffer.size()) != buffer.size()) return 0;
+        hash.addData(buffer);
+    }
+
+    // 0 is reserved for files that could not be read
+    const quint64 result = hash.result();
+    return result != 0 ? result : 1;
+}
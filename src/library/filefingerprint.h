@@ -0,0 +1,22 @@
+#ifndef FILEFINGERPRINT_H
+#define FILEFINGERPRINT_H
+
+#include <QString>
+
+// Cheap identity of a file on disk, used to decide whether its tags need to be read again
+struct FileFingerprint {
+    qint64 size = -1;
+    qint64 modifiedNs = 0;
+    quint64 inode = 0;
+
+    [[nodiscard]] bool isValid() const;
+    bool operator==(const FileFingerprint& other) const = default;
+
+    [[nodiscard]] static FileFingerprint fromPath(const QString& filePath);
+
+    // XXH64 over the size, the first and the last 64 KiB of the file, 0 if it cannot be read.
+    // Catches copies of the same file under other names, tags that differ only after the head are not seen.
+    [[nodiscard]] static quint64 contentHash(const QString& filePath);
+};
+
+#endif // FILEFINGERPRINT_H
@@ -1,16 +1,15 @@
 #include "library/filescanner.h"
 
+#include "library/filefingerprint.h"
 #include "playerutils.hpp"
+#include "taglib/audioclassifier.h"
 #include "taglib/tagreader.h"
 #include "taglib/tracktags.h"
 
-#include <QMimeDatabase>
-
-#include <algorithm>
+#include <QDateTime>
 
 class FileScannerPrivate {
 public:
-    QMimeDatabase m_mimeDb;
     TagReader m_tagReader;
 };
 
@@ -18,63 +17,31 @@ FileScanner::FileScanner() : fs(std::make_unique<FileScannerPrivate>()) {}
 
 FileScanner::~FileScanner() = default;
 
-Metadata::TrackFields FileScanner::scanFile(const QUrl& file) const {
+Metadata::TrackFields FileScanner::scanFile(const QUrl& file, std::pmr::memory_resource* arena) const {
     Metadata::TrackFields newTrack{};
 
     if (!file.isLocalFile()) return newTrack;
 
     const QString filePath = file.toLocalFile();
-    const QFileInfo fileInfo(filePath);
 
-    if (!fs->m_mimeDb.mimeTypeForFile(filePath).name().startsWith("audio/")) return newTrack;
+    const auto format = AudioClassifier::classify(filePath);
+    if (!AudioClassifier::isAudio(format)) return newTrack;
+
+    const auto fingerprint = FileFingerprint::fromPath(filePath);
+    if (!fingerprint.isValid()) return newTrack;
 
-    newTrack.insert(Metadata::Fields::DateModified, fileInfo.metadataChangeTime());
+    newTrack.insert(Metadata::Fields::DateModified, QDateTime::fromMSecsSinceEpoch(fingerprint.modifiedNs / 1'000'000));
+    newTrack.insert(Metadata::Fields::FileSize, fingerprint.size);
+    newTrack.insert(Metadata::Fields::FileModified, fingerprint.modifiedNs);
+    newTrack.insert(Metadata::Fields::FileInode, fingerprint.inode);
     newTrack.insert(Metadata::Fields::ResourceUrl, file);
     newTrack.insert(Metadata::Fields::ElementType, PlayerUtils::Track);
     newTrack.insert(Metadata::Fields::Duration, QTime::fromMSecsSinceStartOfDay(1));
 
-    TrackTags tags(filePath);
-    fs->m_tagReader.readMetadata(filePath, tags);
-
-    const auto roleMapping = tags.fieldMapping();
-    auto rangeBegin = roleMapping.constKeyValueBegin();
-    QVariant value;
-
-    while (rangeBegin != roleMapping.constKeyValueEnd()) {
-        const auto key = rangeBegin->first;
-        const auto duplicateRangeEnd =
-            std::ranges::find_if(rangeBegin, roleMapping.constKeyValueEnd(), [key](const auto& pair) {
-                return pair.first != key;
-            });
-
-        const auto duplicateCount = std::ranges::distance(rangeBegin, duplicateRangeEnd);
-
-        if (duplicateCount > 1) {
-            QStringList values;
-            values.reserve(static_cast<int>(duplicateCount));
-
-            std::ranges::for_each(rangeBegin, duplicateRangeEnd, [&values](const auto& pair) {
-                values.append(pair.second.toString());
-            });
+    TrackTags tags(filePath, arena);
+    fs->m_tagReader.readMetadata(filePath, format, tags, TagReader::ReadProfile::Scan);
 
-            value = QLocale().createSeparatedList(values);
-        } else {
-            value = rangeBegin->second;
-        }
-
-        if (key == Metadata::Fields::Duration) {
-            newTrack.insert(key,
-                            QTime::fromMSecsSinceStartOfDay(static_cast<int>(1000 * rangeBegin->second.toDouble())));
-        } else {
-            newTrack.insert(key, value);
-        }
-
-        rangeBegin = duplicateRangeEnd;
-    }
-
-    if (newTrack.get(Metadata::Fields::HasEmbeddedCover).toBool()) {
-        newTrack.insert(Metadata::Fields::CoverImage, QUrl("image://cover/" + filePath));
-    }
+    tags.copyTo(newTrack);
 
     newTrack.insert(Metadata::Fields::Hash, newTrack.generateHash());
 
@@ -5,6 +5,8 @@
 
 #include <QFileInfo>
 
+#include <memory_resource>
+
 class QUrl;
 class FileScannerPrivate;
 
@@ -13,7 +15,9 @@ public:
     FileScanner();
     ~FileScanner();
 
-    [[nodiscard]] Metadata::TrackFields scanFile(const QUrl& file) const;
+    // Transient tag data that outgrows the inline buffers is taken from the arena, nothing of it is kept
+    [[nodiscard]] Metadata::TrackFields
+    scanFile(const QUrl& file, std::pmr::memory_resource* arena = std::pmr::get_default_resource()) const;
     [[nodiscard]] QList<Metadata::TrackFields> scanFiles(const QList<QUrl>& files) const;
 
 private:
@@ -1,34 +1,56 @@
 #include "library/library.hpp"
 
+#include "library/directorywalker.h"
+#include "library/filefingerprint.h"
 #include "library/filescanner.h"
+#include "library/librarywatcher.h"
 #include "library/playlistparser.h"
+#include "library/scanpipeline.h"
 
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QThread>
 #include <QThreadPool>
 
-Library::Library(QObject* parent) : QObject(parent), m_fileScanner(std::make_unique<FileScanner>()) {}
+#include <algorithm>
+#include <memory>
 
-Library::~Library() = default;
+Library::Library(QObject* parent) : QObject(parent), m_fileScanner(std::make_unique<FileScanner>()) {
+    // Scan threads stay alive between imports, together with the scanner each of them owns
+    m_scanPool.setMaxThreadCount(QThread::idealThreadCount());
+    m_scanPool.setExpiryTimeout(-1);
+}
+
+Library::~Library() {
+    // Watch jobs use the library, the ones still queued are dropped
+    m_watchThread.quit();
+    m_watchThread.wait();
+}
 
 void Library::initialize(const std::shared_ptr<DbConnectionPool>& pool) {
     m_trackDb.initialize(DbConnection{pool});
     m_playlistDb.initialize(DbConnection{pool});
 }
 
-QList<quint64> Library::addTracksFromUrls(const QList<QUrl>& urls) {
-    QList<quint64> trackIds;
-    trackIds.reserve(urls.size());
+void Library::setExecutor(DatabaseExecutor* executor) {
+    m_executor = executor != nullptr ? executor : &m_inlineExecutor;
+}
 
-    for (const QUrl& url : urls) {
-        const quint64 trackId = addTrackFromUrl(url);
-        if (trackId != 0) {
-            trackIds.append(trackId);
-        }
-    }
+void Library::setMaxScanThreads(const int count) {
+    m_scanPool.setMaxThreadCount(count > 0 ? count : QThread::idealThreadCount());
+}
 
-    return trackIds;
+void Library::setDiskLocalityOrdering(const bool enabled) {
+    m_scanOptions.localityOrdering = enabled;
+}
+
+void Library::setContentHashing(const bool enabled) {
+    m_scanOptions.contentHash = enabled;
+}
+
+QList<quint64> Library::addTracksFromUrls(const QList<QUrl>& urls) {
+    return ensureTracksInLibrary(urls);
 }
 
 quint64 Library::addTrackFromUrl(const QUrl& url) {
@@ -41,16 +63,85 @@ quint64 Library::addTrackFromUrl(const QUrl& url) {
     if (!trackFields.isValid()) return 0;
 
     auto tracks = QList{trackFields};
-    if (!m_trackDb.insertTracks(tracks)) return 0;
+    QList<QUrl> conflicts;
+    if (!m_trackDb.insertTracks(tracks, &conflicts)) return 0;
 
-    trackId = m_trackDb.fetchTrackIdFromFileName(url);
+    // Only looked up again if the file was added while it was scanned
+    if (!conflicts.isEmpty()) return m_trackDb.fetchTrackIdFromFileName(url);
+
+    trackId = tracks.first().get(Metadata::Fields::DatabaseId).toULongLong();
     if (trackId != 0) {
-        Q_EMIT trackAdded(trackId, trackFields);
+        Q_EMIT trackAdded(trackId, tracks.first());
     }
 
     return trackId;
 }
 
+QList<quint64> Library::importDirectory(const QUrl& directory) {
+    if (!directory.isLocalFile()) return {};
+
+    const QHash<QUrl, quint64> knownTracks = m_trackDb.fetchTrackIds();
+    QHash<QUrl, quint64> trackIdLookup = knownTracks;
+    QList<QUrl> discoveredUrls;
+
+    ScanPipeline pipeline{m_scanPool, m_scanOptions};
+
+    // The walk runs next to the writer, new files are scanned as soon as a batch of them is found
+    const std::unique_ptr<QThread> walkerThread{QThread::create([this, &directory, &knownTracks, &discoveredUrls,
+                                                                 &pipeline] {
+        DirectoryWalker walker;
+        walker.walk({directory.toLocalFile()}, [this, &knownTracks, &discoveredUrls,
+                                                &pipeline](const QList<QUrl>& files) {
+            QList<QUrl> newFiles;
+
+            for (const QUrl& file : files) {
+                if (!knownTracks.contains(file)) {
+                    newFiles.append(file);
+                }
+            }
+
+            {
+                const QMutexLocker locker(&m_mutex);
+                discoveredUrls.append(files);
+            }
+
+            pipeline.submit(newFiles);
+        });
+
+        pipeline.closeInput();
+    })};
+
+    walkerThread->start();
+
+    pipeline.drain(
+        [this, &trackIdLookup](QList<Metadata::TrackFields>& tracks) {
+            return insertScannedTracks(tracks, trackIdLookup);
+        },
+        [this](const ScanProgress& progress) {
+            Q_EMIT scanProgress(progress);
+        });
+
+    m_trackDb.checkpoint();
+
+    walkerThread->wait();
+
+    std::ranges::sort(discoveredUrls, [](const QUrl& a, const QUrl& b) {
+        return a.path() < b.path();
+    });
+
+    QList<quint64> trackIds;
+    trackIds.reserve(discoveredUrls.size());
+
+    for (const QUrl& url : std::as_const(discoveredUrls)) {
+        const quint64 trackId = trackIdLookup.value(url, 0);
+        if (trackId != 0) {
+            trackIds.append(trackId);
+        }
+    }
+
+    return trackIds;
+}
+
 Metadata::TrackFields Library::getTrackById(const quint64 id) const {
     return m_trackDb.fetchTrackFromId(id);
 }
@@ -58,16 +149,141 @@ Metadata::TrackFields Library::getTrackById(const quint64 id) const {
 void Library::updateTrack(const Metadata::TrackFields& track) {
     auto tracks = QList{track};
     if (m_trackDb.updateTracks(tracks)) {
-        Q_EMIT trackModified(track.get(Metadata::Fields::DatabaseId).toULongLong(), track);
+        // Carries the album the new names resolved to
+        Q_EMIT trackModified(track.get(Metadata::Fields::DatabaseId).toULongLong(), tracks.constFirst());
     }
 }
 
 void Library::removeTrack(const quint64 id) {
-    if (m_trackDb.deleteTrack(id)) {
+    // The bulk path also drops the artist, album and genre rows only this track used
+    if (m_trackDb.deleteTracks(QList<quint64>{id})) {
         Q_EMIT trackRemoved(id);
     }
 }
 
+Library::RescanResult Library::rescanLibrary() {
+    RescanResult result;
+
+    const auto storedTracks = m_trackDb.fetchFingerprints();
+    if (storedTracks.isEmpty()) return result;
+
+    // Only metadata syscalls here, file contents are read just for the tracks that changed
+    QList<FileFingerprint> currentFingerprints(storedTracks.size());
+    {
+        QThreadPool pool;
+        pool.setMaxThreadCount(QThread::idealThreadCount());
+
+        constexpr qsizetype chunkSize = 512;
+        FileFingerprint* const output = currentFingerprints.data();
+
+        for (qsizetype i = 0; i < storedTracks.size(); i += chunkSize) {
+            const qsizetype end = qMin(i + chunkSize, storedTracks.size());
+
+            pool.start([&storedTracks, output, i, end] {
+                for (qsizetype j = i; j < end; ++j) {
+                    output[j] = FileFingerprint::fromPath(storedTracks[j].url.toLocalFile());
+                }
+            });
+        }
+
+        pool.waitForDone();
+    }
+
+    QList<quint64> removedIds;
+    QList<QUrl> changedUrls;
+    QHash<QUrl, quint64> changedIds;
+
+    for (qsizetype i = 0; i < storedTracks.size(); ++i) {
+        const auto& stored = storedTracks[i];
+
+        if (!currentFingerprints[i].isValid()) {
+            removedIds.append(stored.trackId);
+        } else if (currentFingerprints[i] != stored.fingerprint) {
+            changedUrls.append(stored.url);
+            changedIds.insert(stored.url, stored.trackId);
+        } else {
+            ++result.unchanged;
+        }
+    }
+
+    if (!changedUrls.isEmpty()) {
+        ScanPipeline pipeline{m_scanPool, m_scanOptions};
+        pipeline.submit(changedUrls);
+        pipeline.closeInput();
+
+        pipeline.drain(
+            [this, &changedIds, &result](QList<Metadata::TrackFields>& tracks) -> qsizetype {
+                for (auto& track : tracks) {
+                    const QUrl url = track.get(Metadata::Fields::ResourceUrl).toUrl();
+                    track.insert(Metadata::Fields::DatabaseId, changedIds.take(url));
+                }
+
+                if (!m_trackDb.updateTracks(tracks)) return 0;
+
+                for (const auto& track : std::as_const(tracks)) {
+                    Q_EMIT trackModified(track.get(Metadata::Fields::DatabaseId).toULongLong(), track);
+                }
+
+                result.modified += static_cast<int>(tracks.size());
+                return tracks.size();
+            },
+            [this](const ScanProgress& progress) {
+                Q_EMIT scanProgress(progress);
+            });
+    }
+
+    // Whatever is left could not be read anymore, so it is no longer a playable track
+    for (const quint64 trackId : std::as_const(changedIds)) {
+        removedIds.append(trackId);
+    }
+
+    if (!removedIds.isEmpty() && m_trackDb.deleteTracks(removedIds)) {
+        for (const quint64 trackId : std::as_const(removedIds)) {
+            Q_EMIT trackRemoved(trackId);
+        }
+        result.removed = static_cast<int>(removedIds.size());
+    }
+
+    return result;
+}
+
+bool Library::watchDirectory(const QUrl& directory) {
+    if (!directory.isLocalFile() || !LibraryWatcher::isSupported()) return false;
+
+    if (!m_watcher) {
+        m_watcher = std::make_unique<LibraryWatcher>();
+
+        // Scanning and writing would block the GUI thread, changes are applied one batch after another
+        connect(m_watcher.get(), &LibraryWatcher::changesDetected, this,
+                [this](const LibraryWatcher::Changes& changes) {
+            m_watchExecutor.run([this, changes] {
+                applyFileChanges(changes);
+            });
+        });
+        connect(m_watcher.get(), &LibraryWatcher::overflowed, this, [this] {
+            qWarning() << "Lost file system events, checking the watched directories again";
+
+            m_watchExecutor.run([this, directories = m_watchedDirectories] {
+                (void)rescanLibrary();
+                for (const QUrl& watched : directories) {
+                    (void)importDirectory(watched);
+                }
+            });
+        });
+
+        m_watchThread.setObjectName(QStringLiteral("LibraryWatch"));
+        m_watchThread.start();
+    }
+
+    if (!m_watcher->addDirectory(directory.toLocalFile())) return false;
+
+    if (!m_watchedDirectories.contains(directory)) {
+        m_watchedDirectories.append(directory);
+    }
+
+    return true;
+}
+
 quint64 Library::createPlaylistFromUrls(const QString& name, const QList<QUrl>& urls) {
     QList<quint64> trackIds = ensureTracksInLibrary(urls);
 
@@ -105,13 +321,11 @@ quint64 Library::importPlaylist(const QUrl& url) {
 }
 
 void Library::renamePlaylist(const quint64 id, const QString& name) {
-    auto playlist = m_playlistDb.getPlaylist(id);
-    if (playlist.id == 0) return;
-
-    playlist.name = name;
-    if (m_playlistDb.updatePlaylist(playlist)) {
-        Q_EMIT playlistModified(id);
-    }
+    execute([this, id, name] {
+        return m_playlistDb.renamePlaylist(id, name);
+    }).then(this, [this, id](const bool renamed) {
+        if (renamed) Q_EMIT playlistModified(id);
+    });
 }
 
 void Library::removePlaylist(const quint64 id) {
@@ -128,8 +342,53 @@ const PlaylistDatabase& Library::playlistDatabase() const {
     return m_playlistDb;
 }
 
+QFuture<Metadata::TrackFields> Library::loadTrack(const quint64 id) const {
+    return execute([this, id] {
+        return m_trackDb.fetchTrackFromId(id);
+    });
+}
+
+QFuture<QList<Metadata::TrackFields>> Library::loadTracks() const {
+    return execute([this] {
+        return m_trackDb.getTracks();
+    });
+}
+
+QFuture<QList<Metadata::PlaylistHeader>> Library::loadPlaylistHeaders() const {
+    return execute([this] {
+        return m_playlistDb.getPlaylistHeaders();
+    });
+}
+
+QFuture<QList<Metadata::TrackFields>> Library::loadPlaylistTracks(const quint64 playlistId) const {
+    return execute([this, playlistId] {
+        const QList<quint64> trackIds = m_playlistDb.getPlaylistTracks(playlistId);
+
+        QList<Metadata::TrackFields> tracks;
+        tracks.reserve(trackIds.size());
+
+        for (const quint64 trackId : trackIds) {
+            auto track = m_trackDb.fetchTrackFromId(trackId);
+            if (track.isValid()) {
+                tracks.append(std::move(track));
+            }
+        }
+
+        return tracks;
+    });
+}
+
 Metadata::TrackFields Library::scanFile(const QUrl& url) const {
-    return m_fileScanner->scanFile(url);
+    auto track = m_fileScanner->scanFile(url);
+
+    if (m_scanOptions.contentHash && track.isValid()) {
+        const quint64 contentHash = FileFingerprint::contentHash(url.toLocalFile());
+        if (contentHash != 0) {
+            track.insert(Metadata::Fields::ContentHash, contentHash);
+        }
+    }
+
+    return track;
 }
 
 QList<quint64> Library::ensureTracksInLibrary(const QList<QUrl>& urls) {
@@ -146,62 +405,116 @@ QList<quint64> Library::ensureTracksInLibrary(const QList<QUrl>& urls) {
     }
 
     if (!urlsToScan.isEmpty()) {
-        QList<Metadata::TrackFields> scannedTracks;
+        qInfo() << "Scanning metadata for " << urlsToScan.size() << " files";
+
+        ScanPipeline pipeline{m_scanPool, m_scanOptions};
+        pipeline.submit(urlsToScan);
+        pipeline.closeInput();
+
+        pipeline.drain(
+            [this, &trackIdLookup](QList<Metadata::TrackFields>& tracks) {
+                return insertScannedTracks(tracks, trackIdLookup);
+            },
+            [this](const ScanProgress& progress) {
+                Q_EMIT scanProgress(progress);
+            });
 
-        QThreadPool pool;
-        const int ideal = QThread::idealThreadCount();
-        qInfo() << "Scanning metadata for " << urlsToScan.size() << " files using " << ideal << " threads";
-        pool.setMaxThreadCount(ideal);
+        m_trackDb.checkpoint();
+    }
 
-        constexpr int chunkSize = 100; // TODO: to be determined
+    QList<quint64> validTrackIds;
+    validTrackIds.reserve(urls.size());
 
-        for (int i = 0; i < urlsToScan.size(); i += chunkSize) {
-            const int end = qMin(i + chunkSize, static_cast<int>(urlsToScan.size()));
+    for (const QUrl& url : urls) {
+        const quint64 trackId = trackIdLookup.value(url, 0);
+        if (trackId != 0) {
+            validTrackIds.append(trackId);
+        }
+    }
 
-            pool.start([this, &urlsToScan, i, end, &scannedTracks] {
-                QList<Metadata::TrackFields> tracks;
-                tracks.reserve(end - i);
+    return validTrackIds;
+}
 
-                for (int j = i; j < end; ++j) {
-                    const auto trackFields = scanFile(urlsToScan[j]);
-                    if (trackFields.isValid()) {
-                        tracks.append(trackFields);
-                    }
-                }
+void Library::applyFileChanges(const LibraryWatcher::Changes& changes) {
+    QList<quint64> removedIds;
 
-                if (!tracks.isEmpty()) {
-                    const QMutexLocker locker(&m_mutex);
-                    scannedTracks.append(std::move(tracks));
-                }
-            });
+    for (const QUrl& path : changes.removedPaths) {
+        removedIds.append(m_trackDb.fetchTrackIdsUnderPath(path));
+    }
+
+    if (!removedIds.isEmpty() && m_trackDb.deleteTracks(removedIds)) {
+        for (const quint64 trackId : std::as_const(removedIds)) {
+            Q_EMIT trackRemoved(trackId);
         }
+    }
 
-        pool.waitForDone();
+    if (changes.changedFiles.isEmpty()) return;
+
+    QHash<QUrl, quint64> trackIdLookup = m_trackDb.fetchTrackIdsFromFileNames(changes.changedFiles);
+
+    ScanPipeline pipeline{m_scanPool, m_scanOptions};
+    pipeline.submit(changes.changedFiles);
+    pipeline.closeInput();
 
-        if (!scannedTracks.isEmpty() && m_trackDb.insertTracks(scannedTracks)) {
-            for (const auto& track : scannedTracks) {
-                const QUrl url = track.get(Metadata::Fields::ResourceUrl).toUrl();
-                const quint64 trackId = track.get(Metadata::Fields::DatabaseId).toULongLong();
+    pipeline.drain(
+        [this, &trackIdLookup](QList<Metadata::TrackFields>& tracks) -> qsizetype {
+            QList<Metadata::TrackFields> newTracks;
+            QList<Metadata::TrackFields> modifiedTracks;
 
-                if (trackId != 0) {
-                    trackIdLookup[url] = trackId;
-                    Q_EMIT trackAdded(trackId, track);
+            for (auto& track : tracks) {
+                const quint64 trackId = trackIdLookup.value(track.get(Metadata::Fields::ResourceUrl).toUrl(), 0);
+
+                if (trackId == 0) {
+                    newTracks.append(std::move(track));
+                } else {
+                    track.insert(Metadata::Fields::DatabaseId, trackId);
+                    modifiedTracks.append(std::move(track));
+                }
+            }
+
+            qsizetype written = insertScannedTracks(newTracks, trackIdLookup);
+
+            if (!modifiedTracks.isEmpty() && m_trackDb.updateTracks(modifiedTracks)) {
+                for (const auto& track : std::as_const(modifiedTracks)) {
+                    Q_EMIT trackModified(track.get(Metadata::Fields::DatabaseId).toULongLong(), track);
                 }
+                written += modifiedTracks.size();
             }
+
+            return written;
+        },
+        [this](const ScanProgress& progress) {
+            Q_EMIT scanProgress(progress);
+        });
+}
+
+qsizetype Library::insertScannedTracks(QList<Metadata::TrackFields>& tracks, QHash<QUrl, quint64>& trackIdLookup) {
+    QList<QUrl> conflicts;
+    if (!m_trackDb.insertTracks(tracks, &conflicts)) return 0;
+
+    if (!conflicts.isEmpty()) {
+        // Files stored in the meantime keep their id, the rest are copies of a stored track
+        const QHash<QUrl, quint64> storedIds = m_trackDb.fetchTrackIdsFromFileNames(conflicts);
+        trackIdLookup.insert(storedIds);
+
+        if (const qsizetype copies = conflicts.size() - storedIds.size(); copies > 0) {
+            qInfo() << "Skipped " << copies << " files whose tracks are stored already";
         }
     }
 
-    QList<quint64> validTrackIds;
-    validTrackIds.reserve(urls.size());
+    qsizetype inserted = 0;
+
+    for (const auto& track : std::as_const(tracks)) {
+        const quint64 trackId = track.get(Metadata::Fields::DatabaseId).toULongLong();
 
-    for (const QUrl& url : urls) {
-        const quint64 trackId = trackIdLookup.value(url, 0);
         if (trackId != 0) {
-            validTrackIds.append(trackId);
+            trackIdLookup.insert(track.get(Metadata::Fields::ResourceUrl).toUrl(), trackId);
+            Q_EMIT trackAdded(trackId, track);
+            ++inserted;
         }
     }
 
-    return validTrackIds;
+    return inserted;
 }
 
 quint64 Library::ensureTrackInLibrary(const QUrl& url) {
@@ -243,68 +556,3 @@ int Library::filterLocalPlaylist(QList<QUrl>& result, const QUrl& playlistUrl) {
 
     return filtered;
 }
-
-// void TrackPlaylistProxyModel::loadLocalFile(Metadata::EntryFieldsList& newTracks, QSet<QString>& processedFiles,
-//                                             const QFileInfo& fileInfo) {
-//     // protection against recursion
-//     const auto canonicalFilePath = fileInfo.canonicalFilePath();
-//     if (processedFiles.contains(canonicalFilePath)) return;
-//
-//     processedFiles.insert(canonicalFilePath);
-//
-//     const auto fileUrl = QUrl::fromLocalFile(fileInfo.filePath());
-//     const auto mimeType = tpp->m_mimeDB.mimeTypeForUrl(fileUrl);
-//     if (fileInfo.isDir()) {
-//         if (fileInfo.isSymLink()) return;
-//         loadLocalDirectory(newTracks, processedFiles, fileUrl);
-//     } else {
-//         if (!mimeType.name().startsWith(QLatin1String("audio/"))) return;
-//
-//         if (PlayerUtils::isPlaylist(mimeType)) {
-//             QFile file(fileInfo.filePath());
-//             if (!file.open(QIODevice::ReadOnly)) {
-//                 tpp->m_partiallyLoaded = true;
-//                 return;
-//             }
-//             loadLocalPlaylist(newTracks, processedFiles, fileUrl, file.readAll());
-//             return;
-//         }
-//         auto entry = Metadata::TrackFields();
-//         entry.insert(Metadata::Fields::ElementType, PlayerUtils::FileName);
-//         entry.insert(Metadata::Fields::ResourceUrl, fileUrl);
-//         newTracks.emplace_back(Metadata::EntryFields{.trackFields = entry, .title = {}, .url = {}});
-//     }
-// }
-
-// void TrackPlaylistProxyModel::loadLocalPlaylist(Metadata::EntryFieldsList& newTracks, QSet<QString>& processedFiles,
-//                                                 const QUrl& fileName, const QByteArray& fileContent) {
-//     QList<QUrl> listOfUrls = PlaylistParser::fromPlaylist(fileName, fileContent);
-//
-//     const int filtered = filterLocalPlaylist(listOfUrls, fileName);
-//     if (filtered != 0) {
-//         tpp->m_partiallyLoaded = true;
-//     }
-//
-//     for (const QUrl& oneUrl : std::as_const(listOfUrls)) {
-//         if (oneUrl.isLocalFile()) {
-//             const QFileInfo fileInfo(oneUrl.toLocalFile());
-//             loadLocalFile(newTracks, processedFiles, fileInfo);
-//         } else {
-//             auto entry = Metadata::TrackFields();
-//             entry.insert(Metadata::Fields::ElementType, PlayerUtils::FileName);
-//             entry.insert(Metadata::Fields::ResourceUrl, oneUrl);
-//             newTracks.emplace_back(Metadata::EntryFields{entry, {}, {}});
-//         }
-//     }
-// }
-//
-// void TrackPlaylistProxyModel::loadLocalDirectory(Metadata::EntryFieldsList& newTracks, QSet<QString>& processedFiles,
-//                                                  const QUrl& dirName) {
-//     const QDir dirInfo(dirName.toLocalFile());
-//     const auto fileInfoList =
-//         dirInfo.entryInfoList(QDir::NoDotAndDotDot | QDir::Readable | QDir::Files | QDir::Dirs, QDir::Name);
-//
-//     for (const auto& fileInfo : fileInfoList) {
-//         loadLocalFile(newTracks, processedFiles, fileInfo);
-//     }
-// }
@@ -1,12 +1,17 @@
 #ifndef LIBRARY_HPP
 #define LIBRARY_HPP
 
+#include "database/databaseexecutor.h"
 #include "database/playlistdatabase.h"
 #include "database/trackdatabase.h"
+#include "library/librarywatcher.h"
+#include "library/scanpipeline.h"
 #include "metadata.hpp"
 
 #include <QMutex>
 #include <QObject>
+#include <QThread>
+#include <QThreadPool>
 #include <QUrl>
 
 class FileScanner;
@@ -15,16 +20,37 @@ class Library : public QObject {
     Q_OBJECT
 
 public:
+    struct RescanResult {
+        int unchanged = 0;
+        int modified = 0;
+        int removed = 0;
+    };
+
     explicit Library(QObject* parent = nullptr);
     ~Library() override;
 
     void initialize(const std::shared_ptr<DbConnectionPool>& pool);
+    // Database work started through execute() runs on the executor's thread, without one it runs right away.
+    // Jobs use the library, so the executor's thread has to stop before the library is destroyed.
+    void setExecutor(DatabaseExecutor* executor);
+    // 0 uses one scan thread per core
+    void setMaxScanThreads(int count);
+    // Reads files in on-disk order with readahead, for libraries on rotational disks
+    void setDiskLocalityOrdering(bool enabled);
+    // Stores a hash of each file's content, so copies of a track can be found with fetchDuplicateTrackIds()
+    void setContentHashing(bool enabled);
 
     [[nodiscard]] QList<quint64> addTracksFromUrls(const QList<QUrl>& urls);
     [[nodiscard]] quint64 addTrackFromUrl(const QUrl& url);
+    [[nodiscard]] QList<quint64> importDirectory(const QUrl& directory);
     [[nodiscard]] Metadata::TrackFields getTrackById(quint64 id) const;
     void updateTrack(const Metadata::TrackFields& track);
     void removeTrack(quint64 id);
+    RescanResult rescanLibrary();
+
+    // Keeps the tracks below the directory in sync with the files on disk until the library is destroyed.
+    // Changes are read and written on a thread of the library's own, signals about them arrive queued.
+    bool watchDirectory(const QUrl& directory);
 
     [[nodiscard]] quint64 createPlaylistFromUrls(const QString& name, const QList<QUrl>& urls);
     [[nodiscard]] quint64 importPlaylist(const QUrl& url);
@@ -34,14 +60,28 @@ public:
     [[nodiscard]] const TrackDatabase& trackDatabase() const;
     [[nodiscard]] const PlaylistDatabase& playlistDatabase() const;
 
+    template <typename Job>
+    [[nodiscard]] auto execute(Job&& job) const {
+        return m_executor->run(std::forward<Job>(job));
+    }
+
+    [[nodiscard]] QFuture<Metadata::TrackFields> loadTrack(quint64 id) const;
+    [[nodiscard]] QFuture<QList<Metadata::TrackFields>> loadTracks() const;
+    [[nodiscard]] QFuture<QList<Metadata::PlaylistHeader>> loadPlaylistHeaders() const;
+    // The valid tracks of the playlist, in playlist order
+    [[nodiscard]] QFuture<QList<Metadata::TrackFields>> loadPlaylistTracks(quint64 playlistId) const;
+
 Q_SIGNALS:
     void trackAdded(quint64 id, const Metadata::TrackFields& track);
     void trackModified(quint64 id, const Metadata::TrackFields& track);
     void trackRemoved(quint64 id);
     void playlistModified(quint64 id);
+    void scanProgress(const ScanProgress& progress);
 
 private:
     [[nodiscard]] Metadata::TrackFields scanFile(const QUrl& url) const;
+    void applyFileChanges(const LibraryWatcher::Changes& changes);
+    qsizetype insertScannedTracks(QList<Metadata::TrackFields>& tracks, QHash<QUrl, quint64>& trackIdLookup);
     [[nodiscard]] QList<quint64> ensureTracksInLibrary(const QList<QUrl>& urls);
     [[nodiscard]] quint64 ensureTrackInLibrary(const QUrl& url);
     [[nodiscard]] static int filterLocalPlaylist(QList<QUrl>& result, const QUrl& playlistUrl);
@@ -50,6 +90,14 @@ private:
     PlaylistDatabase m_playlistDb;
     QMutex m_mutex;
     std::unique_ptr<FileScanner> m_fileScanner;
+    QThreadPool m_scanPool;
+    ScanPipeline::Options m_scanOptions;
+    std::unique_ptr<LibraryWatcher> m_watcher;
+    QList<QUrl> m_watchedDirectories;
+    QThread m_watchThread;
+    DatabaseExecutor m_watchExecutor{&m_watchThread};
+    DatabaseExecutor m_inlineExecutor;
+    DatabaseExecutor* m_executor = &m_inlineExecutor;
 };
 
 #endif // LIBRARY_HPP
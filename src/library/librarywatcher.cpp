@@ -0,0 +1,319 @@
+#include "library/librarywatcher.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QSet>
+#include <QSocketNotifier>
+#include <QTimer>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr int defaultDebounceMs = 500;
+constexpr int defaultMaxLatencyMs = 5000;
+
+bool isBelow(const QString& path, const QString& directory) {
+    return path.size() > directory.size() && path.startsWith(directory) && path.at(directory.size()) == u'/';
+}
+
+} // namespace
+
+class LibraryWatcherPrivate {
+public:
+    explicit LibraryWatcherPrivate(LibraryWatcher* watcher);
+    ~LibraryWatcherPrivate();
+
+    bool addWatches(const QString& root, bool reportFiles);
+    void removeWatches(const QString& directory);
+    void readEvents();
+    void fileChanged(const QString& path);
+    void pathRemoved(const QString& path, bool isDirectory);
+    void schedule();
+    void flush();
+
+    LibraryWatcher* const q;
+
+    int m_fd = -1;
+    std::unique_ptr<QSocketNotifier> m_notifier;
+
+    QList<QString> m_roots;
+    QHash<int, QString> m_directories; // watch descriptor -> directory
+    QHash<QString, int> m_descriptors; // directory -> watch descriptor
+
+    QSet<QString> m_changed;
+    QSet<QString> m_removed;
+
+    QTimer m_debounceTimer;
+    QElapsedTimer m_pendingSince;
+    int m_maxLatency = defaultMaxLatencyMs;
+};
+
+LibraryWatcherPrivate::LibraryWatcherPrivate(LibraryWatcher* watcher) : q(watcher) {
+    m_debounceTimer.setSingleShot(true);
+    m_debounceTimer.setInterval(defaultDebounceMs);
+    QObject::connect(&m_debounceTimer, &QTimer::timeout, q, [this] {
+        flush();
+    });
+
+#ifdef Q_OS_LINUX
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        qWarning() << "Failed to initialize inotify: " << std::strerror(errno);
+        return;
+    }
+
+    m_notifier = std::make_unique<QSocketNotifier>(m_fd, QSocketNotifier::Read);
+    QObject::connect(m_notifier.get(), &QSocketNotifier::activated, q, [this] {
+        readEvents();
+    });
+#endif
+}
+
+LibraryWatcherPrivate::~LibraryWatcherPrivate() {
+    m_notifier.reset();
+
+#ifdef Q_OS_LINUX
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+#endif
+}
+
+bool LibraryWatcherPrivate::addWatches(const QString& root, const bool reportFiles) {
+#ifdef Q_OS_LINUX
+    if (m_fd < 0) return false;
+
+    // Writes are reported once the file is closed, so half-copied files are not scanned
+    constexpr uint32_t mask =
+        IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR | IN_DONT_FOLLOW;
+
+    const auto addWatch = [this](const QString& directory) {
+        const int wd = inotify_add_watch(m_fd, QFile::encodeName(directory).constData(), mask);
+        if (wd < 0) {
+            qWarning() << "Failed to watch " << directory << ": " << std::strerror(errno);
+            return false;
+        }
+
+        m_directories.insert(wd, directory);
+        m_descriptors.insert(directory, wd);
+        return true;
+    };
+
+    if (!addWatch(root)) return false;
+
+    // Files created before the watches below were set up would go unnoticed otherwise
+    const QDir::Filters filters = reportFiles ? QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks
+                                              : QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks;
+    QDirIterator iterator(root, filters, QDirIterator::Subdirectories);
+
+    while (iterator.hasNext()) {
+        const QFileInfo fileInfo = iterator.nextFileInfo();
+
+        if (fileInfo.isDir()) {
+            addWatch(fileInfo.absoluteFilePath());
+        } else {
+            fileChanged(fileInfo.absoluteFilePath());
+        }
+    }
+
+    return true;
+#else
+    Q_UNUSED(root)
+    Q_UNUSED(reportFiles)
+    return false;
+#endif
+}
+
+void LibraryWatcherPrivate::removeWatches(const QString& directory) {
+    for (auto it = m_descriptors.begin(); it != m_descriptors.end();) {
+        if (it.key() == directory || isBelow(it.key(), directory)) {
+#ifdef Q_OS_LINUX
+            inotify_rm_watch(m_fd, it.value());
+#endif
+            m_directories.remove(it.value());
+            it = m_descriptors.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void LibraryWatcherPrivate::readEvents() {
+#ifdef Q_OS_LINUX
+    alignas(inotify_event) char buffer[64 * 1024];
+    bool overflowed = false;
+
+    while (true) {
+        const ssize_t length = ::read(m_fd, buffer, sizeof(buffer));
+
+        if (length < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN) {
+                qWarning() << "Failed to read inotify events: " << std::strerror(errno);
+            }
+            break;
+        }
+
+        if (length == 0) break;
+
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            if ((event->mask & IN_Q_OVERFLOW) != 0) {
+                overflowed = true;
+                continue;
+            }
+
+            if ((event->mask & IN_IGNORED) != 0) {
+                const QString directory = m_directories.take(event->wd);
+                if (m_descriptors.value(directory, -1) == event->wd) {
+                    m_descriptors.remove(directory);
+                }
+                continue;
+            }
+
+            const auto directory = m_directories.constFind(event->wd);
+            if (directory == m_directories.cend() || event->len == 0) continue;
+
+            const QString path = *directory + u'/' + QFile::decodeName(event->name);
+            const bool isDirectory = (event->mask & IN_ISDIR) != 0;
+
+            if ((event->mask & (IN_DELETE | IN_MOVED_FROM)) != 0) {
+                pathRemoved(path, isDirectory);
+            } else if (isDirectory && (event->mask & (IN_CREATE | IN_MOVED_TO)) != 0) {
+                addWatches(path, true);
+            } else if (!isDirectory && (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) != 0) {
+                fileChanged(path);
+            }
+        }
+    }
+
+    if (overflowed) {
+        // Whatever is pending is incomplete now, the receiver checks everything again
+        m_changed.clear();
+        m_removed.clear();
+        m_pendingSince.invalidate();
+        m_debounceTimer.stop();
+
+        // Directories created while events were dropped have no watch yet
+        for (const QString& root : std::as_const(m_roots)) {
+            addWatches(root, false);
+        }
+
+        Q_EMIT q->overflowed();
+        return;
+    }
+
+    schedule();
+#endif
+}
+
+void LibraryWatcherPrivate::fileChanged(const QString& path) {
+    m_removed.remove(path);
+    m_changed.insert(path);
+}
+
+void LibraryWatcherPrivate::pathRemoved(const QString& path, const bool isDirectory) {
+    if (isDirectory) {
+        removeWatches(path);
+
+        // The directory entry covers everything below it
+        const auto below = [&path](const QString& pending) {
+            return isBelow(pending, path);
+        };
+        m_changed.removeIf(below);
+        m_removed.removeIf(below);
+    }
+
+    m_changed.remove(path);
+    m_removed.insert(path);
+}
+
+void LibraryWatcherPrivate::schedule() {
+    if (m_changed.isEmpty() && m_removed.isEmpty()) return;
+
+    if (!m_pendingSince.isValid()) {
+        m_pendingSince.start();
+    }
+
+    // A steady stream of events, like a long copy, would otherwise postpone the batch forever
+    const qint64 remaining = m_maxLatency - m_pendingSince.elapsed();
+    if (remaining <= 0) {
+        flush();
+        return;
+    }
+
+    m_debounceTimer.start(static_cast<int>(qMin<qint64>(m_debounceTimer.interval(), remaining)));
+}
+
+void LibraryWatcherPrivate::flush() {
+    m_debounceTimer.stop();
+    m_pendingSince.invalidate();
+
+    if (m_changed.isEmpty() && m_removed.isEmpty()) return;
+
+    LibraryWatcher::Changes changes;
+    changes.changedFiles.reserve(m_changed.size());
+    changes.removedPaths.reserve(m_removed.size());
+
+    for (const QString& path : std::as_const(m_changed)) {
+        changes.changedFiles.append(QUrl::fromLocalFile(path));
+    }
+
+    for (const QString& path : std::as_const(m_removed)) {
+        changes.removedPaths.append(QUrl::fromLocalFile(path));
+    }
+
+    m_changed.clear();
+    m_removed.clear();
+
+    Q_EMIT q->changesDetected(changes);
+}
+
+LibraryWatcher::LibraryWatcher(QObject* parent)
+    : QObject(parent), lw(std::make_unique<LibraryWatcherPrivate>(this)) {}
+
+LibraryWatcher::~LibraryWatcher() = default;
+
+bool LibraryWatcher::isSupported() {
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool LibraryWatcher::addDirectory(const QString& path) {
+    if (!isSupported()) {
+        qWarning() << "Watching directories is not supported on this platform";
+        return false;
+    }
+
+    const QString directory = QDir(path).absolutePath();
+    if (lw->m_roots.contains(directory)) return true;
+
+    if (!lw->addWatches(directory, false)) return false;
+
+    lw->m_roots.append(directory);
+    return true;
+}
+
+void LibraryWatcher::setDebounceInterval(const int msec) {
+    lw->m_debounceTimer.setInterval(msec);
+}
+
+void LibraryWatcher::setMaxLatency(const int msec) {
+    lw->m_maxLatency = msec;
+}
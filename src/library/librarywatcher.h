@@ -0,0 +1,46 @@
+#ifndef LIBRARYWATCHER_H
+#define LIBRARYWATCHER_H
+
+#include <QList>
+#include <QObject>
+#include <QUrl>
+
+#include <memory>
+
+class LibraryWatcherPrivate;
+
+// Watches directory trees for changes and reports them in debounced batches.
+// Uses inotify on Linux, other platforms are not supported.
+class LibraryWatcher : public QObject {
+    Q_OBJECT
+
+public:
+    struct Changes {
+        QList<QUrl> changedFiles; // written, moved in or found in a new directory
+        QList<QUrl> removedPaths; // deleted or moved out, either single files or whole directories
+    };
+
+    explicit LibraryWatcher(QObject* parent = nullptr);
+    ~LibraryWatcher() override;
+
+    [[nodiscard]] static bool isSupported();
+
+    bool addDirectory(const QString& path);
+
+    // A batch is reported once no event arrived for the debounce interval,
+    // but never later than the max latency after its first event
+    void setDebounceInterval(int msec);
+    void setMaxLatency(int msec);
+
+Q_SIGNALS:
+    void changesDetected(const LibraryWatcher::Changes& changes);
+    // The kernel queue overflowed and events were lost, the watched trees have to be checked again
+    void overflowed();
+
+private:
+    std::unique_ptr<LibraryWatcherPrivate> lw;
+};
+
+Q_DECLARE_METATYPE(LibraryWatcher::Changes)
+
+#endif // LIBRARYWATCHER_H
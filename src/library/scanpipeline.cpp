@@ -0,0 +1,293 @@
+#include "library/scanpipeline.h"
+
+#include "library/disklocality.h"
+#include "library/filefingerprint.h"
+#include "library/filescanner.h"
+
+#include <QDeadlineTimer>
+#include <QThreadStorage>
+
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+
+namespace {
+
+constexpr qsizetype maxChunkSize = 256;
+constexpr std::size_t batchArenaSize = 256 * 1024;
+
+// Owned by the pool threads, so the scanner state survives between chunks and pipelines
+QThreadStorage<FileScanner*> threadScanners;
+
+const FileScanner& threadScanner() {
+    if (!threadScanners.hasLocalData()) {
+        threadScanners.setLocalData(new FileScanner);
+    }
+    return *threadScanners.localData();
+}
+
+} // namespace
+
+ScanPipeline::ScanPipeline(QThreadPool& pool) : ScanPipeline(pool, Options{}) {}
+
+ScanPipeline::ScanPipeline(QThreadPool& pool, const Options& options) : m_pool(pool), m_options(options) {
+    m_workerCount = qMax(1, m_options.workerCount > 0 ? m_options.workerCount : m_pool.maxThreadCount());
+    m_timer.start();
+}
+
+ScanPipeline::~ScanPipeline() {
+    const QMutexLocker locker(&m_mutex);
+
+    m_aborted = true;
+    m_inputClosed = true;
+    m_pending.clear();
+    m_prefetched = 0;
+    m_notFull.wakeAll();
+
+    // The pool outlives the pipeline, so only our own workers are waited for
+    while (m_runningWorkers > 0) {
+        m_workersDone.wait(&m_mutex);
+    }
+}
+
+void ScanPipeline::submit(const QList<QUrl>& urls) {
+    if (urls.isEmpty()) return;
+
+    // Sorting only looks at the files of this submission, anything submitted earlier is already being read
+    QList<QUrl> ordered = urls;
+    if (m_options.localityOrdering) {
+        DiskLocality::sortByPlacement(ordered);
+    }
+
+    int workersToStart = 0;
+
+    {
+        const QMutexLocker locker(&m_mutex);
+        if (m_aborted) return;
+
+        m_pending.insert(m_pending.end(), std::make_move_iterator(ordered.begin()),
+                         std::make_move_iterator(ordered.end()));
+
+        // Workers leave when they run out of input, later submissions start them again
+        const auto wanted = static_cast<int>(qMin<qsizetype>(m_workerCount, static_cast<qsizetype>(m_pending.size())));
+        workersToStart = qMax(0, wanted - m_runningWorkers);
+        m_runningWorkers += workersToStart;
+    }
+
+    for (int i = 0; i < workersToStart; ++i) {
+        m_pool.start([this] {
+            runWorker();
+        });
+    }
+}
+
+void ScanPipeline::closeInput() {
+    const QMutexLocker locker(&m_mutex);
+    m_inputClosed = true;
+    m_notEmpty.wakeAll();
+}
+
+void ScanPipeline::drain(const WriteCallback& write, const ProgressCallback& onProgress) {
+    QList<Metadata::TrackFields> chunk;
+    chunk.reserve(m_options.commitSize);
+
+    QElapsedTimer sinceCommit;
+    sinceCommit.start();
+
+    while (true) {
+        bool finished = false;
+        qsizetype queued = 0;
+
+        {
+            const QMutexLocker locker(&m_mutex);
+
+            const auto isDone = [this] {
+                return m_queue.empty() && m_inputClosed && m_pending.empty() && m_runningWorkers == 0;
+            };
+
+            if (m_queue.empty() && !isDone()) {
+                m_notEmpty.wait(&m_mutex, QDeadlineTimer(m_options.commitIntervalMs));
+            }
+
+            while (!m_queue.empty() && chunk.size() < m_options.commitSize) {
+                chunk.append(std::move(m_queue.front()));
+                m_queue.pop_front();
+            }
+
+            m_notFull.wakeAll();
+
+            queued = static_cast<qsizetype>(m_queue.size());
+            finished = isDone();
+        }
+
+        // Small chunks still get committed after a while, so rows show up while slow files are being read
+        const bool commitDue = chunk.size() >= m_options.commitSize ||
+                               (!chunk.isEmpty() && sinceCommit.elapsed() >= m_options.commitIntervalMs);
+
+        if (finished || commitDue) {
+            if (!chunk.isEmpty()) {
+                m_committed += write(chunk);
+                chunk.clear();
+            }
+
+            sinceCommit.restart();
+
+            if (onProgress) {
+                onProgress(progress(queued));
+            }
+        }
+
+        if (finished) break;
+    }
+}
+
+void ScanPipeline::runWorker() {
+    const FileScanner& scanner = threadScanner();
+
+    // Results are handed over in batches, so the queue lock is taken once per batch and not per file
+    QList<Metadata::TrackFields> results;
+    results.reserve(m_options.resultBatchSize);
+
+    QElapsedTimer chunkTimer;
+    QList<QString> prefetch;
+
+    // Tag text too large for the inline buffers of a file. Released with every batch, so the workers do not
+    // contend on the heap for data that is gone once the track is built.
+    const auto batchBuffer = std::make_unique_for_overwrite<std::byte[]>(batchArenaSize);
+    std::pmr::monotonic_buffer_resource batchArena(batchBuffer.get(), batchArenaSize);
+
+    const auto pushBatch = [this, &results, &batchArena] {
+        push(results);
+        batchArena.release();
+    };
+
+    while (true) {
+        const QList<QUrl> chunk = claimChunk(prefetch);
+        if (chunk.isEmpty()) return;
+
+        chunkTimer.start();
+
+        // The kernel reads these while this chunk is being parsed
+        for (const QString& filePath : std::as_const(prefetch)) {
+            DiskLocality::prefetchTags(filePath);
+        }
+        prefetch.clear();
+
+        for (const QUrl& url : chunk) {
+            if (m_aborted) break;
+
+            auto track = scanner.scanFile(url, &batchArena);
+            ++m_scanned;
+
+            if (track.isValid()) {
+                if (m_options.contentHash && url.isLocalFile()) {
+                    const quint64 contentHash = FileFingerprint::contentHash(url.toLocalFile());
+                    if (contentHash != 0) {
+                        track.insert(Metadata::Fields::ContentHash, contentHash);
+                    }
+                }
+                results.append(std::move(track));
+            }
+
+            if (results.size() >= m_options.resultBatchSize) {
+                pushBatch();
+            }
+        }
+
+        recordLatency(chunkTimer.nsecsElapsed(), chunk.size());
+
+        // Partial batches go out with every chunk, so the writer never waits on a slow file for them
+        if (!results.isEmpty()) {
+            push(results);
+        }
+        batchArena.release();
+    }
+}
+
+QList<QUrl> ScanPipeline::claimChunk(QList<QString>& prefetch) {
+    const QMutexLocker locker(&m_mutex);
+
+    // Leaving under the same lock submit() checks, so new input always finds a worker to run it
+    if (m_pending.empty() || m_aborted) {
+        --m_runningWorkers;
+        m_notEmpty.wakeAll();
+        m_workersDone.wakeAll();
+        return {};
+    }
+
+    const qsizetype size = qMin(chunkSize(), static_cast<qsizetype>(m_pending.size()));
+
+    QList<QUrl> chunk;
+    chunk.reserve(size);
+
+    for (qsizetype i = 0; i < size; ++i) {
+        chunk.append(std::move(m_pending.front()));
+        m_pending.pop_front();
+    }
+
+    if (m_options.localityOrdering) {
+        // The claimed files were prefetched earlier, the window moves past them
+        m_prefetched = qMax<qsizetype>(0, m_prefetched - size);
+        const qsizetype window = qMin(m_options.readaheadFiles, static_cast<qsizetype>(m_pending.size()));
+
+        for (; m_prefetched < window; ++m_prefetched) {
+            const QUrl& url = m_pending[static_cast<std::size_t>(m_prefetched)];
+            if (url.isLocalFile()) {
+                prefetch.append(url.toLocalFile());
+            }
+        }
+    }
+
+    return chunk;
+}
+
+qsizetype ScanPipeline::chunkSize() const {
+    // Guided: never claim more than a share of what is left, so the tail of the scan is spread over every worker
+    const qsizetype guided = qMax<qsizetype>(1, static_cast<qsizetype>(m_pending.size()) / (2 * m_workerCount));
+
+    // Until the first chunk is measured, start small
+    const qint64 nsPerFile = m_nsPerFile.load(std::memory_order_relaxed);
+    const qsizetype byLatency =
+        nsPerFile > 0 ? static_cast<qsizetype>(qint64{m_options.chunkLatencyMs} * 1'000'000 / nsPerFile) : 1;
+
+    return qBound<qsizetype>(1, qMin(guided, byLatency), maxChunkSize);
+}
+
+void ScanPipeline::recordLatency(const qint64 elapsedNs, const qsizetype files) {
+    if (files <= 0) return;
+
+    const qint64 sample = elapsedNs / files;
+    qint64 average = m_nsPerFile.load(std::memory_order_relaxed);
+
+    // Exponential moving average, racing updates only lose a sample
+    const qint64 updated = average == 0 ? sample : (average * 7 + sample) / 8;
+    m_nsPerFile.compare_exchange_weak(average, updated, std::memory_order_relaxed);
+}
+
+void ScanPipeline::push(QList<Metadata::TrackFields>& tracks) {
+    const QMutexLocker locker(&m_mutex);
+
+    while (static_cast<qsizetype>(m_queue.size()) >= m_options.queueCapacity && !m_aborted) {
+        m_notFull.wait(&m_mutex);
+    }
+
+    if (!m_aborted) {
+        for (auto& track : tracks) {
+            m_queue.push_back(std::move(track));
+        }
+        m_notEmpty.wakeOne();
+    }
+
+    tracks.clear();
+}
+
+ScanProgress ScanPipeline::progress(const qsizetype queued) const {
+    const qsizetype scanned = m_scanned.load();
+    const qint64 elapsedMs = m_timer.elapsed();
+
+    return {.scanned = scanned,
+            .queued = queued,
+            .committed = m_committed,
+            .filesPerSecond = elapsedMs > 0 ? static_cast<double>(scanned) * 1000.0 / static_cast<double>(elapsedMs)
+                                            : 0.0};
+}
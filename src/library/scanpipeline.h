@@ -0,0 +1,91 @@
+#ifndef SCANPIPELINE_H
+#define SCANPIPELINE_H
+
+#include "metadata.hpp"
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+
+struct ScanProgress {
+    qsizetype scanned = 0;   // files read by the scan workers
+    qsizetype queued = 0;    // tracks waiting for the writer
+    qsizetype committed = 0; // rows written to the database
+    double filesPerSecond = 0.0;
+};
+
+Q_DECLARE_METATYPE(ScanProgress)
+
+// Scan workers -> bounded queue -> writer committing in chunks.
+// Peak memory is bounded by the queue capacity, not by the number of submitted files.
+class ScanPipeline {
+public:
+    struct Options {
+        int workerCount = 0; // 0 uses every thread of the pool
+        qsizetype queueCapacity = 1024;
+        qsizetype commitSize = 500;
+        int commitIntervalMs = 1000;
+        int chunkLatencyMs = 50; // a worker claims about this much work at a time
+        qsizetype resultBatchSize = 32;
+        // For rotational disks: scan in on-disk order and prefetch the tags of the next files
+        bool localityOrdering = false;
+        qsizetype readaheadFiles = 8;
+        // Reads the head and tail of every file once more to find copies of the same audio
+        bool contentHash = false;
+    };
+
+    // Persists one chunk and returns how many of its tracks were written
+    using WriteCallback = std::function<qsizetype(QList<Metadata::TrackFields>& chunk)>;
+    using ProgressCallback = std::function<void(const ScanProgress& progress)>;
+
+    // Workers run on the given pool, each pool thread keeps its own FileScanner between pipelines
+    explicit ScanPipeline(QThreadPool& pool);
+    ScanPipeline(QThreadPool& pool, const Options& options);
+    ~ScanPipeline();
+
+    ScanPipeline(const ScanPipeline&) = delete;
+    ScanPipeline& operator=(const ScanPipeline&) = delete;
+
+    // Both are thread-safe and can be called while drain() is running
+    void submit(const QList<QUrl>& urls);
+    void closeInput();
+
+    // Runs the writer on the calling thread until the input is closed and every scanned track is written
+    void drain(const WriteCallback& write, const ProgressCallback& onProgress = {});
+
+private:
+    void runWorker();
+    [[nodiscard]] QList<QUrl> claimChunk(QList<QString>& prefetch);
+    [[nodiscard]] qsizetype chunkSize() const;
+    void recordLatency(qint64 elapsedNs, qsizetype files);
+    void push(QList<Metadata::TrackFields>& tracks);
+    [[nodiscard]] ScanProgress progress(qsizetype queued) const;
+
+    QThreadPool& m_pool;
+    Options m_options;
+    int m_workerCount = 1;
+
+    QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+    QWaitCondition m_workersDone;
+    std::deque<QUrl> m_pending;
+    qsizetype m_prefetched = 0; // files at the front of m_pending whose tags were already prefetched
+    std::deque<Metadata::TrackFields> m_queue;
+    int m_runningWorkers = 0;
+    bool m_inputClosed = false;
+    std::atomic<bool> m_aborted{false};
+
+    // Moving average of the time one file takes, chunks are sized from it
+    std::atomic<qint64> m_nsPerFile{0};
+    std::atomic<qsizetype> m_scanned{0};
+    qsizetype m_committed = 0;
+    QElapsedTimer m_timer;
+};
+
+#endif // SCANPIPELINE_H
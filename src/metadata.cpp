@@ -1,31 +1,263 @@
 #include "metadata.hpp"
 
 #include "playerutils.hpp"
+#include "stringpool.h"
+
+static_assert(Metadata::Fields::IsValid - Metadata::Fields::Title < 64, "every field needs a bit in m_present");
+
+bool Metadata::TrackFields::isTyped(const Fields field) {
+    switch (field) {
+    case Title:
+    case Artist:
+    case Album:
+    case AlbumArtist:
+    case Genre:
+    case Composer:
+    case Performer:
+    case Hash:
+    case ContentHash:
+    case ResourceUrl:
+    case CoverImage:
+    case DateAdded:
+    case DateModified:
+    case DatabaseId:
+    case AlbumId:
+    case FileInode:
+    case FileSize:
+    case FileModified:
+    case Duration:
+    case Year:
+    case TrackNumber:
+    case DiscNumber:
+    case BitRate:
+    case SampleRate:
+    case Channels:
+    case ElementType:
+    case HasEmbeddedCover:
+        return true;
+    default:
+        return false;
+    }
+}
 
 void Metadata::TrackFields::insert(const Fields field, const QVariant& value) {
-    data.insert(field, value);
+    // NULL columns and empty variants leave the field unset, as if it had never been read
+    if (value.isNull()) {
+        remove(field);
+        return;
+    }
+
+    if (!isTyped(field)) {
+        m_extras.insert(field, value);
+        return;
+    }
+
+    switch (field) {
+    case Title:
+        m_title = value.toString();
+        break;
+    case Artist:
+        m_artist = StringPool::intern(value.toString());
+        break;
+    case Album:
+        m_album = StringPool::intern(value.toString());
+        break;
+    case AlbumArtist:
+        m_albumArtist = StringPool::intern(value.toString());
+        break;
+    case Genre:
+        m_genre = StringPool::intern(value.toString());
+        break;
+    case Composer:
+        m_composer = StringPool::intern(value.toString());
+        break;
+    case Performer:
+        m_performer = StringPool::intern(value.toString());
+        break;
+    case Hash:
+        m_hash = value.toULongLong();
+        break;
+    case ContentHash:
+        m_contentHash = value.toULongLong();
+        break;
+    case ResourceUrl:
+        m_resourceUrl = value.toUrl();
+        break;
+    case CoverImage:
+        m_coverImage = value.toUrl();
+        break;
+    case DateAdded:
+        m_dateAdded = value.toDateTime();
+        break;
+    case DateModified:
+        m_dateModified = value.toDateTime();
+        break;
+    case DatabaseId:
+        m_databaseId = value.toULongLong();
+        break;
+    case AlbumId:
+        m_albumId = value.toULongLong();
+        break;
+    case FileInode:
+        m_fileInode = value.toULongLong();
+        break;
+    case FileSize:
+        m_fileSize = value.toLongLong();
+        break;
+    case FileModified:
+        m_fileModified = value.toLongLong();
+        break;
+    case Duration:
+        m_duration = value.toTime();
+        break;
+    case Year:
+        m_year = value.toInt();
+        break;
+    case TrackNumber:
+        m_trackNumber = value.toInt();
+        break;
+    case DiscNumber:
+        m_discNumber = value.toInt();
+        break;
+    case BitRate:
+        m_bitRate = value.toInt();
+        break;
+    case SampleRate:
+        m_sampleRate = value.toInt();
+        break;
+    case Channels:
+        m_channels = value.toInt();
+        break;
+    case ElementType:
+        m_elementType = value.toInt();
+        break;
+    case HasEmbeddedCover:
+        m_hasEmbeddedCover = value.toBool();
+        break;
+    default:
+        break;
+    }
+
+    m_present |= bit(field);
+}
+
+void Metadata::TrackFields::remove(const Fields field) {
+    if (!isTyped(field)) {
+        m_extras.remove(field);
+        return;
+    }
+
+    // Members keep their value, nothing reads them while the bit is clear
+    m_present &= ~bit(field);
 }
 
 bool Metadata::TrackFields::isValid() const {
-    return !isEmpty() && data.value(Duration).toTime().isValid();
+    return !isEmpty() && has(Duration) && m_duration.isValid();
 }
 
 bool Metadata::TrackFields::isEmpty() const {
-    return data.isEmpty();
+    return m_present == 0 && m_extras.isEmpty();
 }
 
 QVariant Metadata::TrackFields::get(const Fields field) const {
-    return data.value(field);
+    if (field == CoverImage) {
+        const QUrl cover = coverImage();
+        return cover.isEmpty() ? QVariant{} : QVariant{cover};
+    }
+
+    if (!isTyped(field)) return m_extras.value(field);
+    if (!has(field)) return {};
+
+    switch (field) {
+    case Title:
+        return m_title;
+    case Artist:
+        return m_artist;
+    case Album:
+        return m_album;
+    case AlbumArtist:
+        return m_albumArtist;
+    case Genre:
+        return m_genre;
+    case Composer:
+        return m_composer;
+    case Performer:
+        return m_performer;
+    case Hash:
+        return m_hash;
+    case ContentHash:
+        return m_contentHash;
+    case ResourceUrl:
+        return m_resourceUrl;
+    case DateAdded:
+        return m_dateAdded;
+    case DateModified:
+        return m_dateModified;
+    case DatabaseId:
+        return m_databaseId;
+    case AlbumId:
+        return m_albumId;
+    case FileInode:
+        return m_fileInode;
+    case FileSize:
+        return m_fileSize;
+    case FileModified:
+        return m_fileModified;
+    case Duration:
+        return m_duration;
+    case Year:
+        return m_year;
+    case TrackNumber:
+        return m_trackNumber;
+    case DiscNumber:
+        return m_discNumber;
+    case BitRate:
+        return m_bitRate;
+    case SampleRate:
+        return m_sampleRate;
+    case Channels:
+        return m_channels;
+    case ElementType:
+        return m_elementType;
+    case HasEmbeddedCover:
+        return m_hasEmbeddedCover;
+    default:
+        return {};
+    }
 }
 
 bool Metadata::TrackFields::contains(const Fields field) const {
-    return data.contains(field);
+    if (field == CoverImage) return !coverImage().isEmpty();
+    if (!isTyped(field)) return m_extras.contains(field);
+    return has(field);
+}
+
+QUrl Metadata::TrackFields::coverImage() const {
+    if (has(CoverImage)) return m_coverImage;
+
+    // Built on request, so tracks loaded in bulk do not each carry their own provider URL
+    if (has(HasEmbeddedCover) && m_hasEmbeddedCover && m_resourceUrl.isLocalFile()) {
+        return QUrl(QStringLiteral("image://cover/") + m_resourceUrl.toLocalFile());
+    }
+
+    return {};
 }
 
-QString Metadata::TrackFields::generateHash() const {
-    return PlayerUtils::calculateTrackHash(data.value(Title).toString(), data.value(Artist).toString(),
-                                           data.value(Album).toString(), data.value(AlbumArtist).toString(),
-                                           data.value(Genre).toString(), data.value(Year).toString(),
-                                           data.value(Duration).toString(), data.value(BitRate).toString(),
-                                           data.value(ResourceUrl).toUrl().toString(), data.value(FileType).toString());
+quint64 Metadata::TrackFields::generateHash() const {
+    // Unset fields hash like empty ones
+    const auto text = [this](const Fields field, const QString& value) {
+        return has(field) ? QStringView{value} : QStringView{};
+    };
+    const auto number = [this](const Fields field, const int value) {
+        return has(field) ? value : 0;
+    };
+
+    // Only stored columns are hashed, so a hash can be computed again from the database.
+    // The URL is the only one that has to be built, everything else is read in place.
+    const QString url = has(ResourceUrl) ? m_resourceUrl.toString() : QString{};
+
+    return PlayerUtils::calculateTrackHash(text(Title, m_title), text(Artist, m_artist), text(Album, m_album),
+                                           text(AlbumArtist, m_albumArtist), text(Genre, m_genre),
+                                           number(Year, m_year), has(Duration) ? m_duration.msecsSinceStartOfDay() : 0,
+                                           number(BitRate, m_bitRate), QStringView{url});
 }
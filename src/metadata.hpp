@@ -3,11 +3,14 @@
 
 #include "playerutils.hpp"
 
+#include <QDateTime>
+#include <QHash>
 #include <QList>
 #include <QMap>
 #include <QObject>
 #include <QQmlEngine>
 #include <QString>
+#include <QTime>
 #include <QUrl>
 #include <QVariant>
 
@@ -48,23 +51,117 @@ public:
         LastPlayed,
         DateAdded,
         DateModified,
+        FileSize,
+        FileModified,
+        FileInode,
         FileType,
         ElementType,
         Hash,
+        ContentHash,
         IsValid
     };
 
     Q_ENUM(Metadata::Fields)
 
-    struct TrackFields {
-        QHash<Fields, QVariant> data;
-
+    // Typed storage for the fields every library track carries, with a bit per field that was set.
+    // Names shared between tracks (artists, albums, genres, ...) are interned in the StringPool.
+    // Roles without a member of their own (rare tags, playlist state) go to a small hash.
+    class TrackFields {
+    public:
         void insert(Fields field, const QVariant& value);
+        void remove(Fields field);
         [[nodiscard]] bool isValid() const;
         [[nodiscard]] bool isEmpty() const;
         [[nodiscard]] QVariant get(Fields field) const;
         [[nodiscard]] bool contains(Fields field) const;
-        [[nodiscard]] QString generateHash() const;
+        // Identity of the track from its tags, properties and location
+        [[nodiscard]] quint64 generateHash() const;
+
+        // For model data() and sorting, fields that were not set read as default values
+        [[nodiscard]] quint64 databaseId() const {
+            return m_databaseId;
+        }
+        [[nodiscard]] quint64 albumId() const {
+            return m_albumId;
+        }
+        [[nodiscard]] const QUrl& resourceUrl() const {
+            return m_resourceUrl;
+        }
+        [[nodiscard]] const QString& title() const {
+            return m_title;
+        }
+        [[nodiscard]] const QString& artist() const {
+            return m_artist;
+        }
+        [[nodiscard]] const QString& album() const {
+            return m_album;
+        }
+        [[nodiscard]] const QString& albumArtist() const {
+            return m_albumArtist;
+        }
+        [[nodiscard]] const QString& genre() const {
+            return m_genre;
+        }
+        [[nodiscard]] int year() const {
+            return m_year;
+        }
+        [[nodiscard]] int trackNumber() const {
+            return m_trackNumber;
+        }
+        [[nodiscard]] int discNumber() const {
+            return m_discNumber;
+        }
+        [[nodiscard]] QTime duration() const {
+            return m_duration;
+        }
+        [[nodiscard]] quint64 hash() const {
+            return m_hash;
+        }
+        [[nodiscard]] quint64 contentHash() const {
+            return m_contentHash;
+        }
+        // Derived from the file name for tracks with an embedded cover, unless one was set explicitly
+        [[nodiscard]] QUrl coverImage() const;
+
+    private:
+        [[nodiscard]] static constexpr quint64 bit(const Fields field) {
+            return quint64{1} << (field - Title);
+        }
+        [[nodiscard]] bool has(const Fields field) const {
+            return (m_present & bit(field)) != 0;
+        }
+        [[nodiscard]] static bool isTyped(Fields field);
+
+        QString m_title;
+        QString m_artist;
+        QString m_album;
+        QString m_albumArtist;
+        QString m_genre;
+        QString m_composer;
+        QString m_performer;
+        QUrl m_resourceUrl;
+        QUrl m_coverImage;
+        QDateTime m_dateAdded;
+        QDateTime m_dateModified;
+        quint64 m_databaseId = 0;
+        quint64 m_albumId = 0;
+        quint64 m_fileInode = 0;
+        quint64 m_hash = 0;
+        quint64 m_contentHash = 0;
+        qint64 m_fileSize = 0;
+        qint64 m_fileModified = 0;
+        QTime m_duration;
+        int m_year = 0;
+        int m_trackNumber = 0;
+        int m_discNumber = 0;
+        int m_bitRate = 0;
+        int m_sampleRate = 0;
+        int m_channels = 0;
+        int m_elementType = 0;
+        bool m_hasEmbeddedCover = false;
+
+        quint64 m_present = 0;
+        QHash<Fields, QVariant> m_extras;
     };
 
     enum PlaylistFields : std::uint16_t {
@@ -80,6 +177,16 @@ public:
         QDateTime dateCreated;
         QDateTime lastModified;
     };
+
+    // What a playlist list shows, without the tracks themselves
+    struct PlaylistHeader {
+        quint64 id = 0;
+        QString name;
+        int trackCount = 0;
+        qint64 totalDuration = 0; // milliseconds
+        QDateTime dateCreated;
+        QDateTime lastModified;
+    };
 };
 
 Q_DECLARE_METATYPE(Metadata::TrackFields)
@@ -2,6 +2,8 @@
 
 #include "library/library.hpp"
 
+#include <QFuture>
+
 PlaylistCollectionModel::PlaylistCollectionModel(Library* library, QObject* parent)
     : QAbstractListModel(parent), m_library(library) {
     connect(m_library, &Library::playlistModified, this, &PlaylistCollectionModel::onPlaylistModified);
@@ -24,7 +26,9 @@ QVariant PlaylistCollectionModel::data(const QModelIndex& index, const int role)
     case NameRole:
         return playlist.name;
     case TrackCountRole:
-        return playlist.trackIds.size();
+        return playlist.trackCount;
+    case DurationRole:
+        return playlist.totalDuration;
     default:
         return {};
     }
@@ -37,6 +41,7 @@ QHash<int, QByteArray> PlaylistCollectionModel::roleNames() const {
     roles[PlaylistIdRole] = "playlistId";
     roles[NameRole]       = "name";
     roles[TrackCountRole] = "trackCount";
+    roles[DurationRole]   = "duration";
     // clang-format on
 
     return roles;
@@ -45,34 +50,50 @@ QHash<int, QByteArray> PlaylistCollectionModel::roleNames() const {
 void PlaylistCollectionModel::createPlaylist(const QString& name) {
     Metadata::PlaylistRecord record;
     record.name = name;
-    if (m_library->playlistDatabase().savePlaylist(record)) {
-        loadPlaylists();
-    }
+    m_library
+        ->execute([library = m_library, record] {
+            return library->playlistDatabase().savePlaylist(record);
+        })
+        .then(this, [this](const bool saved) {
+            if (saved) loadPlaylists();
+        });
 }
 
 void PlaylistCollectionModel::renamePlaylist(const int index, const QString& name) {
     if (index < 0 || index >= m_playlists.size()) return;
 
-    auto playlist = m_playlists[index];
-    playlist.name = name;
-
-    if (m_library->playlistDatabase().updatePlaylist(playlist)) {
-        loadPlaylists();
-    }
+    m_library
+        ->execute([library = m_library, id = m_playlists[index].id, name] {
+            return library->playlistDatabase().renamePlaylist(id, name);
+        })
+        .then(this, [this](const bool renamed) {
+            if (renamed) loadPlaylists();
+        });
 }
 
 void PlaylistCollectionModel::removePlaylist(const int index) {
     if (index < 0 || index >= m_playlists.size()) return;
 
-    const quint64 id = m_playlists[index].id;
-    if (m_library->playlistDatabase().removePlaylist(id)) {
-        loadPlaylists();
-    }
+    m_library
+        ->execute([library = m_library, id = m_playlists[index].id] {
+            return library->playlistDatabase().removePlaylist(id);
+        })
+        .then(this, [this](const bool removed) {
+            if (removed) loadPlaylists();
+        });
 }
 
-QList<quint64> PlaylistCollectionModel::getPlaylistTracks(const int index) const {
-    if (index < 0 || index >= m_playlists.size()) return {};
-    return m_library->playlistDatabase().getPlaylistTracks(m_playlists[index].id);
+void PlaylistCollectionModel::loadPlaylistTracks(const int index) {
+    if (index < 0 || index >= m_playlists.size()) return;
+
+    const quint64 id = m_playlists[index].id;
+    m_library
+        ->execute([library = m_library, id] {
+            return library->playlistDatabase().getPlaylistTracks(id);
+        })
+        .then(this, [this, id](const QList<quint64>& trackIds) {
+            Q_EMIT playlistTracksLoaded(id, trackIds);
+        });
 }
 
 void PlaylistCollectionModel::onPlaylistModified(const quint64 id) {
@@ -81,7 +102,14 @@ void PlaylistCollectionModel::onPlaylistModified(const quint64 id) {
 }
 
 void PlaylistCollectionModel::loadPlaylists() {
-    beginResetModel();
-    m_playlists = m_library->playlistDatabase().getPlaylists();
-    endResetModel();
+    const quint64 generation = ++m_loadGeneration;
+
+    m_library->loadPlaylistHeaders().then(this, [this, generation](QList<Metadata::PlaylistHeader> playlists) {
+        // A newer load replaces this one
+        if (generation != m_loadGeneration) return;
+
+        beginResetModel();
+        m_playlists = std::move(playlists);
+        endResetModel();
+    });
 }
@@ -17,6 +17,7 @@ public:
         PlaylistIdRole = Qt::UserRole + 1,
         NameRole,
         TrackCountRole,
+        DurationRole,
     };
     Q_ENUM(Roles)
 
@@ -29,7 +30,11 @@ public:
     Q_INVOKABLE void createPlaylist(const QString& name);
     Q_INVOKABLE void renamePlaylist(int index, const QString& name);
     Q_INVOKABLE void removePlaylist(int index);
-    Q_INVOKABLE [[nodiscard]] QList<quint64> getPlaylistTracks(int index) const;
+    // The track ids arrive with playlistTracksLoaded()
+    Q_INVOKABLE void loadPlaylistTracks(int index);
+
+Q_SIGNALS:
+    void playlistTracksLoaded(quint64 playlistId, const QList<quint64>& trackIds);
 
 public Q_SLOTS:
     void onPlaylistModified(quint64 id);
@@ -38,7 +43,9 @@ private:
     void loadPlaylists();
 
     Library* m_library;
-    QList<Metadata::PlaylistRecord> m_playlists;
+    // Track ids are only loaded when a playlist is opened
+    QList<Metadata::PlaylistHeader> m_playlists;
+    quint64 m_loadGeneration = 0;
 };
 
 #endif // PLAYLISTCOLLECTIONMODEL_HPP
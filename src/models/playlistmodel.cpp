@@ -2,7 +2,10 @@
 
 #include "library/library.hpp"
 
+#include <QFuture>
+#include <QHash>
 #include <QList>
+#include <QSet>
 #include <QUrl>
 
 #include <utility>
@@ -12,8 +15,7 @@ public:
     PlaylistEntry() = default;
 
     explicit PlaylistEntry(const Metadata::TrackFields& trackFields)
-        : m_dbId(trackFields.get(Metadata::Fields::DatabaseId).toULongLong()),
-          m_resourceUrl(trackFields.get(Metadata::Fields::ResourceUrl).toUrl()), m_isValid(true),
+        : m_dbId(trackFields.databaseId()), m_resourceUrl(trackFields.resourceUrl()), m_isValid(true),
           m_entryType(PlayerUtils::Track) {}
 
     explicit PlaylistEntry(QUrl resourceUrl)
@@ -22,10 +24,25 @@ public:
     quint64 m_dbId = 0;
     QUrl m_resourceUrl{};
     bool m_isValid = false;
+    // Waits for the library to read the track
+    bool m_isPending = false;
     PlayerUtils::PlaylistEntryType m_entryType = PlayerUtils::Unknown;
     PlaylistModel::PlayState m_isPlaying = PlaylistModel::NotPlaying;
 };
 
+namespace {
+
+PlaylistEntry pendingEntry(const quint64 trackId, const QUrl& resourceUrl) {
+    PlaylistEntry entry;
+    entry.m_dbId = trackId;
+    entry.m_resourceUrl = resourceUrl;
+    entry.m_entryType = PlayerUtils::Track;
+    entry.m_isPending = true;
+    return entry;
+}
+
+} // namespace
+
 class PlaylistModelPrivate {
 public:
     Library* m_library = nullptr;
@@ -68,7 +85,7 @@ QVariant PlaylistModel::data(const QModelIndex& index, int role) const {
     case DurationRole:
         return fields.get(Metadata::Fields::Duration);
     case DurationStringRole: {
-        const QTime duration = fields.get(Metadata::Fields::Duration).toTime();
+        const QTime duration = fields.duration();
         if (duration.hour() == 0) {
             return duration.toString(QStringLiteral("mm:ss"));
         }
@@ -141,7 +158,10 @@ void PlaylistModel::enqueueRestoredEntries(const QVariantList& newEntries) {
     if (newEntries.isEmpty()) return;
 
     const int start = static_cast<int>(p->m_entries.size());
+    QList<quint64> trackIds;
 
+    // The rows are there right away, so the restored position and shuffle order can refer to them.
+    // Their tracks are read by the library and filled in later.
     beginInsertRows(QModelIndex(), start, start + newEntries.size() - 1);
     for (const QVariant& entry : newEntries) {
         auto fields = entry.toStringList();
@@ -151,12 +171,10 @@ void PlaylistModel::enqueueRestoredEntries(const QVariantList& newEntries) {
         const QUrl resourceUrl = QUrl(fields[1]);
 
         if (dbId != 0) {
-            auto trackFields = p->m_library->getTrackById(dbId);
-            if (trackFields.isValid()) {
-                p->m_entries.push_back(PlaylistEntry{trackFields});
-                p->m_trackFields.push_back(trackFields);
-                continue;
-            }
+            p->m_entries.push_back(pendingEntry(dbId, resourceUrl));
+            p->m_trackFields.push_back({});
+            trackIds.append(dbId);
+            continue;
         }
 
         if (resourceUrl.isValid()) {
@@ -168,6 +186,8 @@ void PlaylistModel::enqueueRestoredEntries(const QVariantList& newEntries) {
         }
     }
     endInsertRows();
+
+    loadPendingTracks(trackIds);
 }
 
 void PlaylistModel::enqueueMultipleEntries(const QList<Metadata::TrackFields>& newEntries, const int insertAt) {
@@ -228,26 +248,19 @@ void PlaylistModel::loadTracksFromIds(const QList<quint64>& trackIds) {
 
     beginInsertRows(QModelIndex(), 0, static_cast<int>(trackIds.size()) - 1);
     for (const quint64 id : trackIds) {
-        auto trackFields = p->m_library->getTrackById(id);
-        if (trackFields.isValid()) {
-            p->m_entries.push_back(PlaylistEntry{trackFields});
-            p->m_trackFields.push_back(trackFields);
-        } else {
-            PlaylistEntry entry;
-            entry.m_dbId = id;
-            entry.m_entryType = PlayerUtils::Track;
-            p->m_entries.push_back(entry);
-            p->m_trackFields.push_back({});
-        }
+        p->m_entries.push_back(pendingEntry(id, {}));
+        p->m_trackFields.push_back({});
     }
     endInsertRows();
+
+    loadPendingTracks(trackIds);
 }
 
 QVariantList PlaylistModel::getEntriesForRestore() const {
     QVariantList result;
 
     for (const auto& entry : p->m_entries) {
-        if (!entry.m_isValid) continue;
+        if (!entry.m_isValid && !entry.m_isPending) continue;
 
         QStringList entryData;
         entryData.append(QString::number(entry.m_dbId));
@@ -263,6 +276,7 @@ void PlaylistModel::onTrackModified(const quint64 id, const Metadata::TrackField
         auto& entry = p->m_entries[i];
         if (entry.m_dbId == id || entry.m_resourceUrl == track.get(Metadata::Fields::ResourceUrl).toUrl()) {
             entry.m_isValid = true;
+            entry.m_isPending = false;
             entry.m_dbId = id;
             entry.m_entryType = PlayerUtils::Track;
             p->m_trackFields[i] = track;
@@ -280,3 +294,45 @@ void PlaylistModel::onTrackRemoved(const quint64 id) {
         }
     }
 }
+
+void PlaylistModel::loadPendingTracks(const QList<quint64>& trackIds) {
+    if (trackIds.isEmpty()) return;
+
+    p->m_library
+        ->execute([library = p->m_library, trackIds] {
+            QHash<quint64, Metadata::TrackFields> tracks;
+            tracks.reserve(trackIds.size());
+
+            for (const quint64 id : trackIds) {
+                if (tracks.contains(id)) continue;
+                if (auto track = library->getTrackById(id); track.isValid()) {
+                    tracks.insert(id, std::move(track));
+                }
+            }
+
+            return tracks;
+        })
+        .then(this, [this, requested = QSet<quint64>{trackIds.cbegin(), trackIds.cend()}](
+                        const QHash<quint64, Metadata::TrackFields>& tracks) {
+            // Rows may have moved in the meantime, the entries are found by their track id
+            for (int i = 0; i < p->m_entries.size(); ++i) {
+                auto& entry = p->m_entries[i];
+                if (!entry.m_isPending || !requested.contains(entry.m_dbId)) continue;
+
+                entry.m_isPending = false;
+
+                if (const auto it = tracks.constFind(entry.m_dbId); it != tracks.cend()) {
+                    entry.m_resourceUrl = it->resourceUrl();
+                    entry.m_isValid = true;
+                    p->m_trackFields[i] = *it;
+                } else if (entry.m_resourceUrl.isValid()) {
+                    // Gone from the library, the file is added again if it still exists
+                    entry.m_dbId = 0;
+                    entry.m_entryType = PlayerUtils::FileName;
+                    Q_EMIT addNewUrl(entry.m_resourceUrl, PlayerUtils::FileName);
+                }
+
+                Q_EMIT dataChanged(index(i), index(i));
+            }
+        });
+}
@@ -67,6 +67,9 @@ public Q_SLOTS:
     void onTrackRemoved(quint64 id);
 
 private:
+    // Reads the tracks through the library's executor and fills in the entries waiting for them
+    void loadPendingTracks(const QList<quint64>& trackIds);
+
     std::unique_ptr<PlaylistModelPrivate> p;
 };
 
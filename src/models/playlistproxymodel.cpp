@@ -221,19 +221,9 @@ void PlaylistProxyModel::enqueue(const QList<Metadata::TrackFields>& newEntries,
 }
 
 void PlaylistProxyModel::loadPlaylistFromDatabase(const quint64 playlistId) {
-    const auto tracks = pp->m_library->playlistDatabase().getPlaylistTracks(playlistId);
-
-    QList<Metadata::TrackFields> entries;
-    entries.reserve(tracks.size());
-
-    for (const quint64& trackId : tracks) {
-        auto track = pp->m_library->getTrackById(trackId);
-        if (track.isValid()) {
-            entries.emplace_back(std::move(track));
-        }
-    }
-
-    enqueue(entries, PlayerUtils::ReplacePlaylist, PlayerUtils::DoNotTriggerPlay);
+    pp->m_library->loadPlaylistTracks(playlistId).then(this, [this](const QList<Metadata::TrackFields>& entries) {
+        enqueue(entries, PlayerUtils::ReplacePlaylist, PlayerUtils::DoNotTriggerPlay);
+    });
 }
 
 void PlaylistProxyModel::loadPlaylistFromFile(const QUrl& fileName) {
@@ -2,8 +2,12 @@
 
 #include "library/library.hpp"
 
+#include <QFuture>
 #include <QTime>
 
+#include <algorithm>
+#include <utility>
+
 TrackCollectionModel::TrackCollectionModel(Library* library, QObject* parent)
     : QAbstractListModel(parent), m_library(library) {
     connect(m_library, &Library::trackAdded, this, &TrackCollectionModel::onTrackAdded);
@@ -42,7 +46,7 @@ QVariant TrackCollectionModel::data(const QModelIndex& index, const int role) co
     case DurationRole:
         return track.get(Metadata::Fields::Duration);
     case DurationStringRole: {
-        const QTime duration = track.get(Metadata::Fields::Duration).toTime();
+        const QTime duration = track.duration();
         if (duration.hour() == 0) {
             return duration.toString(QStringLiteral("mm:ss"));
         }
@@ -80,69 +84,104 @@ QHash<int, QByteArray> TrackCollectionModel::roleNames() const {
 
 quint64 TrackCollectionModel::getTrackId(const int index) const {
     if (index < 0 || index >= m_tracks.size()) return 0;
-    return m_tracks[index].get(Metadata::Fields::DatabaseId).toULongLong();
+    return m_tracks[index].databaseId();
 }
 
 QUrl TrackCollectionModel::getTrackUrl(const int index) const {
     if (index < 0 || index >= m_tracks.size()) return {};
-    return m_tracks[index].get(Metadata::Fields::ResourceUrl).toUrl();
+    return m_tracks[index].resourceUrl();
 }
 
 void TrackCollectionModel::refresh() {
-    beginResetModel();
-    m_tracks = m_library->trackDatabase().getTracks();
+    m_loading = true;
+    const quint64 generation = ++m_loadGeneration;
+
+    // Read and sorted on the database thread, only the reset happens here
+    m_library
+        ->execute([library = m_library] {
+            auto tracks = library->trackDatabase().getTracks();
+            sortTracks(tracks);
+            return tracks;
+        })
+        .then(this, [this, generation](QList<Metadata::TrackFields> tracks) {
+            // A newer load replaces this one
+            if (generation != m_loadGeneration) return;
+
+            beginResetModel();
+            m_tracks = std::move(tracks);
+            endResetModel();
+
+            m_loading = false;
+            const auto changes = std::exchange(m_pendingChanges, {});
+            for (const auto& change : changes) {
+                change();
+            }
+        });
+}
 
-    std::ranges::sort(m_tracks, [](const Metadata::TrackFields& a, const Metadata::TrackFields& b) {
+void TrackCollectionModel::sortTracks(QList<Metadata::TrackFields>& tracks) {
+    std::ranges::sort(tracks, [](const Metadata::TrackFields& a, const Metadata::TrackFields& b) {
         // First by album artist
-        const QString albumArtistA = a.get(Metadata::Fields::AlbumArtist).toString();
-        const QString albumArtistB = b.get(Metadata::Fields::AlbumArtist).toString();
+        const QString& albumArtistA = a.albumArtist();
+        const QString& albumArtistB = b.albumArtist();
         if (albumArtistA != albumArtistB) {
             return albumArtistA < albumArtistB;
         }
 
         // Then by album
-        const QString albumA = a.get(Metadata::Fields::Album).toString();
-        const QString albumB = b.get(Metadata::Fields::Album).toString();
+        const QString& albumA = a.album();
+        const QString& albumB = b.album();
         if (albumA != albumB) {
             return albumA < albumB;
         }
 
         // Then by disc number
-        const int discA = a.get(Metadata::Fields::DiscNumber).toInt();
-        const int discB = b.get(Metadata::Fields::DiscNumber).toInt();
+        const int discA = a.discNumber();
+        const int discB = b.discNumber();
         if (discA != discB) {
             return discA < discB;
         }
 
         // Finally by track number
-        return a.get(Metadata::Fields::TrackNumber).toInt() < b.get(Metadata::Fields::TrackNumber).toInt();
+        return a.trackNumber() < b.trackNumber();
     });
-
-    endResetModel();
 }
 
 void TrackCollectionModel::onTrackAdded(const quint64 id, const Metadata::TrackFields& track) {
+    if (m_loading) {
+        m_pendingChanges.append([this, id, track] {
+            onTrackAdded(id, track);
+        });
+        return;
+    }
+
+    // The load may have read it already
+    if (findTrackIndex(id) >= 0) {
+        onTrackModified(id, track);
+        return;
+    }
+
     int insertIndex = 0;
     for (; insertIndex < m_tracks.size(); ++insertIndex) {
         const auto& existingTrack = m_tracks[insertIndex];
 
-        const QString albumArtistA = track.get(Metadata::Fields::AlbumArtist).toString();
-        const QString albumArtistB = existingTrack.get(Metadata::Fields::AlbumArtist).toString();
+        const QString& albumArtistA = track.albumArtist();
+        const QString& albumArtistB = existingTrack.albumArtist();
         if (albumArtistA < albumArtistB) break;
         if (albumArtistA > albumArtistB) continue;
 
-        const QString albumA = track.get(Metadata::Fields::Album).toString();
-        const QString albumB = existingTrack.get(Metadata::Fields::Album).toString();
+        const QString& albumA = track.album();
+        const QString& albumB = existingTrack.album();
         if (albumA < albumB) break;
         if (albumA > albumB) continue;
 
-        const int discNumA = track.get(Metadata::Fields::DiscNumber).toInt();
-        const int discNumB = existingTrack.get(Metadata::Fields::DiscNumber).toInt();
+        const int discNumA = track.discNumber();
+        const int discNumB = existingTrack.discNumber();
         if (discNumA < discNumB) break;
         if (discNumA > discNumB) continue;
 
-        const int trackNumA = track.get(Metadata::Fields::TrackNumber).toInt();
-        const int trackNumB = existingTrack.get(Metadata::Fields::TrackNumber).toInt();
+        const int trackNumA = track.trackNumber();
+        const int trackNumB = existingTrack.trackNumber();
         if (trackNumA < trackNumB) break;
     }
 
@@ -152,6 +191,13 @@ void TrackCollectionModel::onTrackAdded(const quint64 id, const Metadata::TrackF
 }
 
 void TrackCollectionModel::onTrackModified(const quint64 id, const Metadata::TrackFields& track) {
+    if (m_loading) {
+        m_pendingChanges.append([this, id, track] {
+            onTrackModified(id, track);
+        });
+        return;
+    }
+
     const int index = findTrackIndex(id);
     if (index < 0) return;
 
@@ -162,23 +208,23 @@ void TrackCollectionModel::onTrackModified(const quint64 id, const Metadata::Tra
         for (; newPos < m_tracks.size(); ++newPos) {
             const auto& existingTrack = m_tracks[newPos];
 
-            const QString albumArtistA = track.get(Metadata::Fields::AlbumArtist).toString();
-            const QString albumArtistB = existingTrack.get(Metadata::Fields::AlbumArtist).toString();
+            const QString& albumArtistA = track.albumArtist();
+            const QString& albumArtistB = existingTrack.albumArtist();
             if (albumArtistA < albumArtistB) break;
             if (albumArtistA > albumArtistB) continue;
 
-            const QString albumA = track.get(Metadata::Fields::Album).toString();
-            const QString albumB = existingTrack.get(Metadata::Fields::Album).toString();
+            const QString& albumA = track.album();
+            const QString& albumB = existingTrack.album();
             if (albumA < albumB) break;
             if (albumA > albumB) continue;
 
-            const int discNumA = track.get(Metadata::Fields::DiscNumber).toInt();
-            const int discNumB = existingTrack.get(Metadata::Fields::DiscNumber).toInt();
+            const int discNumA = track.discNumber();
+            const int discNumB = existingTrack.discNumber();
             if (discNumA < discNumB) break;
             if (discNumA > discNumB) continue;
 
-            const int trackNumA = track.get(Metadata::Fields::TrackNumber).toInt();
-            const int trackNumB = existingTrack.get(Metadata::Fields::TrackNumber).toInt();
+            const int trackNumA = track.trackNumber();
+            const int trackNumB = existingTrack.trackNumber();
             if (trackNumA < trackNumB) break;
         }
         m_tracks.insert(newPos, track);
@@ -194,6 +240,13 @@ void TrackCollectionModel::onTrackModified(const quint64 id, const Metadata::Tra
 }
 
 void TrackCollectionModel::onTrackRemoved(const quint64 id) {
+    if (m_loading) {
+        m_pendingChanges.append([this, id] {
+            onTrackRemoved(id);
+        });
+        return;
+    }
+
     const int index = findTrackIndex(id);
     if (index < 0) return;
 
@@ -204,7 +257,7 @@ void TrackCollectionModel::onTrackRemoved(const quint64 id) {
 
 int TrackCollectionModel::findTrackIndex(const quint64 id) const {
     for (int i = 0; i < m_tracks.size(); ++i) {
-        if (m_tracks[i].get(Metadata::Fields::DatabaseId).toULongLong() == id) {
+        if (m_tracks[i].databaseId() == id) {
             return i;
         }
     }
@@ -5,6 +5,8 @@
 
 #include <QAbstractListModel>
 
+#include <functional>
+
 class Library;
 
 class TrackCollectionModel : public QAbstractListModel {
@@ -46,9 +48,14 @@ private Q_SLOTS:
 
 private:
     [[nodiscard]] int findTrackIndex(quint64 id) const;
+    static void sortTracks(QList<Metadata::TrackFields>& tracks);
 
     Library* m_library;
     QList<Metadata::TrackFields> m_tracks;
+    // Changes reported while a load is running are applied once it has finished
+    quint64 m_loadGeneration = 0;
+    bool m_loading = false;
+    QList<std::function<void()>> m_pendingChanges;
 };
 
 #endif // TRACKCOLLECTIONMODEL_HPP
@@ -1,7 +1,8 @@
 #ifndef PLAYERUTILS_HPP
 #define PLAYERUTILS_HPP
 
-#include <QCryptographicHash>
+#include "xxhash64.h"
+
 #include <QMimeType>
 #include <QQmlEngine>
 
@@ -65,17 +66,27 @@ Q_ENUM_NS(FilterType)
 bool isPlaylist(const QMimeType& mimeType);
 
 template <typename T>
-concept HasToUtf8 = requires(T t) {
-    { t.toUtf8() } -> std::convertible_to<QByteArray>;
-};
-
-template <typename... Columns>
-QString calculateTrackHash(const Columns&... columns) {
-    static_assert((HasToUtf8<Columns> && ...), "All columns must have a toUtf8() method returning QByteArray");
-
-    QCryptographicHash hash{QCryptographicHash::Algorithm::Md5};
-    (hash.addData(columns.toUtf8()), ...);
-    return QString::fromUtf8(hash.result().toHex());
+concept TrackHashColumn = std::convertible_to<T, QStringView> || std::integral<T>;
+
+// Text columns are prefixed with their length, so moving text from one column to the next changes the hash
+template <TrackHashColumn... Columns>
+quint64 calculateTrackHash(const Columns&... columns) {
+    XxHash64 hash;
+
+    const auto addColumn = [&hash]<typename Column>(const Column& column) {
+        if constexpr (std::same_as<Column, qint64>) {
+            hash.addValue(column);
+        } else if constexpr (std::integral<Column>) {
+            hash.addValue(static_cast<qint64>(column));
+        } else {
+            const QStringView text{column};
+            hash.addValue(text.size());
+            hash.addData(text);
+        }
+    };
+
+    (addColumn(columns), ...);
+    return hash.result();
 }
 
 } // namespace PlayerUtils
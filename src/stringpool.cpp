@@ -0,0 +1,37 @@
+#include "stringpool.h"
+
+#include <QReadWriteLock>
+#include <QSet>
+
+namespace StringPool {
+
+namespace {
+
+// Names are never removed, a library has a few thousand of them at most
+struct Pool {
+    QReadWriteLock lock;
+    QSet<QString> strings;
+};
+
+Pool& pool() {
+    static Pool instance;
+    return instance;
+}
+
+} // namespace
+
+QString intern(const QString& value) {
+    if (value.isEmpty()) return value;
+
+    Pool& shared = pool();
+
+    {
+        const QReadLocker locker(&shared.lock);
+        if (const auto it = shared.strings.constFind(value); it != shared.strings.cend()) return *it;
+    }
+
+    const QWriteLocker locker(&shared.lock);
+    return *shared.strings.insert(value);
+}
+
+} // namespace StringPool
@@ -0,0 +1,15 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <QString>
+
+// Process-wide pool of strings many tracks have in common, such as artist, album and genre names.
+// Equal strings share one buffer, so a large library keeps each name in memory only once.
+namespace StringPool {
+
+// Thread-safe, returns the pooled copy of the string and adds it to the pool if it is new
+[[nodiscard]] QString intern(const QString& value);
+
+} // namespace StringPool
+
+#endif // STRINGPOOL_H
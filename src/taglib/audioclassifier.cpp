@@ -0,0 +1,209 @@
+#include "taglib/audioclassifier.h"
+
+#include <QFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <array>
+
+namespace AudioClassifier {
+
+namespace {
+
+struct ExtensionEntry {
+    QLatin1StringView extension;
+    Format format;
+    bool ambiguous; // same extension is used by several formats, needs a look at the content
+};
+
+constexpr qsizetype maxExtensionLength = 4;
+constexpr qsizetype headerSize = 64;
+
+// Only formats TagLib can read. An .mp4 may be a video as well, its audio track is still played and tagged.
+constexpr std::array<ExtensionEntry, 27> extensions{{
+    {QLatin1StringView("mp3"), Format::Mpeg, false},
+    {QLatin1StringView("mp2"), Format::Mpeg, false},
+    {QLatin1StringView("mpga"), Format::Mpeg, false},
+    {QLatin1StringView("aac"), Format::Mpeg, false},
+    {QLatin1StringView("flac"), Format::Flac, false},
+    {QLatin1StringView("ogg"), Format::OggVorbis, true},
+    {QLatin1StringView("oga"), Format::OggVorbis, true},
+    {QLatin1StringView("opus"), Format::OggOpus, false},
+    {QLatin1StringView("spx"), Format::OggSpeex, false},
+    {QLatin1StringView("m4a"), Format::Mp4, false},
+    {QLatin1StringView("m4b"), Format::Mp4, false},
+    {QLatin1StringView("m4p"), Format::Mp4, false},
+    {QLatin1StringView("m4r"), Format::Mp4, false},
+    {QLatin1StringView("mp4"), Format::Mp4, false},
+    {QLatin1StringView("wma"), Format::Asf, false},
+    {QLatin1StringView("wav"), Format::Wav, false},
+    {QLatin1StringView("aif"), Format::Aiff, false},
+    {QLatin1StringView("aiff"), Format::Aiff, false},
+    {QLatin1StringView("aifc"), Format::Aiff, false},
+    {QLatin1StringView("ape"), Format::Ape, false},
+    {QLatin1StringView("mpc"), Format::Mpc, false},
+    {QLatin1StringView("mpp"), Format::Mpc, false},
+    {QLatin1StringView("wv"), Format::WavPack, false},
+    {QLatin1StringView("tta"), Format::TrueAudio, false},
+    {QLatin1StringView("dsf"), Format::Dsf, false},
+    {QLatin1StringView("dff"), Format::Dsdiff, false},
+    {QLatin1StringView("mka"), Format::Matroska, false},
+}};
+
+// The part of the file name after its last dot, empty when it has none
+QStringView extensionOf(const QStringView filePath) {
+    const QStringView fileName = filePath.sliced(filePath.lastIndexOf(u'/') + 1);
+    const qsizetype dot = fileName.lastIndexOf(u'.');
+    return dot < 0 ? QStringView{} : fileName.sliced(dot + 1);
+}
+
+const ExtensionEntry* findExtension(const QStringView extension) {
+    if (extension.isEmpty() || extension.size() > maxExtensionLength) return nullptr;
+
+    for (const auto& entry : extensions) {
+        if (extension.compare(entry.extension, Qt::CaseInsensitive) == 0) {
+            return &entry;
+        }
+    }
+
+    return nullptr;
+}
+
+bool startsWith(const QByteArrayView header, const qsizetype offset, const QByteArrayView magic) {
+    return header.size() >= offset + magic.size() && header.sliced(offset, magic.size()) == magic;
+}
+
+// Videos and images share the ftyp box, only files that name an audio brand are taken
+bool isAudioMp4(const QByteArrayView header) {
+    static constexpr std::array<QByteArrayView, 6> audioBrands{"M4A ", "M4B ", "M4P ", "M4R ", "F4A ", "F4B "};
+
+    const auto isAudioBrand = [](const QByteArrayView brand) {
+        return std::ranges::find(audioBrands, brand) != audioBrands.end();
+    };
+
+    if (header.size() < 16 || !startsWith(header, 4, "ftyp")) return false;
+    if (isAudioBrand(header.sliced(8, 4))) return true;
+
+    // A generic major brand like mp42 or isom, followed by the minor version and the compatible brands
+    const auto boxSize = static_cast<qsizetype>(qFromBigEndian<quint32>(header.data()));
+    const qsizetype end = qMin(boxSize, header.size());
+
+    for (qsizetype offset = 16; offset + 4 <= end; offset += 4) {
+        if (isAudioBrand(header.sliced(offset, 4))) return true;
+    }
+
+    return false;
+}
+
+// An MPEG audio frame header with a layer, bitrate and sample rate that exist, or an ADTS header, which uses
+// the reserved layer. TagLib's MPEG file reads both.
+bool isMpegFrame(const QByteArrayView header) {
+    const auto first = static_cast<quint8>(header[0]);
+    const auto second = static_cast<quint8>(header[1]);
+    const auto third = static_cast<quint8>(header[2]);
+
+    if (first != 0xFF || (second & 0xE0) != 0xE0) return false;
+
+    const int version = (second >> 3) & 0x03;
+    const int layer = (second >> 1) & 0x03;
+
+    if (layer == 0) {
+        // ADTS: 12 sync bits and one of the 13 sampling frequencies
+        return (second & 0xF0) == 0xF0 && ((third >> 2) & 0x0F) < 13;
+    }
+
+    const int bitRate = third >> 4;
+    const int sampleRate = (third >> 2) & 0x03;
+    return version != 1 && bitRate != 0 && bitRate != 0x0F && sampleRate != 3;
+}
+
+// ID3v2 tags are prepended to MPEG streams, but FLAC files carry them too
+qsizetype id3v2Size(const QByteArrayView header) {
+    if (header.size() < 10 || !header.startsWith("ID3")) return 0;
+
+    const auto byte = [&header](const qsizetype i) {
+        return static_cast<qsizetype>(static_cast<quint8>(header[i]) & 0x7F);
+    };
+
+    const qsizetype footer = (static_cast<quint8>(header[5]) & 0x10) != 0 ? 10 : 0;
+    return 10 + footer + ((byte(6) << 21) | (byte(7) << 14) | (byte(8) << 7) | byte(9));
+}
+
+Format sniff(const QString& filePath) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) return Format::Unknown;
+
+    const QByteArray header = file.read(headerSize);
+
+    if (const qsizetype tagSize = id3v2Size(header); tagSize > 0) {
+        if (file.seek(tagSize) && file.read(4) == "fLaC") return Format::Flac;
+        return Format::Mpeg;
+    }
+
+    return fromHeader(header);
+}
+
+} // namespace
+
+Format fromFileName(const QStringView fileName) {
+    const ExtensionEntry* entry = findExtension(extensionOf(fileName));
+    return entry != nullptr ? entry->format : Format::Unknown;
+}
+
+Format fromHeader(const QByteArrayView header) {
+    if (header.size() < 4) return Format::Unknown;
+
+    if (header.startsWith("fLaC")) return Format::Flac;
+
+    if (header.startsWith("OggS")) {
+        // The first page holds exactly the codec identification header, starting right after the 28 byte page header
+        if (startsWith(header, 28, "\x01vorbis")) return Format::OggVorbis;
+        if (startsWith(header, 28, "OpusHead")) return Format::OggOpus;
+        if (startsWith(header, 28, "\x7F" "FLAC")) return Format::OggFlac;
+        if (startsWith(header, 28, "Speex   ")) return Format::OggSpeex;
+        return Format::Unknown;
+    }
+
+    if (header.startsWith("ID3")) return Format::Mpeg;
+    if (isAudioMp4(header)) return Format::Mp4;
+    if (header.startsWith("RIFF") && startsWith(header, 8, "WAVE")) return Format::Wav;
+    if (header.startsWith("FORM") && (startsWith(header, 8, "AIFF") || startsWith(header, 8, "AIFC"))) {
+        return Format::Aiff;
+    }
+    if (header.startsWith("MAC ")) return Format::Ape;
+    if (header.startsWith("wvpk")) return Format::WavPack;
+    if (header.startsWith("TTA1")) return Format::TrueAudio;
+    if (header.startsWith("MPCK") || header.startsWith("MP+")) return Format::Mpc;
+    if (header.startsWith("\x30\x26\xB2\x75\x8E\x66\xCF\x11")) return Format::Asf;
+    if (header.startsWith("DSD ")) return Format::Dsf;
+    if (header.startsWith("FRM8") && startsWith(header, 12, "DSD ")) return Format::Dsdiff;
+    // Matroska is only known by its extension, the EBML header looks the same for videos
+    if (isMpegFrame(header)) return Format::Mpeg;
+
+    return Format::Unknown;
+}
+
+Format classify(const QString& filePath, const Match match) {
+    const QStringView extension = extensionOf(filePath);
+    const ExtensionEntry* entry = findExtension(extension);
+
+    if (entry != nullptr && !entry->ambiguous) return entry->format;
+    if (match == Match::ExtensionOnly) return entry != nullptr ? entry->format : Format::Unknown;
+    // Any other extension belongs to something that is not audio, or that TagLib cannot read
+    if (entry == nullptr && !extension.isEmpty()) return Format::Unknown;
+
+    const Format sniffed = sniff(filePath);
+
+    // An .ogg that is not one of the known codecs is still left to TagLib to decide
+    if (sniffed == Format::Unknown && entry != nullptr) return entry->format;
+
+    return sniffed;
+}
+
+Format classify(const QUrl& url, const Match match) {
+    if (url.isLocalFile()) return classify(url.toLocalFile(), match);
+
+    return fromFileName(url.fileName());
+}
+
+} // namespace AudioClassifier
@@ -0,0 +1,57 @@
+#ifndef AUDIOCLASSIFIER_H
+#define AUDIOCLASSIFIER_H
+
+#include <QByteArrayView>
+#include <QString>
+#include <QStringView>
+#include <QUrl>
+
+#include <cstdint>
+
+// Cheap replacement for QMimeDatabase when all we need to know is which audio format a file has.
+// The extension decides whenever it is unambiguous, only the rest is sniffed from the first bytes.
+namespace AudioClassifier {
+
+enum class Format : std::uint8_t {
+    Unknown,
+    Mpeg,
+    Flac,
+    OggVorbis,
+    OggOpus,
+    OggFlac,
+    OggSpeex,
+    Mp4,
+    Asf,
+    Wav,
+    Aiff,
+    Ape,
+    Mpc,
+    WavPack,
+    TrueAudio,
+    Dsf,
+    Dsdiff,
+    Matroska,
+};
+
+inline constexpr int FormatCount = static_cast<int>(Format::Matroska) + 1;
+
+enum class Match : std::uint8_t {
+    ExtensionOnly,     // never opens the file, unknown extensions are not audio
+    ExtensionAndMagic, // reads the first bytes for ambiguous extensions and files without one
+};
+
+// Format by extension alone, Ogg containers report Vorbis since the codec cannot be told from the name
+[[nodiscard]] Format fromFileName(QStringView fileName);
+// Format by the first bytes of a file, at least 36 are needed to tell the Ogg codecs apart
+[[nodiscard]] Format fromHeader(QByteArrayView header);
+
+[[nodiscard]] Format classify(const QString& filePath, Match match = Match::ExtensionAndMagic);
+[[nodiscard]] Format classify(const QUrl& url, Match match = Match::ExtensionAndMagic);
+
+[[nodiscard]] constexpr bool isAudio(const Format format) {
+    return format != Format::Unknown;
+}
+
+} // namespace AudioClassifier
+
+#endif // AUDIOCLASSIFIER_H
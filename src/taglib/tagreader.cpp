@@ -4,6 +4,8 @@
 #include <taglib/apefile.h>
 #include <taglib/asffile.h>
 #include <taglib/attachedpictureframe.h>
+#include <taglib/dsdifffile.h>
+#include <taglib/dsffile.h>
 #include <taglib/flacfile.h>
 #include <taglib/mp4file.h>
 #include <taglib/mpcfile.h>
@@ -17,10 +19,14 @@
 #include <taglib/tpropertymap.h>
 #include <taglib/trueaudiofile.h>
 #include <taglib/tstring.h>
+#include <taglib/tvariant.h>
 #include <taglib/vorbisfile.h>
 #include <taglib/wavfile.h>
 #include <taglib/wavpackfile.h>
 
+#include <array>
+#include <type_traits>
+
 namespace {
 
 // Docs:    https://id3.org/id3v2.3.0
@@ -66,125 +72,271 @@ constexpr auto MP4_DiscNumber2 = "----:com.apple.iTunes:disc";
 constexpr auto MP4_Lyrics = "\251lyr";
 constexpr auto MP4_CoverArt = "covr";
 
+void addCover(const TagLib::ByteVector& picture, const TagReader::ReadProfile profile, TrackTags& result) {
+    if (profile == TagReader::ReadProfile::Scan) {
+        result.addCoverInfo(static_cast<qsizetype>(picture.size()));
+    } else {
+        result.addCoverImage({picture.data(), static_cast<qsizetype>(picture.size())});
+    }
+}
+
 } // namespace
 
-TagReader::TagReader() = default;
+// Ogg codecs carry a Xiph comment, MPEG, WAV, TrueAudio and DSDIFF an optional ID3v2 tag.
+// Everything else only gets the generic property map.
+template <typename FileType>
+struct TagReader::FormatReader {
+    static void read(const TagReader& reader, FileType& file, const ReadProfile profile, TrackTags& result) {
+        if constexpr (std::is_base_of_v<TagLib::Ogg::File, FileType>) {
+            if (auto* xiphComment = file.tag()) {
+                reader.readVorbisComments(xiphComment, result);
+                addCover(reader.extractFlacCover(xiphComment), profile, result);
+            }
+        } else if constexpr (requires { file.hasID3v2Tag(); }) {
+            if (file.hasID3v2Tag()) {
+                reader.readID3v2Tags(file.ID3v2Tag(), profile, result);
+            }
+        }
+    }
 
-void TagReader::readMetadata(const QString& fileName, TrackTags& result) const {
-    if (fileName.isEmpty()) return;
+    static TagLib::ByteVector cover(const TagReader& reader, FileType& file) {
+        if constexpr (std::is_base_of_v<TagLib::Ogg::File, FileType>) {
+            if (auto* xiphComment = file.tag()) {
+                return reader.extractFlacCover(xiphComment);
+            }
+        } else if constexpr (requires { file.hasID3v2Tag(); }) {
+            if (file.hasID3v2Tag()) {
+                return reader.extractID3v2Cover(file.ID3v2Tag());
+            }
+        }
+        return {};
+    }
+};
+
+template <>
+struct TagReader::FormatReader<TagLib::FLAC::File> {
+    static void read(const TagReader& reader, TagLib::FLAC::File& file, const ReadProfile profile,
+                     TrackTags& result) {
+        if (file.hasXiphComment()) {
+            auto* xiphComment = file.xiphComment();
+            reader.readVorbisComments(xiphComment, result);
+            addCover(reader.extractFlacCover(xiphComment), profile, result);
+        } else if (file.hasID3v2Tag()) {
+            reader.readID3v2Tags(file.ID3v2Tag(), profile, result);
+        }
+    }
 
-    const auto fileRef = std::make_unique<TagLib::FileRef>(fileName.toUtf8().constData());
+    static TagLib::ByteVector cover(const TagReader& reader, TagLib::FLAC::File& file) {
+        if (file.hasXiphComment()) return reader.extractFlacCover(file.xiphComment());
+        if (file.hasID3v2Tag()) return reader.extractID3v2Cover(file.ID3v2Tag());
+        return {};
+    }
+};
 
-    if (!fileRef || fileRef->isNull() || fileRef->file() == nullptr || fileRef->tag() == nullptr) {
-        qDebug() << "Cannot read metadata: file is null";
-        return;
+template <>
+struct TagReader::FormatReader<TagLib::RIFF::AIFF::File> {
+    static void read(const TagReader& reader, TagLib::RIFF::AIFF::File& file, const ReadProfile profile,
+                     TrackTags& result) {
+        reader.readID3v2Tags(file.tag(), profile, result);
     }
 
-    if (const auto* properties = fileRef->audioProperties()) {
-        result.add(Metadata::Fields::BitRate, properties->bitrate() * 1000);
-        result.add(Metadata::Fields::Duration, properties->lengthInSeconds());
-        result.add(Metadata::Fields::Channels, properties->channels());
-        result.add(Metadata::Fields::SampleRate, properties->sampleRate());
+    static TagLib::ByteVector cover(const TagReader& reader, TagLib::RIFF::AIFF::File& file) {
+        return reader.extractID3v2Cover(file.tag());
     }
+};
 
-    TagLib::File* file = fileRef->file();
-    readGenericMetadata(file->properties(), result);
+template <>
+struct TagReader::FormatReader<TagLib::DSF::File> {
+    static void read(const TagReader& reader, TagLib::DSF::File& file, const ReadProfile profile, TrackTags& result) {
+        if (file.tag() != nullptr) {
+            reader.readID3v2Tags(file.tag(), profile, result);
+        }
+    }
 
-    if (auto* flac_file = dynamic_cast<TagLib::FLAC::File*>(file)) {
-        result.add(Metadata::Fields::FileType, QStringLiteral("FLAC"));
+    static TagLib::ByteVector cover(const TagReader& reader, TagLib::DSF::File& file) {
+        return file.tag() != nullptr ? reader.extractID3v2Cover(file.tag()) : TagLib::ByteVector{};
+    }
+};
 
-        if (flac_file->hasXiphComment()) {
-            auto* xiphComment = flac_file->xiphComment();
-            readVorbisComments(xiphComment, result);
-            result.addCoverImage(extractFlacCover(xiphComment));
-        } else if (flac_file->hasID3v2Tag()) {
-            readID3v2Tags(flac_file->ID3v2Tag(), result);
+template <>
+struct TagReader::FormatReader<TagLib::MP4::File> {
+    static void read(const TagReader& reader, TagLib::MP4::File& file, const ReadProfile profile, TrackTags& result) {
+        if (file.tag() != nullptr) {
+            reader.readMP4Tags(file.tag(), profile, result);
         }
+    }
 
-    } else if (dynamic_cast<TagLib::Ogg::File*>(file) != nullptr) {
-        if (auto* xiphComment = dynamic_cast<TagLib::Ogg::XiphComment*>(file->tag())) {
-            readVorbisComments(xiphComment, result);
-            result.addCoverImage(extractFlacCover(xiphComment));
+    static TagLib::ByteVector cover(const TagReader& reader, TagLib::MP4::File& file) {
+        return file.tag() != nullptr ? reader.extractMP4Cover(file.tag()) : TagLib::ByteVector{};
+    }
+};
+
+struct TagReader::FormatHandler {
+    std::unique_ptr<TagLib::File> (*open)(TagLib::FileName fileName, bool readProperties,
+                                          TagLib::AudioProperties::ReadStyle readStyle) = nullptr;
+    void (*read)(const TagReader& reader, TagLib::File& file, ReadProfile profile, TrackTags& result) = nullptr;
+    TagLib::ByteVector (*cover)(const TagReader& reader, TagLib::File& file) = nullptr;
+    const char* fileType = nullptr;
+
+    // The concrete type is known from the table entry, so the casts below need no RTTI
+    template <typename FileType>
+    static constexpr FormatHandler make(const char* name) {
+        return {.open = [](const TagLib::FileName fileName, const bool readProperties,
+                           const TagLib::AudioProperties::ReadStyle readStyle) -> std::unique_ptr<TagLib::File> {
+                    return std::make_unique<FileType>(fileName, readProperties, readStyle);
+                },
+                .read =
+                    [](const TagReader& reader, TagLib::File& file, const ReadProfile profile, TrackTags& result) {
+                        FormatReader<FileType>::read(reader, static_cast<FileType&>(file), profile, result);
+                    },
+                .cover = [](const TagReader& reader, TagLib::File& file) -> TagLib::ByteVector {
+                    return FormatReader<FileType>::cover(reader, static_cast<FileType&>(file));
+                },
+                .fileType = name};
+    }
+
+    static constexpr FormatHandler forFormat(const AudioClassifier::Format format) {
+        using AudioClassifier::Format;
+
+        switch (format) {
+        case Format::Mpeg:
+            return make<TagLib::MPEG::File>("MPEG");
+        case Format::Flac:
+            return make<TagLib::FLAC::File>("FLAC");
+        case Format::OggVorbis:
+            return make<TagLib::Ogg::Vorbis::File>("Vorbis");
+        case Format::OggOpus:
+            return make<TagLib::Ogg::Opus::File>("Opus");
+        case Format::OggFlac:
+            return make<TagLib::Ogg::FLAC::File>("FLAC");
+        case Format::OggSpeex:
+            return make<TagLib::Ogg::Speex::File>("Speex");
+        case Format::Mp4:
+            return make<TagLib::MP4::File>("MPEG-4");
+        case Format::Asf:
+            return make<TagLib::ASF::File>(nullptr);
+        case Format::Wav:
+            return make<TagLib::RIFF::WAV::File>("WAV");
+        case Format::Aiff:
+            return make<TagLib::RIFF::AIFF::File>("AIFF");
+        case Format::Ape:
+            return make<TagLib::APE::File>(nullptr);
+        case Format::Mpc:
+            return make<TagLib::MPC::File>(nullptr);
+        case Format::WavPack:
+            return make<TagLib::WavPack::File>(nullptr);
+        case Format::TrueAudio:
+            return make<TagLib::TrueAudio::File>("TTA");
+        case Format::Dsf:
+            return make<TagLib::DSF::File>("DSF");
+        case Format::Dsdiff:
+            return make<TagLib::DSDIFF::File>("DSDIFF");
+        // Matroska needs a newer TagLib than the one required, FileRef reads it where it is available
+        case Format::Matroska:
+        case Format::Unknown:
+        default:
+            return {};
         }
+    }
+};
 
-        if (dynamic_cast<TagLib::Ogg::FLAC::File*>(file) != nullptr) {
-            result.add(Metadata::Fields::FileType, QStringLiteral("FLAC"));
-        } else if (dynamic_cast<TagLib::Ogg::Vorbis::File*>(file) != nullptr) {
-            result.add(Metadata::Fields::FileType, QStringLiteral("Vorbis"));
-        } else if (dynamic_cast<TagLib::Ogg::Speex::File*>(file) != nullptr) {
-            result.add(Metadata::Fields::FileType, QStringLiteral("Speex"));
-        } else if (dynamic_cast<TagLib::Ogg::Opus::File*>(file) != nullptr) {
-            result.add(Metadata::Fields::FileType, QStringLiteral("Opus"));
-        }
+TagReader::TagReader() = default;
 
-    } else if (auto* mpeg_file = dynamic_cast<TagLib::MPEG::File*>(file)) {
-        result.add(Metadata::Fields::FileType, QStringLiteral("MPEG"));
-        if (mpeg_file->hasID3v2Tag()) {
-            readID3v2Tags(mpeg_file->ID3v2Tag(), result);
+const TagReader::FormatHandler& TagReader::handler(const AudioClassifier::Format format) {
+    static constexpr auto handlers = [] {
+        std::array<FormatHandler, AudioClassifier::FormatCount> table{};
+        for (int i = 0; i < AudioClassifier::FormatCount; ++i) {
+            table[static_cast<std::size_t>(i)] = FormatHandler::forFormat(static_cast<AudioClassifier::Format>(i));
         }
+        return table;
+    }();
 
-    } else if (const auto* mp4_file = dynamic_cast<TagLib::MP4::File*>(file)) {
-        result.add(Metadata::Fields::FileType, QStringLiteral("MPEG-4"));
-        if (mp4_file->tag() != nullptr) {
-            readMP4Tags(mp4_file->tag(), result);
-        }
+    return handlers[static_cast<std::size_t>(format)];
+}
 
-    } else if (const auto* wav_file = dynamic_cast<TagLib::RIFF::WAV::File*>(file)) {
-        result.add(Metadata::Fields::FileType, QStringLiteral("WAV"));
-        if (wav_file->hasID3v2Tag()) {
-            readID3v2Tags(wav_file->ID3v2Tag(), result);
-        }
+void TagReader::readMetadata(const QString& fileName, TrackTags& result, const ReadProfile profile) const {
+    readMetadata(fileName, AudioClassifier::classify(fileName), result, profile);
+}
+
+void TagReader::readMetadata(const QString& fileName, const AudioClassifier::Format format, TrackTags& result,
+                             const ReadProfile profile) const {
+    if (fileName.isEmpty()) return;
 
-    } else if (const auto* riff_file = dynamic_cast<TagLib::RIFF::AIFF::File*>(file)) {
-        result.add(Metadata::Fields::FileType, QStringLiteral("AIFF"));
-        readID3v2Tags(riff_file->tag(), result);
+    // Fast skips the bitrate and length estimation passes that need more than the first frames
+    const auto readStyle =
+        profile == ReadProfile::Scan ? TagLib::AudioProperties::Fast : TagLib::AudioProperties::Average;
+    const QByteArray encodedName = fileName.toUtf8();
+    const FormatHandler& formatHandler = handler(format);
 
-    } else if (auto* trueaudio_file = dynamic_cast<TagLib::TrueAudio::File*>(file)) {
-        result.add(Metadata::Fields::FileType, QStringLiteral("TTA"));
-        if (trueaudio_file->hasID3v2Tag()) {
-            readID3v2Tags(trueaudio_file->ID3v2Tag(), result);
-        }
+    std::unique_ptr<TagLib::File> file;
+    std::unique_ptr<TagLib::FileRef> fileRef;
+
+    if (formatHandler.open != nullptr) {
+        file = formatHandler.open(encodedName.constData(), true, readStyle);
+    }
+
+    TagLib::File* target = file.get();
+
+    // Unknown or misclassified files are left to TagLib's own detection, without the format specific tags
+    if (target == nullptr || !target->isValid()) {
+        file.reset();
+        fileRef = std::make_unique<TagLib::FileRef>(encodedName.constData(), true, readStyle);
+        target = fileRef->isNull() ? nullptr : fileRef->file();
+    }
+
+    if (target == nullptr || target->tag() == nullptr) {
+        qDebug() << "Cannot read metadata: file is null";
+        return;
+    }
+
+    if (const auto* properties = target->audioProperties()) {
+        result.add(Metadata::Fields::BitRate, properties->bitrate() * 1000);
+        result.add(Metadata::Fields::Duration, properties->lengthInSeconds());
+        result.add(Metadata::Fields::Channels, properties->channels());
+        result.add(Metadata::Fields::SampleRate, properties->sampleRate());
+    }
+
+    readGenericMetadata(target->properties(), result);
+
+    if (!file) return;
+
+    if (formatHandler.fileType != nullptr) {
+        result.add(Metadata::Fields::FileType, QString::fromLatin1(formatHandler.fileType));
     }
+
+    formatHandler.read(*this, *file, profile, result);
 }
 
 void TagReader::extractCoverArt(const QString& fileName, TrackTags& result) const {
-    if (fileName.isEmpty()) return;
-
-    const auto fileRef = std::make_unique<TagLib::FileRef>(fileName.toUtf8().constData());
+    extractCoverArt(fileName, AudioClassifier::classify(fileName), result);
+}
 
-    if (!fileRef || fileRef->isNull() || fileRef->file() == nullptr || fileRef->tag() == nullptr) return;
+void TagReader::extractCoverArt(const QString& fileName, const AudioClassifier::Format format,
+                                TrackTags& result) const {
+    if (fileName.isEmpty()) return;
 
-    TagLib::File* file = fileRef->file();
+    const QByteArray encodedName = fileName.toUtf8();
+    const FormatHandler& formatHandler = handler(format);
 
-    if (auto* flac_file = dynamic_cast<TagLib::FLAC::File*>(file)) {
-        if (flac_file->hasXiphComment()) {
-            result.addCoverImage(extractFlacCover(flac_file->xiphComment()));
-        } else if (flac_file->hasID3v2Tag()) {
-            result.addCoverImage(extractID3v2Cover(flac_file->ID3v2Tag()));
-        }
-    } else if (const auto* ogg_file = dynamic_cast<TagLib::Ogg::File*>(file)) {
-        if (auto* xiphComment = dynamic_cast<TagLib::Ogg::XiphComment*>(ogg_file->tag())) {
-            result.addCoverImage(extractFlacCover(xiphComment));
-        }
-    } else if (auto* mpeg_file = dynamic_cast<TagLib::MPEG::File*>(file)) {
-        if (mpeg_file->hasID3v2Tag()) {
-            result.addCoverImage(extractID3v2Cover(mpeg_file->ID3v2Tag()));
-        }
-    } else if (const auto* mp4_file = dynamic_cast<TagLib::MP4::File*>(file)) {
-        if (mp4_file->tag() != nullptr) {
-            result.addCoverImage(extractMP4Cover(mp4_file->tag()));
-        }
-    } else if (const auto* wav_file = dynamic_cast<TagLib::RIFF::WAV::File*>(file)) {
-        if (wav_file->hasID3v2Tag()) {
-            result.addCoverImage(extractID3v2Cover(wav_file->ID3v2Tag()));
-        }
-    } else if (const auto* riff_file = dynamic_cast<TagLib::RIFF::AIFF::File*>(file)) {
-        result.addCoverImage(extractID3v2Cover(riff_file->tag()));
-    } else if (auto* trueaudio_file = dynamic_cast<TagLib::TrueAudio::File*>(file)) {
-        if (trueaudio_file->hasID3v2Tag()) {
-            result.addCoverImage(extractID3v2Cover(trueaudio_file->ID3v2Tag()));
+    // Audio properties are not needed for the picture
+    if (formatHandler.open != nullptr) {
+        const auto file = formatHandler.open(encodedName.constData(), false, TagLib::AudioProperties::Average);
+        if (file->isValid()) {
+            addCover(formatHandler.cover(*this, *file), ReadProfile::Full, result);
+            return;
         }
     }
+
+    // Unknown or misclassified files are left to TagLib's own detection, which hands out pictures as complex
+    // properties
+    const TagLib::FileRef fileRef(encodedName.constData(), false);
+    if (fileRef.isNull()) return;
+
+    const auto pictures = fileRef.complexProperties("PICTURE");
+    if (pictures.isEmpty()) return;
+
+    const TagLib::ByteVector picture = pictures.front().value("data").toByteVector();
+    if (!picture.isEmpty()) addCover(picture, ReadProfile::Full, result);
 }
 
 void TagReader::readGenericMetadata(const TagLib::PropertyMap& properties, TrackTags& result) const {
@@ -238,56 +390,57 @@ bool TagReader::readGenericField(const TagLib::PropertyMap& properties, const st
     if (properties.contains(tagName)) {
         const auto values = properties[tagName];
         for (const auto& value : values) {
-            result.add(field, TStringToQString(value).trimmed());
+            result.addText(field, value);
         }
         return true;
     }
     return false;
 }
 
-void TagReader::readID3v2Tags(const TagLib::ID3v2::Tag* id3Tags, const TrackTags& result) const {
-    if (id3Tags->isEmpty()) return;
+void TagReader::readID3v2Tags(const TagLib::ID3v2::Tag* id3Tags, const ReadProfile profile,
+                              TrackTags& result) const {
+    if (id3Tags == nullptr || id3Tags->isEmpty()) return;
 
     const auto& map = id3Tags->frameListMap();
 
     if (map.contains(ID3v2_Title)) {
         const auto title = map[ID3v2_Title].front()->toString();
-        result.add(Metadata::Fields::Title, TStringToQString(title));
+        result.addText(Metadata::Fields::Title, title);
     }
 
     if (map.contains(ID3v2_Artist)) {
         const auto artist = map[ID3v2_Artist].front()->toString();
-        result.add(Metadata::Fields::Artist, TStringToQString(artist));
+        result.addText(Metadata::Fields::Artist, artist);
     }
 
     if (map.contains(ID3v2_Album)) {
         const auto album = map[ID3v2_Album].front()->toString();
-        result.add(Metadata::Fields::Album, TStringToQString(album));
+        result.addText(Metadata::Fields::Album, album);
     }
 
     if (map.contains(ID3v2_AlbumArtist)) {
         const auto albumArtist = map[ID3v2_AlbumArtist].front()->toString();
-        result.add(Metadata::Fields::AlbumArtist, TStringToQString(albumArtist));
+        result.addText(Metadata::Fields::AlbumArtist, albumArtist);
     }
 
     if (map.contains(ID3v2_Genre)) {
         const auto genre = map[ID3v2_Genre].front()->toString();
-        result.add(Metadata::Fields::Genre, TStringToQString(genre));
+        result.addText(Metadata::Fields::Genre, genre);
     }
 
     if (map.contains(ID3v2_Performer)) {
         const auto performer = map[ID3v2_Performer].front()->toString();
-        result.add(Metadata::Fields::Performer, TStringToQString(performer));
+        result.addText(Metadata::Fields::Performer, performer);
     }
 
     if (map.contains(ID3v2_Composer)) {
         const auto composer = map[ID3v2_Composer].front()->toString();
-        result.add(Metadata::Fields::Composer, TStringToQString(composer));
+        result.addText(Metadata::Fields::Composer, composer);
     }
 
     if (map.contains(ID3v2_Comment)) {
         const auto comment = map[ID3v2_Comment].front()->toString();
-        result.add(Metadata::Fields::Comment, TStringToQString(comment));
+        result.addText(Metadata::Fields::Comment, comment);
     }
 
     if (map.contains(ID3v2_Date)) {
@@ -310,14 +463,14 @@ void TagReader::readID3v2Tags(const TagLib::ID3v2::Tag* id3Tags, const TrackTags
 
     if (map.contains(ID3v2_SynchronizedLyrics)) {
         const auto lyrics = map[ID3v2_SynchronizedLyrics].front()->toString();
-        result.add(Metadata::Fields::Lyrics, TStringToQString(lyrics));
+        result.addText(Metadata::Fields::Lyrics, lyrics);
     } else if (map.contains(ID3v2_UnsychronizedLyrics)) {
         const auto lyrics = map[ID3v2_UnsychronizedLyrics].front()->toString();
-        result.add(Metadata::Fields::Lyrics, TStringToQString(lyrics));
+        result.addText(Metadata::Fields::Lyrics, lyrics);
     }
 
     if (map.contains(ID3v2_CoverArt)) {
-        result.addCoverImage(extractID3v2Cover(id3Tags));
+        addCover(extractID3v2Cover(id3Tags), profile, result);
     }
 }
 
@@ -328,20 +481,20 @@ void TagReader::readVorbisComments(TagLib::Ogg::XiphComment* xiphComment, TrackT
 
     if (map.contains(VorbisComment_Performer)) {
         const auto performer = map[VorbisComment_Performer].front();
-        result.add(Metadata::Fields::Performer, TStringToQString(performer));
+        result.addText(Metadata::Fields::Performer, performer);
     }
 
     if (map.contains(VorbisComment_Composer)) {
         const auto composer = map[VorbisComment_Composer].front();
-        result.add(Metadata::Fields::Composer, TStringToQString(composer));
+        result.addText(Metadata::Fields::Composer, composer);
     }
 
     if (map.contains(VorbisComment_AlbumArtist1)) {
         const auto albumArtist = map[VorbisComment_AlbumArtist1].front();
-        result.add(Metadata::Fields::AlbumArtist, TStringToQString(albumArtist));
+        result.addText(Metadata::Fields::AlbumArtist, albumArtist);
     } else if (map.contains(VorbisComment_AlbumArtist2)) {
         const auto albumArtist = map[VorbisComment_AlbumArtist2].front();
-        result.add(Metadata::Fields::AlbumArtist, TStringToQString(albumArtist));
+        result.addText(Metadata::Fields::AlbumArtist, albumArtist);
     }
 
     if (map.contains(VorbisComment_DiscNumber)) {
@@ -351,26 +504,26 @@ void TagReader::readVorbisComments(TagLib::Ogg::XiphComment* xiphComment, TrackT
 
     if (map.contains(VorbisComment_Lyrics)) {
         const auto lyrics = map[VorbisComment_Lyrics].front();
-        result.add(Metadata::Fields::Lyrics, TStringToQString(lyrics));
+        result.addText(Metadata::Fields::Lyrics, lyrics);
     } else if (map.contains(VorbisComment_UnsyncedLyrics)) {
         const auto lyrics = map[VorbisComment_UnsyncedLyrics].front();
-        result.add(Metadata::Fields::Lyrics, TStringToQString(lyrics));
+        result.addText(Metadata::Fields::Lyrics, lyrics);
     }
 }
 
-void TagReader::readMP4Tags(const TagLib::MP4::Tag* mp4Tags, TrackTags& result) const {
+void TagReader::readMP4Tags(const TagLib::MP4::Tag* mp4Tags, const ReadProfile profile, TrackTags& result) const {
     if (mp4Tags->isEmpty()) return;
 
     const auto& map = mp4Tags->itemMap();
 
     if (map.contains(MP4_AlbumArtist)) {
         const auto albumArtist = map[MP4_AlbumArtist].toStringList().front();
-        result.add(Metadata::Fields::AlbumArtist, TStringToQString(albumArtist));
+        result.addText(Metadata::Fields::AlbumArtist, albumArtist);
     }
 
     if (map.contains(MP4_Composer)) {
         const auto composer = map[MP4_Composer].toStringList().toString(", ");
-        result.add(Metadata::Fields::Composer, TStringToQString(composer));
+        result.addText(Metadata::Fields::Composer, composer);
     }
 
     if (map.contains(MP4_TrackNumber)) {
@@ -391,21 +544,21 @@ void TagReader::readMP4Tags(const TagLib::MP4::Tag* mp4Tags, TrackTags& result)
 
     if (map.contains(MP4_Lyrics)) {
         const auto lyrics = map[MP4_Lyrics].toStringList().toString(" ");
-        result.add(Metadata::Fields::Lyrics, TStringToQString(lyrics));
+        result.addText(Metadata::Fields::Lyrics, lyrics);
     }
 
     if (map.contains(MP4_Comment)) {
         const auto comment = map[MP4_Comment].toStringList().toString(" ");
-        result.add(Metadata::Fields::Comment, TStringToQString(comment));
+        result.addText(Metadata::Fields::Comment, comment);
     }
 
     if (map.contains(MP4_CoverArt)) {
-        result.addCoverImage(extractMP4Cover(mp4Tags));
+        addCover(extractMP4Cover(mp4Tags), profile, result);
     }
 }
 
-QByteArray TagReader::extractID3v2Cover(const TagLib::ID3v2::Tag* id3Tags) const {
-    if (id3Tags->isEmpty()) {
+TagLib::ByteVector TagReader::extractID3v2Cover(const TagLib::ID3v2::Tag* id3Tags) const {
+    if (id3Tags == nullptr || id3Tags->isEmpty()) {
         return {};
     }
 
@@ -416,10 +569,14 @@ QByteArray TagReader::extractID3v2Cover(const TagLib::ID3v2::Tag* id3Tags) const
     }
 
     const auto* pictureFrame = dynamic_cast<TagLib::ID3v2::AttachedPictureFrame*>(frameList.front());
-    return {pictureFrame->picture().data(), pictureFrame->picture().size()};
+    if (pictureFrame == nullptr) {
+        return {};
+    }
+
+    return pictureFrame->picture();
 }
 
-QByteArray TagReader::extractFlacCover(TagLib::Ogg::XiphComment* xiphComment) const {
+TagLib::ByteVector TagReader::extractFlacCover(TagLib::Ogg::XiphComment* xiphComment) const {
     if (xiphComment->isEmpty()) {
         return {};
     }
@@ -435,11 +592,10 @@ QByteArray TagReader::extractFlacCover(TagLib::Ogg::XiphComment* xiphComment) co
         return {};
     }
 
-    const auto* pictureFront = pictureList.front();
-    return {pictureFront->data().data(), pictureFront->data().size()};
+    return pictureList.front()->data();
 }
 
-QByteArray TagReader::extractMP4Cover(const TagLib::MP4::Tag* mp4Tags) const {
+TagLib::ByteVector TagReader::extractMP4Cover(const TagLib::MP4::Tag* mp4Tags) const {
     if (mp4Tags->isEmpty()) {
         return {};
     }
@@ -454,6 +610,5 @@ QByteArray TagReader::extractMP4Cover(const TagLib::MP4::Tag* mp4Tags) const {
         return {};
     }
 
-    const auto& coverArtFront = coverArtList.front();
-    return {coverArtFront.data().data(), coverArtFront.data().size()};
+    return coverArtList.front().data();
 }
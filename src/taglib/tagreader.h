@@ -1,35 +1,56 @@
 #ifndef TAGREADER_H
 #define TAGREADER_H
 
+#include "taglib/audioclassifier.h"
 #include "taglib/tracktags.h"
 
 #include <taglib/fileref.h>
 #include <taglib/id3v2tag.h>
 #include <taglib/mp4tag.h>
+#include <taglib/tbytevector.h>
 #include <taglib/xiphcomment.h>
 
 #include <QString>
 
+#include <cstdint>
+
 class TagReader {
 public:
+    enum class ReadProfile : std::uint8_t {
+        Full, // accurate audio properties, embedded cover copied into the result
+        Scan, // fast audio properties, only the presence and size of the cover are recorded
+    };
+
     TagReader();
     ~TagReader() = default;
-    void readMetadata(const QString& fileName, TrackTags& result) const;
+    void readMetadata(const QString& fileName, TrackTags& result, ReadProfile profile = ReadProfile::Full) const;
+    // Skips classification when the caller already knows the format
+    void readMetadata(const QString& fileName, AudioClassifier::Format format, TrackTags& result,
+                      ReadProfile profile = ReadProfile::Full) const;
     void extractCoverArt(const QString& fileName, TrackTags& result) const;
+    void extractCoverArt(const QString& fileName, AudioClassifier::Format format, TrackTags& result) const;
 
 private:
+    // Specialized for every concrete TagLib file type, selected through the format dispatch table
+    template <typename FileType>
+    struct FormatReader;
+    struct FormatHandler;
+
+    [[nodiscard]] static const FormatHandler& handler(AudioClassifier::Format format);
+
     void readGenericMetadata(const TagLib::PropertyMap& properties, TrackTags& result) const;
 
     bool readGenericField(const TagLib::PropertyMap& properties, const std::string& tagName, Metadata::Fields field,
                           TrackTags& result) const;
 
-    void readID3v2Tags(const TagLib::ID3v2::Tag* id3Tags, const TrackTags& result) const;
+    void readID3v2Tags(const TagLib::ID3v2::Tag* id3Tags, ReadProfile profile, TrackTags& result) const;
     void readVorbisComments(TagLib::Ogg::XiphComment* xiphComment, TrackTags& result) const;
-    void readMP4Tags(const TagLib::MP4::Tag* mp4Tags, TrackTags& result) const;
+    void readMP4Tags(const TagLib::MP4::Tag* mp4Tags, ReadProfile profile, TrackTags& result) const;
 
-    QByteArray extractID3v2Cover(const TagLib::ID3v2::Tag* id3Tags) const;
-    QByteArray extractFlacCover(TagLib::Ogg::XiphComment* xiphComment) const;
-    QByteArray extractMP4Cover(const TagLib::MP4::Tag* mp4Tags) const;
+    // The returned vectors share their data with the tag, nothing is copied until the cover is stored
+    TagLib::ByteVector extractID3v2Cover(const TagLib::ID3v2::Tag* id3Tags) const;
+    TagLib::ByteVector extractFlacCover(TagLib::Ogg::XiphComment* xiphComment) const;
+    TagLib::ByteVector extractMP4Cover(const TagLib::MP4::Tag* mp4Tags) const;
 };
 
 #endif // TAGREADER_H
@@ -1,45 +1,169 @@
 #include "taglib/tracktags.h"
 
-class TrackTagsPrivate {
-public:
-    QString m_fileName;
-    QByteArray m_coverImage;
-    QMultiMap<Metadata::Fields, QVariant> m_fieldMapping;
-};
+#include <taglib/tstring.h>
 
-TrackTags::TrackTags(const QString& fileName) : tt(std::make_unique<TrackTagsPrivate>()) {
-    tt->m_fileName = fileName;
+#include <QLocale>
+
+#include <algorithm>
+
+QVariant TrackTags::Tag::toVariant() const {
+    return isText ? QVariant{text.toString()} : value;
 }
 
-TrackTags::~TrackTags() = default;
+TrackTags::TrackTags(const QString& fileName, std::pmr::memory_resource* upstream)
+    : m_fileName(fileName), m_textArena(m_textBuffer.data(), m_textBuffer.size(), upstream) {}
 
 QString TrackTags::fileName() const {
-    return tt->m_fileName;
+    return m_fileName;
 }
 
 QByteArray TrackTags::coverImage() const {
-    return tt->m_coverImage;
+    return m_coverImage;
+}
+
+qsizetype TrackTags::coverSize() const {
+    return m_coverSize;
+}
+
+const TrackTags::TagList& TrackTags::tags() const {
+    return m_tags;
 }
 
-const QMultiMap<Metadata::Fields, QVariant>& TrackTags::fieldMapping() const {
-    return tt->m_fieldMapping;
+bool TrackTags::contains(const Metadata::Fields field) const {
+    return (m_present & bit(field)) != 0;
 }
 
 QVariant TrackTags::value(const Metadata::Fields field) const {
-    return tt->m_fieldMapping.value(field);
+    if (!contains(field)) return {};
+
+    for (const Tag& tag : m_tags) {
+        if (tag.field == field) return tag.toVariant();
+    }
+
+    return {};
+}
+
+void TrackTags::add(const Metadata::Fields field, const QVariant& value) {
+    // Only fields that were seen before need the list to be searched
+    if (contains(field)) {
+        for (const Tag& tag : std::as_const(m_tags)) {
+            if (tag.field != field) continue;
+            if (tag.isText ? tag.text == value.toString() : tag.value == value) return;
+        }
+        m_repeated |= bit(field);
+    }
+
+    m_present |= bit(field);
+    m_tags.append({.field = field, .value = value, .text = {}, .isText = false});
+}
+
+void TrackTags::addText(const Metadata::Fields field, QStringView text) {
+    text = text.trimmed();
+    if (hasText(field, text)) return;
+
+    char16_t* storage = allocateText(text.size());
+    std::copy(text.utf16(), text.utf16() + text.size(), storage);
+    appendText(field, QStringView{storage, text.size()});
+}
+
+void TrackTags::addText(const Metadata::Fields field, const TagLib::String& text) {
+    // wchar_t holds UTF-32 or UTF-16 depending on the platform, neither needs more than two UTF-16 units a char
+    char16_t* storage = allocateText(2 * static_cast<qsizetype>(text.size()));
+    qsizetype length = 0;
+
+    for (const wchar_t c : text) {
+        const auto codePoint = static_cast<char32_t>(c);
+        if (QChar::requiresSurrogates(codePoint)) {
+            storage[length++] = QChar::highSurrogate(codePoint);
+            storage[length++] = QChar::lowSurrogate(codePoint);
+        } else {
+            storage[length++] = static_cast<char16_t>(codePoint);
+        }
+    }
+
+    // The converted text stays in the arena even if it turns out to be a duplicate
+    const QStringView converted = QStringView{storage, length}.trimmed();
+    if (hasText(field, converted)) return;
+
+    appendText(field, converted);
 }
 
-void TrackTags::add(const Metadata::Fields field, const QVariant& value) const {
-    if (tt->m_fieldMapping.values(field).contains(value)) return;
+bool TrackTags::hasText(const Metadata::Fields field, const QStringView text) const {
+    if (!contains(field)) return false;
+
+    for (const Tag& tag : m_tags) {
+        if (tag.field != field) continue;
+        if (tag.isText ? tag.text == text : tag.value.toString() == text) return true;
+    }
+
+    return false;
+}
 
-    tt->m_fieldMapping.insert(field, value);
+char16_t* TrackTags::allocateText(const qsizetype length) {
+    return static_cast<char16_t*>(
+        m_textArena.allocate(static_cast<std::size_t>(qMax<qsizetype>(length, 1)) * sizeof(char16_t),
+                             alignof(char16_t)));
 }
 
-void TrackTags::addCoverImage(const QByteArray& image) const {
+void TrackTags::appendText(const Metadata::Fields field, const QStringView storedText) {
+    if (contains(field)) {
+        m_repeated |= bit(field);
+    }
+
+    m_present |= bit(field);
+    m_tags.append({.field = field, .value = {}, .text = storedText, .isText = true});
+}
+
+void TrackTags::addCoverImage(const QByteArray& image) {
     if (image.isEmpty()) {
         add(Metadata::Fields::HasEmbeddedCover, false);
     } else {
         add(Metadata::Fields::HasEmbeddedCover, true);
-        tt->m_coverImage = image;
+        m_coverImage = image;
+        m_coverSize = image.size();
+    }
+}
+
+void TrackTags::addCoverInfo(const qsizetype size) {
+    add(Metadata::Fields::HasEmbeddedCover, size > 0);
+
+    if (size > 0) {
+        m_coverSize = size;
+    }
+}
+
+void TrackTags::copyTo(Metadata::TrackFields& track) const {
+    const auto isFirstOfField = [this](const qsizetype index) {
+        for (qsizetype i = 0; i < index; ++i) {
+            if (m_tags[i].field == m_tags[index].field) return false;
+        }
+        return true;
+    };
+
+    const QLocale locale;
+
+    for (qsizetype i = 0; i < m_tags.size(); ++i) {
+        const Tag& tag = m_tags[i];
+        const bool repeated = (m_repeated & bit(tag.field)) != 0;
+
+        if (repeated && !isFirstOfField(i)) continue;
+
+        if (tag.field == Metadata::Fields::Duration) {
+            // Read in seconds
+            track.insert(tag.field, QTime::fromMSecsSinceStartOfDay(static_cast<int>(1000 * tag.value.toDouble())));
+        } else if (!repeated) {
+            // The only copy that outlives the tags
+            track.insert(tag.field, tag.toVariant());
+        } else {
+            // Multiple values are rare, so only they pay for the list
+            QStringList values;
+            for (qsizetype j = i; j < m_tags.size(); ++j) {
+                if (m_tags[j].field == tag.field) {
+                    values.append(m_tags[j].toVariant().toString());
+                }
+            }
+
+            track.insert(tag.field, locale.createSeparatedList(values));
+        }
     }
 }
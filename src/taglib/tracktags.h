@@ -3,22 +3,78 @@
 
 #include "metadata.hpp"
 
-class TrackTagsPrivate;
+#include <QVarLengthArray>
 
+#include <array>
+#include <memory_resource>
+
+namespace TagLib {
+class String;
+} // namespace TagLib
+
+// Collects the tags of one file while it is read. Values live inline in insertion order, a bit per field
+// tells which fields were seen, so a typical file is read without a single container allocation.
+// Text is kept in an arena owned by the tags and only becomes a QString once it is copied into the track.
 class TrackTags {
 public:
-    explicit TrackTags(const QString& fileName);
-    ~TrackTags();
+    struct Tag {
+        Metadata::Fields field;
+        QVariant value;   // numbers, flags and text added as QString
+        QStringView text; // text read from the file, points into the arena
+        bool isText = false;
+
+        [[nodiscard]] QVariant toVariant() const;
+    };
+
+    // Enough for every field a well tagged file carries
+    static constexpr qsizetype InlineTags = 24;
+    static constexpr std::size_t InlineTextBytes = 2048;
+    using TagList = QVarLengthArray<Tag, InlineTags>;
+
+    // Text that does not fit the inline buffer is allocated from the upstream resource
+    explicit TrackTags(const QString& fileName,
+                       std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+    TrackTags(const TrackTags&) = delete;
+    TrackTags& operator=(const TrackTags&) = delete;
 
     [[nodiscard]] QString fileName() const;
     [[nodiscard]] QByteArray coverImage() const;
-    [[nodiscard]] const QMultiMap<Metadata::Fields, QVariant>& fieldMapping() const;
+    [[nodiscard]] qsizetype coverSize() const;
+    // Every value in the order it was read, repeated fields keep one entry per distinct value
+    [[nodiscard]] const TagList& tags() const;
+    [[nodiscard]] bool contains(Metadata::Fields field) const;
+    // The first value read for the field
     [[nodiscard]] QVariant value(Metadata::Fields field) const;
-    void add(Metadata::Fields field, const QVariant& value) const;
-    void addCoverImage(const QByteArray& image) const;
+    // Both ignore values the field already has
+    void add(Metadata::Fields field, const QVariant& value);
+    // Copied into the arena without surrounding whitespace
+    void addText(Metadata::Fields field, QStringView text);
+    void addText(Metadata::Fields field, const TagLib::String& text);
+    void addCoverImage(const QByteArray& image);
+    // Records an embedded cover without keeping its data
+    void addCoverInfo(qsizetype size);
+
+    // Writes the collected fields into the track, fields with several values are joined into one list
+    void copyTo(Metadata::TrackFields& track) const;
 
 private:
-    std::unique_ptr<TrackTagsPrivate> tt;
+    [[nodiscard]] static constexpr quint64 bit(const Metadata::Fields field) {
+        return quint64{1} << (field - Metadata::Fields::Title);
+    }
+
+    [[nodiscard]] bool hasText(Metadata::Fields field, QStringView text) const;
+    [[nodiscard]] char16_t* allocateText(qsizetype length);
+    void appendText(Metadata::Fields field, QStringView storedText);
+
+    QString m_fileName;
+    QByteArray m_coverImage;
+    qsizetype m_coverSize = 0;
+    quint64 m_present = 0;
+    quint64 m_repeated = 0;
+    TagList m_tags;
+    std::array<std::byte, InlineTextBytes> m_textBuffer;
+    std::pmr::monotonic_buffer_resource m_textArena;
 };
 
 #endif // TRACKTAGS_H
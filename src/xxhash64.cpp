@@ -0,0 +1,146 @@
+#include "xxhash64.h"
+
+#include <QtEndian>
+
+#include <bit>
+#include <cstring>
+
+namespace {
+
+constexpr quint64 prime1 = 0x9E3779B185EBCA87ULL;
+constexpr quint64 prime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr quint64 prime3 = 0x165667B19E3779F9ULL;
+constexpr quint64 prime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr quint64 prime5 = 0x27D4EB2F165667C5ULL;
+
+quint64 read64(const char* data) {
+    return qFromLittleEndian<quint64>(data);
+}
+
+quint64 read32(const char* data) {
+    return qFromLittleEndian<quint32>(data);
+}
+
+quint64 mixLane(quint64 lane, const quint64 input) {
+    lane += input * prime2;
+    lane = std::rotl(lane, 31);
+    return lane * prime1;
+}
+
+quint64 mergeRound(quint64 hash, const quint64 lane) {
+    hash ^= mixLane(0, lane);
+    return hash * prime1 + prime4;
+}
+
+} // namespace
+
+XxHash64::XxHash64(const quint64 seed)
+    : m_seed(seed), m_lanes{seed + prime1 + prime2, seed + prime2, seed, seed - prime1} {}
+
+void XxHash64::addData(const QByteArrayView data) {
+    const char* input = data.data();
+    qsizetype remaining = data.size();
+
+    m_totalLength += static_cast<quint64>(remaining);
+
+    // Top up a partial stripe from an earlier call first
+    if (m_buffered > 0) {
+        const qsizetype count = qMin(remaining, stripeSize - m_buffered);
+        std::memcpy(m_buffer.data() + m_buffered, input, static_cast<std::size_t>(count));
+        m_buffered += count;
+        input += count;
+        remaining -= count;
+
+        if (m_buffered < stripeSize) return;
+
+        consumeStripe(m_buffer.data());
+        m_buffered = 0;
+    }
+
+    for (; remaining >= stripeSize; remaining -= stripeSize, input += stripeSize) {
+        consumeStripe(input);
+    }
+
+    if (remaining > 0) {
+        std::memcpy(m_buffer.data(), input, static_cast<std::size_t>(remaining));
+        m_buffered = remaining;
+    }
+}
+
+void XxHash64::addData(const QStringView text) {
+    // Code units are hashed as UTF-16LE, so stored hashes stay valid when the database moves to another machine
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    addData(QByteArrayView(reinterpret_cast<const char*>(text.utf16()), text.size() * 2));
+#else
+    std::array<char16_t, stripeSize> chunk{};
+
+    for (qsizetype offset = 0; offset < text.size(); offset += stripeSize) {
+        const qsizetype count = qMin(text.size() - offset, stripeSize);
+        qToLittleEndian<char16_t>(text.utf16() + offset, count, chunk.data());
+        addData(QByteArrayView(reinterpret_cast<const char*>(chunk.data()), count * 2));
+    }
+#endif
+}
+
+void XxHash64::addValue(const qint64 value) {
+    const auto littleEndian = qToLittleEndian(value);
+    addData(QByteArrayView(reinterpret_cast<const char*>(&littleEndian), qsizetype{sizeof(littleEndian)}));
+}
+
+quint64 XxHash64::result() const {
+    quint64 hash = 0;
+
+    if (m_totalLength >= stripeSize) {
+        hash = std::rotl(m_lanes[0], 1) + std::rotl(m_lanes[1], 7) + std::rotl(m_lanes[2], 12) +
+               std::rotl(m_lanes[3], 18);
+
+        for (const quint64 lane : m_lanes) {
+            hash = mergeRound(hash, lane);
+        }
+    } else {
+        hash = m_seed + prime5;
+    }
+
+    hash += m_totalLength;
+
+    const char* tail = m_buffer.data();
+    qsizetype remaining = m_buffered;
+
+    for (; remaining >= 8; remaining -= 8, tail += 8) {
+        hash ^= mixLane(0, read64(tail));
+        hash = std::rotl(hash, 27) * prime1 + prime4;
+    }
+
+    if (remaining >= 4) {
+        hash ^= read32(tail) * prime1;
+        hash = std::rotl(hash, 23) * prime2 + prime3;
+        remaining -= 4;
+        tail += 4;
+    }
+
+    for (; remaining > 0; --remaining, ++tail) {
+        hash ^= static_cast<quint64>(static_cast<quint8>(*tail)) * prime5;
+        hash = std::rotl(hash, 11) * prime1;
+    }
+
+    // Avalanche
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+quint64 XxHash64::hash(const QByteArrayView data, const quint64 seed) {
+    XxHash64 hasher(seed);
+    hasher.addData(data);
+    return hasher.result();
+}
+
+void XxHash64::consumeStripe(const char* stripe) {
+    for (std::size_t i = 0; i < m_lanes.size(); ++i) {
+        m_lanes[i] = mixLane(m_lanes[i], read64(stripe + i * 8));
+    }
+}
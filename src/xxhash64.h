@@ -0,0 +1,35 @@
+#ifndef XXHASH64_H
+#define XXHASH64_H
+
+#include <QByteArrayView>
+#include <QStringView>
+
+#include <array>
+
+// Streaming XXH64: a fast, non-cryptographic 64-bit hash used for track identity and duplicate detection.
+// Text is hashed as UTF-16LE, in place on little-endian machines.
+class XxHash64 {
+public:
+    explicit XxHash64(quint64 seed = 0);
+
+    void addData(QByteArrayView data);
+    void addData(QStringView text);
+    void addValue(qint64 value);
+
+    [[nodiscard]] quint64 result() const;
+
+    [[nodiscard]] static quint64 hash(QByteArrayView data, quint64 seed = 0);
+
+private:
+    void consumeStripe(const char* stripe);
+
+    static constexpr qsizetype stripeSize = 32;
+
+    quint64 m_seed;
+    std::array<quint64, 4> m_lanes;
+    std::array<char, stripeSize> m_buffer{};
+    qsizetype m_buffered = 0;
+    quint64 m_totalLength = 0;
+};
+
+#endif // XXHASH64_H
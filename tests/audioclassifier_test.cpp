@@ -0,0 +1,95 @@
+#include "testutils.h"
+
+#include "taglib/audioclassifier.h"
+
+#include <gtest/gtest.h>
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryFile>
+
+using AudioClassifier::Format;
+
+namespace {
+
+// A plain literal would stop at the first NUL byte
+template <std::size_t N>
+QByteArrayView bytes(const char (&data)[N]) {
+    return {data, static_cast<qsizetype>(N - 1)};
+}
+
+} // namespace
+
+TEST(AudioClassifierTest, FromFileName) {
+    ASSERT_EQ(AudioClassifier::fromFileName(u"/music/01 - Track.mp3"), Format::Mpeg);
+    ASSERT_EQ(AudioClassifier::fromFileName(u"/music/01 - Track.FLAC"), Format::Flac);
+    ASSERT_EQ(AudioClassifier::fromFileName(u"/music/01 - Track.opus"), Format::OggOpus);
+    ASSERT_EQ(AudioClassifier::fromFileName(u"/music/01 - Track.m4a"), Format::Mp4);
+    ASSERT_EQ(AudioClassifier::fromFileName(u"/music/01 - Track.mp4"), Format::Mp4);
+    ASSERT_EQ(AudioClassifier::fromFileName(u"/music/01 - Track.aac"), Format::Mpeg);
+    ASSERT_EQ(AudioClassifier::fromFileName(u"/music/01 - Track.mka"), Format::Matroska);
+    ASSERT_EQ(AudioClassifier::fromFileName(u"/music/01 - Track.dsf"), Format::Dsf);
+    ASSERT_EQ(AudioClassifier::fromFileName(u"/music/01 - Track.DFF"), Format::Dsdiff);
+
+    ASSERT_EQ(AudioClassifier::fromFileName(u"/music/cover.jpg"), Format::Unknown);
+    ASSERT_EQ(AudioClassifier::fromFileName(u"/music/playlist.m3u"), Format::Unknown);
+    ASSERT_EQ(AudioClassifier::fromFileName(u"/music.mp3/track"), Format::Unknown);
+    ASSERT_EQ(AudioClassifier::fromFileName(u"/music/track"), Format::Unknown);
+}
+
+TEST(AudioClassifierTest, FromHeader) {
+    ASSERT_EQ(AudioClassifier::fromHeader(bytes("fLaC\0\0\0\x22")), Format::Flac);
+    ASSERT_EQ(AudioClassifier::fromHeader(bytes("RIFF\x24\0\0\0WAVEfmt ")), Format::Wav);
+    ASSERT_EQ(AudioClassifier::fromHeader(bytes("\0\0\0\x20" "ftypM4A ")), Format::Mp4);
+    ASSERT_EQ(AudioClassifier::fromHeader(bytes("\xFF\xFB\x90\x64")), Format::Mpeg);
+
+    ASSERT_EQ(AudioClassifier::fromHeader(bytes("DSD \x1C\0\0\0")), Format::Dsf);
+    ASSERT_EQ(AudioClassifier::fromHeader(bytes("FRM8\0\0\0\0\0\0\x10\0DSD ")), Format::Dsdiff);
+    ASSERT_EQ(AudioClassifier::fromHeader(bytes("\0\0\0\x18" "ftypmp42\0\0\0\0" "mp42M4A ")), Format::Mp4);
+
+    // Videos and images in ISO media files, and sync bits without a valid frame header
+    ASSERT_EQ(AudioClassifier::fromHeader(bytes("\0\0\0\x18" "ftypheic\0\0\0\0" "mif1heic")), Format::Unknown);
+    ASSERT_EQ(AudioClassifier::fromHeader(bytes("\0\0\0\x14" "ftypqt  \0\0\0\0" "qt  ")), Format::Unknown);
+    ASSERT_EQ(AudioClassifier::fromHeader(bytes("\0\0\0\x18" "ftypmp42\0\0\0\0" "isomavc1")), Format::Unknown);
+    ASSERT_EQ(AudioClassifier::fromHeader(bytes("\xFF\xFB\xF0\x64")), Format::Unknown);
+    ASSERT_EQ(AudioClassifier::fromHeader(bytes("\xFF\xEB\x90\x64")), Format::Unknown);
+    ASSERT_EQ(AudioClassifier::fromHeader(bytes("\xFF\xE0\x00\x00")), Format::Unknown);
+
+    // ADTS AAC shares the sync word with MPEG audio and is read by the same TagLib file type
+    ASSERT_EQ(AudioClassifier::fromHeader(bytes("\xFF\xF1\x50\x80")), Format::Mpeg);
+    ASSERT_EQ(AudioClassifier::fromHeader(bytes("\x89PNG\r\n\x1A\n")), Format::Unknown);
+}
+
+TEST(AudioClassifierTest, ClassifyWithoutExtension) {
+    // Temporary files have no extension, so everything here is decided by the content
+    const QList<std::pair<QString, Format>> files = {
+        {QStringLiteral(":/audio/audio.mp3"), Format::Mpeg},    {QStringLiteral(":/audio/audio.flac"), Format::Flac},
+        {QStringLiteral(":/audio/audio.ogg"), Format::OggVorbis}, {QStringLiteral(":/audio/audio.opus"), Format::OggOpus},
+        {QStringLiteral(":/audio/audio.m4a"), Format::Mp4},
+    };
+
+    for (const auto& [fileName, format] : files) {
+        TemporaryFile tempFile(fileName);
+        ASSERT_FALSE(tempFile.fileName().isEmpty());
+
+        ASSERT_EQ(AudioClassifier::classify(tempFile.fileName()), format) << fileName.toStdString();
+        ASSERT_EQ(AudioClassifier::classify(tempFile.fileName(), AudioClassifier::Match::ExtensionOnly),
+                  Format::Unknown);
+    }
+}
+
+TEST(AudioClassifierTest, ClassifyForeignExtension) {
+    // Only ambiguous extensions and files without one are sniffed, audio data behind another extension is not
+    QFile audioFile(QStringLiteral(":/audio/audio.mp3"));
+    ASSERT_TRUE(audioFile.open(QIODevice::ReadOnly));
+    const QByteArray data = audioFile.readAll();
+
+    for (const auto* extension : {"mov", "heic", "3gp", "bin"}) {
+        QTemporaryFile tempFile(QDir::tempPath() + QStringLiteral("/temp-XXXXXX.") + QLatin1StringView(extension));
+        ASSERT_TRUE(tempFile.open());
+        tempFile.write(data);
+        tempFile.flush();
+
+        ASSERT_EQ(AudioClassifier::classify(tempFile.fileName()), Format::Unknown) << extension;
+    }
+}
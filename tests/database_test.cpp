@@ -0,0 +1,759 @@
+#include "testutils.h"
+
+#include "database/databaseexecutor.h"
+#include "database/databasemanager.h"
+#include "database/dbconnection.h"
+#include "database/dbschema.h"
+#include "database/playlistdatabase.h"
+#include "database/sqlquery.h"
+#include "database/statementcache.h"
+#include "database/trackcolumns.h"
+#include "database/trackdatabase.h"
+#include "library/filescanner.h"
+
+#include <gtest/gtest.h>
+
+#include <QSet>
+#include <QSqlDatabase>
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <optional>
+
+class DatabaseTest : public GlobalTest {
+protected:
+    static QVariant pragma(const DbConnection& connection, const QString& name) {
+        SqlQuery query{connection.db(), QStringLiteral("PRAGMA %1;").arg(name)};
+        if (!query.exec() || !query.next()) return {};
+        return query.value(0);
+    }
+
+    static QString columnType(const DbConnection& connection, const QString& table, const QString& column) {
+        const QString statement = QStringLiteral("SELECT `type` FROM pragma_table_info('%1') WHERE `name` = '%2';");
+        SqlQuery query{connection.db(), statement.arg(table, column)};
+        if (!query.exec() || !query.next()) return {};
+        return query.value(0).toString();
+    }
+
+    static QStringList columnNames(const DbConnection& connection, const QString& table) {
+        SqlQuery query{connection.db(), QStringLiteral("PRAGMA table_info(%1);").arg(table)};
+        if (!query.exec()) return {};
+
+        QStringList names;
+        while (query.next()) {
+            names.append(query.value(1).toString());
+        }
+        return names;
+    }
+};
+
+TEST_F(DatabaseTest, DefaultProfile) {
+    const DbConnection connection{dbConnectionPool()};
+
+    ASSERT_EQ(pragma(connection, QStringLiteral("journal_mode")).toString(), QStringLiteral("wal"));
+    ASSERT_EQ(pragma(connection, QStringLiteral("synchronous")).toInt(), 1); // NORMAL
+    ASSERT_EQ(pragma(connection, QStringLiteral("cache_size")).toLongLong(), -DbProfile{}.cacheSizeKiB);
+    ASSERT_EQ(pragma(connection, QStringLiteral("temp_store")).toInt(), 2); // MEMORY
+    ASSERT_EQ(pragma(connection, QStringLiteral("busy_timeout")).toInt(), DbProfile{}.busyTimeoutMs);
+    ASSERT_EQ(pragma(connection, QStringLiteral("wal_autocheckpoint")).toInt(), DbProfile{}.walAutocheckpointPages);
+    ASSERT_EQ(pragma(connection, QStringLiteral("foreign_keys")).toInt(), 1);
+}
+
+TEST_F(DatabaseTest, Presets) {
+    const DbProfile bulkImport = DbProfile::preset(DbProfile::Preset::BulkImport);
+    ASSERT_EQ(bulkImport.journalMode, QStringLiteral("WAL"));
+    ASSERT_GT(bulkImport.walAutocheckpointPages, DbProfile{}.walAutocheckpointPages);
+
+    m_dbManager = &DatabaseManager::instance();
+    m_dbManager->initialize(m_tempDir.filePath(QStringLiteral("safe.db")),
+                            DbProfile::preset(DbProfile::Preset::Safe));
+
+    const DbConnection connection{m_dbManager->dbConnectionPool()};
+
+    ASSERT_EQ(pragma(connection, QStringLiteral("journal_mode")).toString(), QStringLiteral("delete"));
+    ASSERT_EQ(pragma(connection, QStringLiteral("synchronous")).toInt(), 2); // FULL
+    ASSERT_EQ(pragma(connection, QStringLiteral("mmap_size")).toLongLong(), 0);
+}
+
+TEST_F(DatabaseTest, StatementCache) {
+    const DbConnection connection{dbConnectionPool()};
+    const QString statement = QStringLiteral("SELECT `TrackID` FROM `Tracks` WHERE `TrackID` = :trackId;");
+
+    StatementCache cache;
+    const SqlQuery* first = nullptr;
+
+    {
+        const auto query = cache.acquire(connection.db(), statement);
+        query->bindValue(QStringLiteral(":trackId"), 1);
+        ASSERT_TRUE(query->exec());
+        first = &*query;
+    }
+
+    // Released statements are handed out again instead of being prepared anew
+    {
+        const auto query = cache.acquire(connection.db(), statement);
+        ASSERT_EQ(&*query, first);
+        query->bindValue(QStringLiteral(":trackId"), 2);
+        ASSERT_TRUE(query->exec());
+
+        // A statement in use is never shared
+        const auto nested = cache.acquire(connection.db(), statement);
+        ASSERT_NE(&*nested, first);
+        ASSERT_TRUE(cache.hasLeases());
+    }
+
+    // Nothing holds a statement, so the connection may be closed
+    ASSERT_FALSE(cache.hasLeases());
+    ASSERT_EQ(cache.size(), 1);
+
+    // Statements that do not prepare are not kept
+    {
+        const auto query = cache.acquire(connection.db(), QStringLiteral("SELECT FROM nowhere;"));
+        ASSERT_FALSE(query->exec());
+    }
+    ASSERT_EQ(cache.size(), 1);
+
+    cache.clear();
+}
+
+TEST_F(DatabaseTest, TrackColumns) {
+    const DbConnection connection{dbConnectionPool()};
+
+    const QStringList tracks = columnNames(connection, QStringLiteral("Tracks"));
+    for (const TrackColumns::Column& column : TrackColumns::stored) {
+        ASSERT_TRUE(tracks.contains(QLatin1StringView(column.name.data(), static_cast<qsizetype>(column.name.size()))))
+            << column.name;
+    }
+
+    const QStringList view = columnNames(connection, QStringLiteral("TrackView"));
+    ASSERT_EQ(view.first(), QStringLiteral("TrackID"));
+    for (const TrackColumns::Column& column : TrackColumns::selected) {
+        ASSERT_TRUE(view.contains(QLatin1StringView(column.name.data(), static_cast<qsizetype>(column.name.size()))))
+            << column.name;
+    }
+}
+
+TEST_F(DatabaseTest, LegacyTrackHash) {
+    const TemporaryFile audioFile(QStringLiteral(":/audio/audio.mp3"));
+    ASSERT_FALSE(audioFile.fileName().isEmpty());
+
+    const Metadata::TrackFields scanned = FileScanner{}.scanFile(QUrl::fromLocalFile(audioFile.fileName()));
+    ASSERT_TRUE(scanned.isValid());
+
+    const QString path = m_tempDir.filePath(QStringLiteral("legacy-hash.db"));
+    const QString connectionName = QStringLiteral("legacy-hash");
+
+    // The file as the first release stored it
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+        db.setDatabaseName(path);
+        ASSERT_TRUE(db.open());
+
+        SqlQuery create{db, QStringLiteral("CREATE TABLE `Tracks` (`TrackID` INTEGER PRIMARY KEY AUTOINCREMENT,"
+                                           "   `FileName` TEXT NOT NULL UNIQUE, `Title` TEXT NOT NULL,"
+                                           "   `ArtistName` TEXT, `AlbumTitle` TEXT, `AlbumArtistName` TEXT,"
+                                           "   `TrackNumber` INTEGER, `DiscNumber` INTEGER,"
+                                           "   `Duration` INTEGER NOT NULL, `Genre` TEXT,"
+                                           "   `Performer` TEXT, `Composer` TEXT, `Lyricist` TEXT, `Year` INTEGER,"
+                                           "   `Channels` INTEGER, `Bitrate` INTEGER, `SampleRate` INTEGER,"
+                                           "   `HasEmbeddedCover` INTEGER,"
+                                           "   `DateAdded` DATETIME NOT NULL DEFAULT (CURRENT_TIMESTAMP),"
+                                           "   `TrackHash` TEXT UNIQUE);")};
+        ASSERT_TRUE(create.exec());
+
+        SqlQuery insert{db, QStringLiteral("INSERT INTO `Tracks` (`FileName`, `Title`, `ArtistName`, `AlbumTitle`,"
+                                           "   `AlbumArtistName`, `Duration`, `Genre`, `Year`, `Bitrate`, `TrackHash`) "
+                                           "VALUES (:fileName, :title, :artist, :album, :albumArtist, :duration,"
+                                           "   :genre, :year, :bitRate, 'legacy');")};
+        insert.bindValue(QStringLiteral(":fileName"), scanned.get(Metadata::Fields::ResourceUrl).toUrl().toString());
+        insert.bindValue(QStringLiteral(":title"), scanned.get(Metadata::Fields::Title));
+        insert.bindValue(QStringLiteral(":artist"), scanned.get(Metadata::Fields::Artist));
+        insert.bindValue(QStringLiteral(":album"), scanned.get(Metadata::Fields::Album));
+        insert.bindValue(QStringLiteral(":albumArtist"), scanned.get(Metadata::Fields::AlbumArtist));
+        insert.bindValue(QStringLiteral(":duration"),
+                         scanned.get(Metadata::Fields::Duration).toTime().toString(Qt::ISODateWithMs));
+        insert.bindValue(QStringLiteral(":genre"), scanned.get(Metadata::Fields::Genre));
+        insert.bindValue(QStringLiteral(":year"), scanned.get(Metadata::Fields::Year));
+        insert.bindValue(QStringLiteral(":bitRate"), scanned.get(Metadata::Fields::BitRate));
+        ASSERT_TRUE(insert.exec());
+
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    const auto pool = DbConnectionPool::create(path);
+    const DbSchema schema{DbConnection{pool}};
+    ASSERT_EQ(schema.status(), DbSchema::DbStatus::Ok);
+
+    // The migrated row is found again when the same file is scanned
+    const DbConnection connection{pool};
+    SqlQuery hashes{connection.db(), QStringLiteral("SELECT `TrackHash` FROM `Tracks`;")};
+    ASSERT_TRUE(hashes.exec() && hashes.next());
+    ASSERT_EQ(static_cast<quint64>(hashes.value(0).toLongLong()), scanned.hash());
+}
+
+TEST_F(DatabaseTest, LegacySchema) {
+    const QString path = m_tempDir.filePath(QStringLiteral("legacy.db"));
+    const QString connectionName = QStringLiteral("legacy");
+
+    // Tables and rows as the first release wrote them
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+        db.setDatabaseName(path);
+        ASSERT_TRUE(db.open());
+
+        const QStringList statements = {
+            QStringLiteral("CREATE TABLE `Tracks` (`TrackID` INTEGER PRIMARY KEY AUTOINCREMENT,"
+                           "   `FileName` TEXT NOT NULL UNIQUE, `Title` TEXT NOT NULL, `ArtistName` TEXT,"
+                           "   `AlbumTitle` TEXT, `AlbumArtistName` TEXT, `TrackNumber` INTEGER, `DiscNumber` INTEGER,"
+                           "   `Duration` INTEGER NOT NULL, `Genre` TEXT, `Performer` TEXT, `Composer` TEXT,"
+                           "   `Lyricist` TEXT, `Year` INTEGER, `Channels` INTEGER, `Bitrate` INTEGER,"
+                           "   `SampleRate` INTEGER, `HasEmbeddedCover` INTEGER,"
+                           "   `DateAdded` DATETIME NOT NULL DEFAULT (CURRENT_TIMESTAMP), `TrackHash` TEXT UNIQUE);"),
+            QStringLiteral("CREATE INDEX idx_tracks_filename ON `Tracks`(`FileName`);"),
+            QStringLiteral("INSERT INTO `Tracks` (`FileName`, `Title`, `ArtistName`, `AlbumTitle`, `AlbumArtistName`,"
+                           "   `Duration`, `Genre`, `TrackHash`) VALUES "
+                           "('file:///music/a.mp3', 'A', 'Artist', 'Album', '', '00:03:25', 'Rock', 'a'),"
+                           "('file:///music/b.mp3', 'B', 'Guest', 'Album', 'Artist', '00:01:00', 'Rock', 'b'),"
+                           "('file:///music/c.mp3', 'C', NULL, NULL, NULL, '00:00:00', NULL, 'c');"),
+            QStringLiteral("CREATE TABLE `Playlists` (`PlaylistID` INTEGER PRIMARY KEY AUTOINCREMENT,"
+                           "   `PlaylistName` TEXT NOT NULL UNIQUE,"
+                           "   `DateCreated` DATETIME NOT NULL DEFAULT (CURRENT_TIMESTAMP),"
+                           "   `LastModified` DATETIME NOT NULL DEFAULT (CURRENT_TIMESTAMP));"),
+            QStringLiteral("CREATE TABLE `PlaylistTracks` (`PlaylistID` INTEGER NOT NULL, `TrackID` INTEGER NOT NULL,"
+                           "   `TrackIndex` INTEGER NOT NULL,"
+                           "   `DateAdded` DATETIME NOT NULL DEFAULT (CURRENT_TIMESTAMP),"
+                           "   PRIMARY KEY (`PlaylistID`, `TrackID`),"
+                           "   FOREIGN KEY (`PlaylistID`) REFERENCES `Playlists`(`PlaylistID`) ON DELETE CASCADE,"
+                           "   FOREIGN KEY (`TrackID`) REFERENCES `Tracks`(`TrackID`) ON DELETE CASCADE);"),
+            QStringLiteral("CREATE INDEX idx_playlist_tracks_order ON `PlaylistTracks`(`PlaylistID`, `TrackIndex`);"),
+            QStringLiteral("INSERT INTO `Playlists` (`PlaylistName`) VALUES ('Playlist');"),
+            QStringLiteral("INSERT INTO `PlaylistTracks` (`PlaylistID`, `TrackID`, `TrackIndex`) "
+                           "VALUES (1, 1, 1), (1, 2, 2), (1, 3, 0);"),
+        };
+
+        for (const QString& statement : statements) {
+            SqlQuery query{db, statement};
+            ASSERT_TRUE(query.exec()) << statement.toStdString();
+        }
+
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    const auto pool = DbConnectionPool::create(path);
+    const DbSchema schema{DbConnection{pool}};
+    ASSERT_EQ(schema.status(), DbSchema::DbStatus::Ok);
+
+    const DbConnection connection{pool};
+    ASSERT_EQ(pragma(connection, QStringLiteral("user_version")).toInt(), DbSchema::latestVersion);
+
+    const QStringList columns = columnNames(connection, QStringLiteral("Tracks"));
+    ASSERT_FALSE(columns.contains(QStringLiteral("ArtistName")));
+    ASSERT_TRUE(columns.contains(QStringLiteral("ArtistID")));
+    ASSERT_TRUE(columns.contains(QStringLiteral("FileSize")));
+
+    // Names are stored once and the tracks refer to them
+    for (const auto& [table, count] : {std::pair{QStringLiteral("Artists"), 2}, std::pair{QStringLiteral("Albums"), 1},
+                                       std::pair{QStringLiteral("Genres"), 1}}) {
+        SqlQuery query{connection.db(), QStringLiteral("SELECT COUNT(*) FROM `%1`;").arg(table)};
+        ASSERT_TRUE(query.exec() && query.next());
+        ASSERT_EQ(query.value(0).toInt(), count) << table.toStdString();
+    }
+
+    SqlQuery tracks{connection.db(), QStringLiteral("SELECT `ArtistName`, `AlbumTitle`, `AlbumArtistName`, `Genre`,"
+                                                    "   `AlbumID` FROM `TrackView` ORDER BY `TrackID`;")};
+    ASSERT_TRUE(tracks.exec());
+
+    ASSERT_TRUE(tracks.next());
+    ASSERT_EQ(tracks.value(0).toString(), QStringLiteral("Artist"));
+    ASSERT_EQ(tracks.value(1).toString(), QStringLiteral("Album"));
+    ASSERT_TRUE(tracks.value(2).isNull());
+    ASSERT_EQ(tracks.value(3).toString(), QStringLiteral("Rock"));
+    const QVariant albumId = tracks.value(4);
+
+    // The album artist of the second track is the artist of the first, so they share the album
+    ASSERT_TRUE(tracks.next());
+    ASSERT_EQ(tracks.value(0).toString(), QStringLiteral("Guest"));
+    ASSERT_EQ(tracks.value(2).toString(), QStringLiteral("Artist"));
+    ASSERT_EQ(tracks.value(4), albumId);
+
+    ASSERT_TRUE(tracks.next());
+    ASSERT_TRUE(tracks.value(0).isNull());
+    ASSERT_TRUE(tracks.value(4).isNull());
+    // Hashes are numbers now, computed from the columns as a scan of the file computes them
+    ASSERT_EQ(columnType(connection, QStringLiteral("Tracks"), QStringLiteral("TrackHash")), QStringLiteral("INTEGER"));
+    ASSERT_TRUE(columns.contains(QStringLiteral("ContentHash")));
+
+    Metadata::TrackFields first;
+    first.insert(Metadata::Fields::ResourceUrl, QUrl{QStringLiteral("file:///music/a.mp3")});
+    first.insert(Metadata::Fields::Title, QStringLiteral("A"));
+    first.insert(Metadata::Fields::Artist, QStringLiteral("Artist"));
+    first.insert(Metadata::Fields::Album, QStringLiteral("Album"));
+    first.insert(Metadata::Fields::Genre, QStringLiteral("Rock"));
+    first.insert(Metadata::Fields::Duration, QTime(0, 3, 25));
+
+    SqlQuery hashes{connection.db(), QStringLiteral("SELECT `TrackHash` FROM `Tracks` ORDER BY `TrackID`;")};
+    ASSERT_TRUE(hashes.exec() && hashes.next());
+    ASSERT_EQ(static_cast<quint64>(hashes.value(0).toLongLong()), first.generateHash());
+    // Durations are milliseconds, so they can be summed
+    SqlQuery durations{connection.db(), QStringLiteral("SELECT `Duration`, typeof(`Duration`) FROM `Tracks` "
+                                                       "ORDER BY `TrackID`;")};
+    ASSERT_TRUE(durations.exec());
+    for (const int expected : {205000, 60000, 0}) {
+        ASSERT_TRUE(durations.next());
+        ASSERT_EQ(durations.value(1).toString(), QStringLiteral("integer"));
+        ASSERT_EQ(durations.value(0).toInt(), expected);
+    }
+    // Playlist entries keep their order, with room between them
+    const QStringList entries = columnNames(connection, QStringLiteral("PlaylistTracks"));
+    ASSERT_TRUE(entries.contains(QStringLiteral("EntryID")));
+    ASSERT_FALSE(entries.contains(QStringLiteral("TrackIndex")));
+
+    PlaylistDatabase playlistDb;
+    playlistDb.initialize(connection);
+    ASSERT_EQ(playlistDb.getPlaylistTracks(1), (QList<quint64>{3, 1, 2}));
+
+    SqlQuery positions{connection.db(), QStringLiteral("SELECT `Position` FROM `PlaylistTracks` ORDER BY `Position`;")};
+    ASSERT_TRUE(positions.exec());
+    for (const qint64 expected : {1, 2, 3}) {
+        ASSERT_TRUE(positions.next());
+        ASSERT_EQ(positions.value(0).toLongLong(), expected * PlaylistDatabase::PositionGap);
+    }
+
+    SqlQuery index{connection.db(), QStringLiteral("SELECT 1 FROM pragma_index_info('idx_playlist_tracks_order') "
+                                                   "WHERE `name` = 'Position';")};
+    ASSERT_TRUE(index.exec() && index.next());
+}
+
+TEST_F(DatabaseTest, InsertTracks) {
+    const DbConnection connection{dbConnectionPool()};
+    TrackDatabase trackDb;
+    trackDb.initialize(connection);
+
+    const auto makeTrack = [](const int number, const quint64 hash) {
+        Metadata::TrackFields track;
+        track.insert(Metadata::Fields::ResourceUrl,
+                     QUrl::fromLocalFile(QStringLiteral("/music/%1.mp3").arg(number)));
+        track.insert(Metadata::Fields::Title, QStringLiteral("Track %1").arg(number));
+        track.insert(Metadata::Fields::Duration, QTime(0, 3, 15));
+        track.insert(Metadata::Fields::Hash, hash);
+        return track;
+    };
+
+    // Spans several statements of different sizes
+    TrackDatabase::TrackFieldsList tracks;
+    for (int i = 0; i < 1500; ++i) {
+        tracks.append(makeTrack(i, static_cast<quint64>(i) + 1));
+    }
+
+    QList<QUrl> conflicts;
+    ASSERT_TRUE(trackDb.insertTracks(tracks, &conflicts));
+    ASSERT_TRUE(conflicts.isEmpty());
+
+    for (const auto& track : std::as_const(tracks)) {
+        const quint64 trackId = track.get(Metadata::Fields::DatabaseId).toULongLong();
+        ASSERT_NE(trackId, 0U);
+        ASSERT_EQ(trackDb.fetchTrackIdFromFileName(track.get(Metadata::Fields::ResourceUrl).toUrl()), trackId);
+    }
+
+    const Metadata::TrackFields stored =
+        trackDb.fetchTrackFromId(tracks[42].get(Metadata::Fields::DatabaseId).toULongLong());
+    ASSERT_EQ(stored.get(Metadata::Fields::Title).toString(), QStringLiteral("Track 42"));
+    ASSERT_EQ(stored.get(Metadata::Fields::Duration).toTime(), QTime(0, 3, 15));
+    ASSERT_EQ(stored.hash(), 43U);
+
+    Metadata::TrackFields untitled = makeTrack(1502, 1503);
+    untitled.remove(Metadata::Fields::Title);
+
+    TrackDatabase::TrackFieldsList more = {
+        makeTrack(7, 9999),    // file stored already
+        makeTrack(1500, 8),    // hash stored already
+        makeTrack(1501, 1502), // new
+        untitled,              // fails, not a conflict
+    };
+
+    // Only rows that are not written name the artist
+    more[0].insert(Metadata::Fields::Artist, QStringLiteral("Skipped Artist"));
+    more[1].insert(Metadata::Fields::Artist, QStringLiteral("Skipped Artist"));
+    more[3].insert(Metadata::Fields::Artist, QStringLiteral("Skipped Artist"));
+
+    conflicts.clear();
+    ASSERT_TRUE(trackDb.insertTracks(more, &conflicts));
+
+    ASSERT_EQ(conflicts.size(), 2);
+    ASSERT_TRUE(conflicts.contains(more[0].get(Metadata::Fields::ResourceUrl).toUrl()));
+    ASSERT_TRUE(conflicts.contains(more[1].get(Metadata::Fields::ResourceUrl).toUrl()));
+    ASSERT_FALSE(more[0].contains(Metadata::Fields::DatabaseId));
+    ASSERT_FALSE(more[1].contains(Metadata::Fields::DatabaseId));
+    ASSERT_NE(more[2].get(Metadata::Fields::DatabaseId).toULongLong(), 0U);
+    ASSERT_FALSE(more[3].contains(Metadata::Fields::DatabaseId));
+
+    SqlQuery artists{connection.db(), QStringLiteral("SELECT COUNT(*) FROM `Artists`;")};
+    ASSERT_TRUE(artists.exec() && artists.next());
+    ASSERT_EQ(artists.value(0).toInt(), 0);
+}
+
+TEST_F(DatabaseTest, TracksUnderPath) {
+    TrackDatabase trackDb;
+    trackDb.initialize(DbConnection{dbConnectionPool()});
+
+    const QStringList paths = {QStringLiteral("/music/Rock/a.mp3"), QStringLiteral("/music/rock/b.mp3"),
+                               QStringLiteral("/music/Rockabilly/c.mp3"), QStringLiteral("/music/Rock")};
+
+    TrackDatabase::TrackFieldsList tracks;
+    for (const QString& path : paths) {
+        Metadata::TrackFields track;
+        track.insert(Metadata::Fields::ResourceUrl, QUrl::fromLocalFile(path));
+        track.insert(Metadata::Fields::Title, path);
+        tracks.append(track);
+    }
+    ASSERT_TRUE(trackDb.insertTracks(tracks));
+
+    const auto idOf = [&tracks](const qsizetype index) {
+        return tracks[index].get(Metadata::Fields::DatabaseId).toULongLong();
+    };
+
+    // Neither a directory differing in case nor one sharing the prefix is below it
+    QList<quint64> below = trackDb.fetchTrackIdsUnderPath(QUrl::fromLocalFile(QStringLiteral("/music/Rock")));
+    std::ranges::sort(below);
+    ASSERT_EQ(below, (QList<quint64>{idOf(0), idOf(3)}));
+
+    below = trackDb.fetchTrackIdsUnderPath(QUrl::fromLocalFile(QStringLiteral("/music/rock/")));
+    ASSERT_EQ(below, QList<quint64>{idOf(1)});
+}
+
+TEST_F(DatabaseTest, LastQuery) {
+    const DbConnection connection{dbConnectionPool()};
+
+    SqlQuery query{connection.db(),
+                   QStringLiteral("SELECT `TrackID` FROM `Tracks` WHERE `TrackID` = :trackId OR `Title` = :track "
+                                  "OR `Title` = ':trackId';")};
+    query.bindValue(QStringLiteral(":trackId"), 7);
+    query.bindValue(QStringLiteral(":track"), QVariant{});
+    ASSERT_TRUE(query.exec());
+
+#ifdef CORPLAYER_SQL_QUERY_TEXT
+    ASSERT_EQ(query.lastQuery(), QStringLiteral("SELECT `TrackID` FROM `Tracks` WHERE `TrackID` = 7 OR `Title` = NULL "
+                                                "OR `Title` = ':trackId';"));
+#else
+    ASSERT_TRUE(query.lastQuery().contains(QStringLiteral(":trackId")));
+#endif
+}
+
+TEST_F(DatabaseTest, TimingHook) {
+    const DbConnection connection{dbConnectionPool()};
+
+    static int executions = 0;
+    executions = 0;
+
+    SqlQuery::setTimingHook([](const SqlQuery& /*query*/, const qint64 nanoseconds, const bool success) {
+        ASSERT_GE(nanoseconds, 0);
+        ASSERT_TRUE(success);
+        ++executions;
+    });
+
+    SqlQuery query{connection.db(), QStringLiteral("SELECT COUNT(*) FROM `Tracks`;")};
+    ASSERT_TRUE(query.exec());
+    ASSERT_TRUE(query.exec());
+
+    SqlQuery::setTimingHook(nullptr);
+    ASSERT_TRUE(query.exec());
+
+    ASSERT_EQ(executions, 2);
+}
+
+TEST_F(DatabaseTest, PlaylistEdits) {
+    const auto pool = dbConnectionPool();
+
+    TrackDatabase trackDb;
+    trackDb.initialize(DbConnection{pool});
+    PlaylistDatabase playlistDb;
+    playlistDb.initialize(DbConnection{pool});
+
+    TrackDatabase::TrackFieldsList tracks;
+    for (int i = 0; i < 6; ++i) {
+        Metadata::TrackFields track;
+        track.insert(Metadata::Fields::ResourceUrl, QUrl::fromLocalFile(QStringLiteral("/music/%1.mp3").arg(i)));
+        track.insert(Metadata::Fields::Title, QStringLiteral("Track %1").arg(i));
+        tracks.append(track);
+    }
+    ASSERT_TRUE(trackDb.insertTracks(tracks));
+
+    QList<quint64> ids;
+    for (const auto& track : std::as_const(tracks)) {
+        ids.append(track.get(Metadata::Fields::DatabaseId).toULongLong());
+    }
+
+    // The same track can be in a playlist more than once
+    Metadata::PlaylistRecord record;
+    record.name = QStringLiteral("Edits");
+    record.trackIds = {ids[0], ids[1], ids[2], ids[0]};
+    ASSERT_TRUE(playlistDb.savePlaylist(record));
+
+    const quint64 playlistId = playlistDb.getPlaylist(record.name).id;
+    ASSERT_EQ(playlistDb.getPlaylistTracks(playlistId), record.trackIds);
+
+    ASSERT_TRUE(playlistDb.insertTracks(playlistId, 1, {ids[3], ids[4]}));
+    ASSERT_EQ(playlistDb.getPlaylistTracks(playlistId), (QList{ids[0], ids[3], ids[4], ids[1], ids[2], ids[0]}));
+
+    ASSERT_TRUE(playlistDb.moveTracks(playlistId, 1, 2, 5));
+    ASSERT_EQ(playlistDb.getPlaylistTracks(playlistId), (QList{ids[0], ids[1], ids[2], ids[3], ids[4], ids[0]}));
+
+    ASSERT_TRUE(playlistDb.moveTracks(playlistId, 4, 1, 0));
+    ASSERT_EQ(playlistDb.getPlaylistTracks(playlistId), (QList{ids[4], ids[0], ids[1], ids[2], ids[3], ids[0]}));
+
+    ASSERT_TRUE(playlistDb.removeTracks(playlistId, 4, 2));
+    ASSERT_EQ(playlistDb.getPlaylistTracks(playlistId), (QList{ids[4], ids[0], ids[1], ids[2]}));
+
+    ASSERT_TRUE(playlistDb.addTracksToPlaylist(playlistId, {ids[5]}));
+    ASSERT_EQ(playlistDb.getPlaylistTracks(playlistId), (QList{ids[4], ids[0], ids[1], ids[2], ids[5]}));
+
+    // Edits touch the playlist once, no trigger rewrites it for every entry
+    const DbConnection connection{pool};
+    SqlQuery triggers{connection.db(),
+                      QStringLiteral("SELECT COUNT(*) FROM `sqlite_master` WHERE `type` = 'trigger';")};
+    ASSERT_TRUE(triggers.exec() && triggers.next());
+    ASSERT_EQ(triggers.value(0).toInt(), 0);
+
+    const QString longAgo = QStringLiteral("2000-01-01 00:00:00");
+    SqlQuery age{connection.db(), QStringLiteral("UPDATE `Playlists` SET `LastModified` = '%1';").arg(longAgo)};
+    ASSERT_TRUE(age.exec());
+
+    ASSERT_TRUE(playlistDb.removeTrackFromPlaylist(playlistId, ids[5]));
+    ASSERT_EQ(playlistDb.getPlaylistTracks(playlistId), (QList{ids[4], ids[0], ids[1], ids[2]}));
+
+    SqlQuery modified{connection.db(), QStringLiteral("SELECT `LastModified` FROM `Playlists`;")};
+    ASSERT_TRUE(modified.exec() && modified.next());
+    ASSERT_NE(modified.value(0).toString(), longAgo);
+
+    // Dragging one track
+    record = playlistDb.getPlaylist(playlistId);
+    record.trackIds = {ids[0], ids[1], ids[2], ids[4], ids[5]};
+    ASSERT_TRUE(playlistDb.updatePlaylist(record));
+    ASSERT_EQ(playlistDb.getPlaylistTracks(playlistId), record.trackIds);
+
+    // Enough inserts at one place to use up the room between two entries
+    QList<quint64> expected = record.trackIds;
+    for (int i = 0; i < 40; ++i) {
+        ASSERT_TRUE(playlistDb.insertTracks(playlistId, 1, {ids[i % 6]}));
+        expected.insert(1, ids[i % 6]);
+    }
+    ASSERT_EQ(playlistDb.getPlaylistTracks(playlistId), expected);
+
+    // Renaming leaves the entries alone
+    ASSERT_TRUE(playlistDb.renamePlaylist(playlistId, QStringLiteral("Renamed")));
+    ASSERT_EQ(playlistDb.getPlaylist(playlistId).name, QStringLiteral("Renamed"));
+    ASSERT_EQ(playlistDb.getPlaylistTracks(playlistId), expected);
+
+    const auto headers = playlistDb.getPlaylistHeaders();
+    ASSERT_EQ(headers.size(), 1);
+    ASSERT_EQ(headers.first().trackCount, expected.size());
+}
+
+TEST_F(DatabaseTest, Executor) {
+    // Without a thread the work runs right away
+    const DatabaseExecutor inlineExecutor;
+    ASSERT_TRUE(inlineExecutor.runsInline());
+    auto inlineFuture = inlineExecutor.run([] {
+        return QThread::currentThread();
+    });
+    ASSERT_TRUE(inlineFuture.isFinished());
+    ASSERT_EQ(inlineFuture.result(), QThread::currentThread());
+
+    QThread thread;
+    thread.start();
+
+    {
+        const DatabaseExecutor executor{&thread};
+        ASSERT_FALSE(executor.runsInline());
+
+        const auto pool = dbConnectionPool();
+        auto future = executor.run([pool] {
+            const DbConnection connection{pool};
+            SqlQuery query{connection.db(), QStringLiteral("SELECT COUNT(*) FROM `Tracks`;")};
+            return std::pair{QThread::currentThread(), query.exec() && query.next()};
+        });
+
+        const auto [runThread, success] = future.result();
+        ASSERT_EQ(runThread, &thread);
+        ASSERT_TRUE(success);
+
+        // Jobs run in the order they were started
+        QList<int> order;
+        for (int i = 0; i < 3; ++i) {
+            executor.run([&order, i] {
+                order.append(i);
+            });
+        }
+        executor.run([] {}).waitForFinished();
+        ASSERT_EQ(order, (QList{0, 1, 2}));
+    }
+
+    thread.quit();
+    thread.wait();
+}
+
+TEST_F(DatabaseTest, ConnectionPool) {
+    const auto pool = dbConnectionPool();
+
+    // Handles come and go without closing the thread's connection
+    QString connectionName;
+    {
+        const DbConnection connection{pool};
+        connectionName = connection.db().connectionName();
+    }
+    ASSERT_TRUE(pool->hasConnection());
+    ASSERT_TRUE(connectionName.startsWith(QStringLiteral("CorPlayer-")));
+    ASSERT_EQ(DbConnection{pool}.db().connectionName(), connectionName);
+
+    // A connection that stopped answering is reopened before the next operation
+    DbConnection{pool}.db().close();
+    {
+        const auto reader = pool->read();
+        ASSERT_TRUE(reader.db().isOpen());
+        SqlQuery query{reader.db(), QStringLiteral("SELECT COUNT(*) FROM `Tracks`;")};
+        ASSERT_TRUE(query.exec());
+    }
+
+    const auto bounded = DbConnectionPool::create(m_tempDir.filePath(QStringLiteral("test.db")), {}, 2);
+
+    // Nested leases on one thread take a single slot, also under the writer lock
+    {
+        const auto outer = bounded->read();
+        const auto inner = bounded->read();
+        ASSERT_EQ(bounded->availableReaders(), 1);
+
+        const auto writer = bounded->write();
+        const auto nested = bounded->read();
+        ASSERT_EQ(bounded->availableReaders(), 1);
+    }
+    ASSERT_EQ(bounded->availableReaders(), 2);
+
+    // No more reads than slots run at once
+    std::atomic<int> active{0};
+    std::atomic<int> peak{0};
+    QList<QThread*> readers;
+
+    for (int i = 0; i < 4; ++i) {
+        readers.append(QThread::create([&bounded, &active, &peak] {
+            const auto reader = bounded->read();
+            const int now = ++active;
+            int seen = peak.load();
+            while (seen < now && !peak.compare_exchange_weak(seen, now)) {
+            }
+
+            SqlQuery query{reader.db(), QStringLiteral("SELECT COUNT(*) FROM `Tracks`;")};
+            EXPECT_TRUE(query.exec() && query.next());
+            QThread::msleep(20);
+            --active;
+        }));
+        readers.last()->start();
+    }
+
+    for (QThread* thread : std::as_const(readers)) {
+        thread->wait();
+        delete thread;
+    }
+    ASSERT_LE(peak.load(), 2);
+    ASSERT_EQ(bounded->availableReaders(), 2);
+
+    // A second writer waits for the first one
+    std::optional<DbConnectionPool::WriteLease> writer{bounded->write()};
+    std::atomic<bool> wrote{false};
+    std::unique_ptr<QThread> other{QThread::create([&bounded, &wrote] {
+        const auto lease = bounded->write();
+        wrote = true;
+    })};
+    other->start();
+
+    QThread::msleep(50);
+    EXPECT_FALSE(wrote.load());
+
+    writer.reset();
+    other->wait();
+    ASSERT_TRUE(wrote.load());
+}
+
+TEST_F(DatabaseTest, UpdateAndDeleteTracks) {
+    const DbConnection connection{dbConnectionPool()};
+    TrackDatabase trackDb;
+    trackDb.initialize(connection);
+
+    TrackDatabase::TrackFieldsList tracks;
+    for (int i = 0; i < 3; ++i) {
+        Metadata::TrackFields track;
+        track.insert(Metadata::Fields::ResourceUrl, QUrl::fromLocalFile(QStringLiteral("/music/%1.mp3").arg(i)));
+        track.insert(Metadata::Fields::Title, QStringLiteral("Track %1").arg(i));
+        track.insert(Metadata::Fields::Artist, QStringLiteral("Artist"));
+        tracks.append(track);
+    }
+    ASSERT_TRUE(trackDb.insertTracks(tracks));
+
+    for (auto& track : tracks) {
+        const QString title = track.get(Metadata::Fields::Title).toString();
+        track.insert(Metadata::Fields::Title, title + QStringLiteral(" (Live)"));
+        track.insert(Metadata::Fields::Artist, QStringLiteral("Other Artist"));
+    }
+    tracks[0].insert(Metadata::Fields::Genre, QStringLiteral("Solo"));
+
+    // Only the names the changed tracks referred to are pruned, one nothing refers to elsewhere stays
+    SqlQuery unrelated{connection.db(), QStringLiteral("INSERT INTO `Artists` (`Name`) VALUES ('Unrelated');")};
+    ASSERT_TRUE(unrelated.exec());
+
+    const auto countNames = [&connection](const QString& table, const QString& name) {
+        SqlQuery query{connection.db(), QStringLiteral("SELECT COUNT(*) FROM `%1` WHERE `Name` = :name;").arg(table)};
+        query.bindValue(QStringLiteral(":name"), name);
+        return query.exec() && query.next() ? query.value(0).toInt() : -1;
+    };
+
+    // One statement and one set of name lookups serve the whole batch
+    static QSet<const SqlQuery*> updateQueries;
+    static int updates = 0;
+    static int artistLookups = 0;
+    updateQueries.clear();
+    updates = 0;
+    artistLookups = 0;
+
+    SqlQuery::setTimingHook([](const SqlQuery& query, const qint64 /*nanoseconds*/, const bool /*success*/) {
+        const QString statement = query.executedQuery();
+        if (statement.startsWith(u"UPDATE `Tracks`")) {
+            updateQueries.insert(&query);
+            ++updates;
+        } else if (statement.startsWith(u"SELECT `ArtistID` FROM `Artists`")) {
+            ++artistLookups;
+        }
+    });
+    const bool updated = trackDb.updateTracks(tracks);
+    SqlQuery::setTimingHook(nullptr);
+
+    ASSERT_TRUE(updated);
+    ASSERT_EQ(updates, 3);
+    ASSERT_EQ(updateQueries.size(), 1);
+    ASSERT_EQ(artistLookups, 1);
+
+    for (const auto& track : std::as_const(tracks)) {
+        const Metadata::TrackFields stored =
+            trackDb.fetchTrackFromId(track.get(Metadata::Fields::DatabaseId).toULongLong());
+        ASSERT_EQ(stored.get(Metadata::Fields::Title), track.get(Metadata::Fields::Title));
+        ASSERT_EQ(stored.get(Metadata::Fields::Artist).toString(), QStringLiteral("Other Artist"));
+    }
+
+    // The artist nobody refers to anymore is gone
+    ASSERT_EQ(countNames(QStringLiteral("Artists"), QStringLiteral("Artist")), 0);
+    ASSERT_EQ(countNames(QStringLiteral("Artists"), QStringLiteral("Unrelated")), 1);
+
+    // A single track is deleted like a batch, with the names only it used
+    ASSERT_TRUE(trackDb.deleteTrack(tracks[0].get(Metadata::Fields::DatabaseId).toULongLong()));
+    ASSERT_EQ(countNames(QStringLiteral("Genres"), QStringLiteral("Solo")), 0);
+    ASSERT_EQ(countNames(QStringLiteral("Artists"), QStringLiteral("Other Artist")), 1);
+
+    ASSERT_TRUE(trackDb.deleteTracks(tracks));
+    for (const auto& track : std::as_const(tracks)) {
+        ASSERT_TRUE(trackDb.fetchTrackFromId(track.get(Metadata::Fields::DatabaseId).toULongLong()).isEmpty());
+    }
+    ASSERT_EQ(countNames(QStringLiteral("Artists"), QStringLiteral("Other Artist")), 0);
+    ASSERT_EQ(countNames(QStringLiteral("Artists"), QStringLiteral("Unrelated")), 1);
+}
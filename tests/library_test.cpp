@@ -1,8 +1,15 @@
 #include "testutils.h"
 
+#include "library/disklocality.h"
 #include "library/library.hpp"
+#include "library/scanpipeline.h"
 
+#include <QDir>
+#include <QFile>
 #include <QSignalSpy>
+#include <QThreadPool>
+
+#include <algorithm>
 
 class LibraryTest : public GlobalTest {
 protected:
@@ -61,6 +68,151 @@ TEST_F(LibraryTest, AddTracksFromUrls) {
     ASSERT_EQ(track2.get(Metadata::Fields::ResourceUrl).toUrl(), fileUrl2);
 }
 
+TEST_F(LibraryTest, ImportDirectory) {
+    const QDir root(m_tempDir.filePath(QStringLiteral("music")));
+    ASSERT_TRUE(root.mkpath(QStringLiteral("artist/album1")));
+    ASSERT_TRUE(root.mkpath(QStringLiteral("artist/album2")));
+
+    ASSERT_TRUE(QFile::rename(AudioFile::create().toLocalFile(), root.filePath(QStringLiteral("artist/album1/01.mp3"))));
+    ASSERT_TRUE(QFile::rename(AudioFile::create().toLocalFile(), root.filePath(QStringLiteral("artist/album2/01.mp3"))));
+    ASSERT_TRUE(QFile::rename(AudioFile::create().toLocalFile(), root.filePath(QStringLiteral("artist/album2/02.mp3"))));
+
+    // A link back to the root must neither loop forever nor import the files twice
+    ASSERT_TRUE(QFile::link(root.absolutePath(), root.filePath(QStringLiteral("artist/album2/loop"))));
+
+    QSignalSpy trackAddedSpy(m_library.get(), SIGNAL(trackAdded(quint64, const Metadata::TrackFields&)));
+
+    const QUrl rootUrl = QUrl::fromLocalFile(root.absolutePath());
+    const QList<quint64> trackIds = m_library->importDirectory(rootUrl);
+
+    ASSERT_EQ(trackIds.size(), 3);
+    ASSERT_EQ(trackAddedSpy.count(), 3);
+
+    // Importing again only resolves the tracks that are already known
+    trackAddedSpy.clear();
+    ASSERT_EQ(m_library->importDirectory(rootUrl), trackIds);
+    ASSERT_EQ(trackAddedSpy.count(), 0);
+}
+
+TEST_F(LibraryTest, ScanProgress) {
+    QList<QUrl> urls;
+    for (int i = 0; i < 5; ++i) {
+        urls.append(AudioFile::create());
+    }
+
+    QSignalSpy trackAddedSpy(m_library.get(), SIGNAL(trackAdded(quint64, const Metadata::TrackFields&)));
+    QSignalSpy scanProgressSpy(m_library.get(), &Library::scanProgress);
+
+    ASSERT_EQ(m_library->addTracksFromUrls(urls).size(), 5);
+    ASSERT_EQ(trackAddedSpy.count(), 5);
+
+    // The last report is sent after the final commit
+    ASSERT_GE(scanProgressSpy.count(), 1);
+    const auto progress = scanProgressSpy.last().at(0).value<ScanProgress>();
+    ASSERT_EQ(progress.scanned, 5);
+    ASSERT_EQ(progress.queued, 0);
+    ASSERT_EQ(progress.committed, 5);
+}
+
+TEST_F(LibraryTest, ScanThreads) {
+    // The pool threads and their scanners are reused by every later scan
+    for (const int threads : {1, 4}) {
+        m_library->setMaxScanThreads(threads);
+
+        QList<QUrl> urls;
+        for (int i = 0; i < 10; ++i) {
+            urls.append(AudioFile::create());
+        }
+
+        const QList<quint64> trackIds = m_library->addTracksFromUrls(urls);
+        ASSERT_EQ(trackIds.size(), urls.size());
+
+        for (qsizetype i = 0; i < urls.size(); ++i) {
+            ASSERT_EQ(m_library->getTrackById(trackIds[i]).get(Metadata::Fields::ResourceUrl).toUrl(), urls[i]);
+        }
+    }
+}
+
+TEST_F(LibraryTest, DiskLocalityOrdering) {
+    const auto placementOf = [](const QUrl& url) {
+        return DiskLocality::placement(url.toLocalFile());
+    };
+    const auto byPlacement = [&placementOf](const QUrl& a, const QUrl& b) {
+        return placementOf(a) < placementOf(b);
+    };
+
+    QList<QUrl> urls;
+    for (int i = 0; i < 10; ++i) {
+        urls.append(AudioFile::create());
+    }
+
+    // Submitted against their on-disk order, so the scan has to reorder every one of them
+    std::ranges::stable_sort(urls, [&byPlacement](const QUrl& a, const QUrl& b) {
+        return byPlacement(b, a);
+    });
+
+    QList<QUrl> diskOrder = urls;
+    std::ranges::stable_sort(diskOrder, byPlacement);
+    ASSERT_NE(diskOrder, urls);
+
+    QList<QUrl> sorted = urls;
+    DiskLocality::sortByPlacement(sorted);
+    ASSERT_EQ(sorted, diskOrder);
+
+    // A single worker hands the tracks to the writer in the order it read them
+    ScanPipeline::Options options;
+    options.workerCount = 1;
+    options.localityOrdering = true;
+
+    QThreadPool pool;
+    QList<QUrl> readOrder;
+    {
+        ScanPipeline pipeline{pool, options};
+        pipeline.submit(urls);
+        pipeline.closeInput();
+        pipeline.drain([&readOrder](QList<Metadata::TrackFields>& chunk) {
+            for (const Metadata::TrackFields& track : std::as_const(chunk)) {
+                readOrder.append(track.get(Metadata::Fields::ResourceUrl).toUrl());
+            }
+            return chunk.size();
+        });
+    }
+    ASSERT_EQ(readOrder, diskOrder);
+
+    // Files are read in disk order, but the ids still follow the order of the request
+    m_library->setDiskLocalityOrdering(true);
+    const QList<quint64> trackIds = m_library->addTracksFromUrls(urls);
+    ASSERT_EQ(trackIds.size(), urls.size());
+
+    for (qsizetype i = 0; i < urls.size(); ++i) {
+        ASSERT_EQ(m_library->getTrackById(trackIds[i]).get(Metadata::Fields::ResourceUrl).toUrl(), urls[i]);
+    }
+}
+
+TEST_F(LibraryTest, ContentHashing) {
+    m_library->setContentHashing(true);
+
+    Metadata::TrackFields metadata;
+    metadata.insert(Metadata::Fields::Title, QStringLiteral("Title"));
+
+    Metadata::TrackFields otherMetadata;
+    otherMetadata.insert(Metadata::Fields::Title, QStringLiteral("Other Title"));
+
+    // Two copies of the same file under different names, and one file with other tags
+    const QList<QUrl> urls = {AudioFile::create(metadata), AudioFile::create(metadata),
+                              AudioFile::create(otherMetadata)};
+    const QList<quint64> trackIds = m_library->addTracksFromUrls(urls);
+    ASSERT_EQ(trackIds.size(), 3);
+
+    ASSERT_NE(m_library->getTrackById(trackIds[0]).contentHash(), 0U);
+    ASSERT_EQ(m_library->getTrackById(trackIds[0]).contentHash(), m_library->getTrackById(trackIds[1]).contentHash());
+    ASSERT_NE(m_library->getTrackById(trackIds[0]).contentHash(), m_library->getTrackById(trackIds[2]).contentHash());
+
+    const QList<QList<quint64>> duplicates = m_library->trackDatabase().fetchDuplicateTrackIds();
+    ASSERT_EQ(duplicates.size(), 1);
+    ASSERT_EQ(duplicates[0], (QList<quint64>{trackIds[0], trackIds[1]}));
+}
+
 TEST_F(LibraryTest, UpdateTrack) {
     const QUrl fileUrl = AudioFile::create();
     const quint64 trackId = m_library->addTrackFromUrl(fileUrl);
@@ -81,6 +233,37 @@ TEST_F(LibraryTest, UpdateTrack) {
     ASSERT_EQ(updatedTrack.get(Metadata::Fields::Title).toString(), newTitle);
 }
 
+TEST_F(LibraryTest, SharedAlbum) {
+    Metadata::TrackFields metadata;
+    metadata.insert(Metadata::Fields::Artist, QStringLiteral("Artist"));
+    metadata.insert(Metadata::Fields::Album, QStringLiteral("Album"));
+
+    const QList<QUrl> urls = {AudioFile::create(metadata), AudioFile::create(metadata)};
+    const QList<quint64> trackIds = m_library->addTracksFromUrls(urls);
+    ASSERT_EQ(trackIds.size(), 2);
+
+    Metadata::TrackFields track1 = m_library->getTrackById(trackIds[0]);
+    const Metadata::TrackFields track2 = m_library->getTrackById(trackIds[1]);
+
+    ASSERT_EQ(track1.artist(), QStringLiteral("Artist"));
+    ASSERT_EQ(track1.album(), QStringLiteral("Album"));
+    ASSERT_NE(track1.albumId(), 0U);
+    ASSERT_EQ(track1.albumId(), track2.albumId());
+
+    // Both tracks share one copy of the name
+    ASSERT_EQ(track1.artist().constData(), track2.artist().constData());
+
+    // Same title by another artist is another album
+    track1.insert(Metadata::Fields::Artist, QStringLiteral("Other Artist"));
+    m_library->updateTrack(track1);
+
+    const Metadata::TrackFields updatedTrack = m_library->getTrackById(trackIds[0]);
+    ASSERT_EQ(updatedTrack.artist(), QStringLiteral("Other Artist"));
+    ASSERT_EQ(updatedTrack.album(), QStringLiteral("Album"));
+    ASSERT_NE(updatedTrack.albumId(), 0U);
+    ASSERT_NE(updatedTrack.albumId(), track2.albumId());
+}
+
 TEST_F(LibraryTest, RemoveTrack) {
     const QUrl fileUrl = AudioFile::create();
     const quint64 trackId = m_library->addTrackFromUrl(fileUrl);
@@ -96,6 +279,73 @@ TEST_F(LibraryTest, RemoveTrack) {
     ASSERT_FALSE(removedTrack.isValid());
 }
 
+TEST_F(LibraryTest, RescanLibrary) {
+    const QUrl unchangedUrl = AudioFile::create();
+    const QUrl modifiedUrl = AudioFile::create();
+    const QUrl removedUrl = AudioFile::create();
+
+    const QList<quint64> trackIds = m_library->addTracksFromUrls({unchangedUrl, modifiedUrl, removedUrl});
+    ASSERT_EQ(trackIds.size(), 3);
+
+    {
+        QFile file(modifiedUrl.toLocalFile());
+        ASSERT_TRUE(file.open(QIODevice::Append));
+        file.write(QByteArray(128, '\0'));
+    }
+    ASSERT_TRUE(QFile::remove(removedUrl.toLocalFile()));
+
+    QSignalSpy trackModifiedSpy(m_library.get(), SIGNAL(trackModified(quint64, const Metadata::TrackFields&)));
+    QSignalSpy trackRemovedSpy(m_library.get(), SIGNAL(trackRemoved(quint64)));
+
+    const auto result = m_library->rescanLibrary();
+
+    ASSERT_EQ(result.unchanged, 1);
+    ASSERT_EQ(result.modified, 1);
+    ASSERT_EQ(result.removed, 1);
+    ASSERT_EQ(trackModifiedSpy.count(), 1);
+    ASSERT_EQ(trackRemovedSpy.count(), 1);
+    ASSERT_FALSE(m_library->getTrackById(trackIds[2]).isValid());
+
+    // Fingerprints were refreshed, so a second pass has nothing to do
+    const auto secondResult = m_library->rescanLibrary();
+    ASSERT_EQ(secondResult.unchanged, 2);
+    ASSERT_EQ(secondResult.modified, 0);
+    ASSERT_EQ(secondResult.removed, 0);
+}
+
+TEST_F(LibraryTest, WatchDirectory) {
+    if (!LibraryWatcher::isSupported()) {
+        GTEST_SKIP() << "Watching directories is not supported on this platform";
+    }
+
+    const QDir root(m_tempDir.filePath(QStringLiteral("watched")));
+    ASSERT_TRUE(root.mkpath(QStringLiteral(".")));
+    ASSERT_TRUE(m_library->watchDirectory(QUrl::fromLocalFile(root.absolutePath())));
+
+    QSignalSpy trackAddedSpy(m_library.get(), SIGNAL(trackAdded(quint64, const Metadata::TrackFields&)));
+    QSignalSpy trackRemovedSpy(m_library.get(), SIGNAL(trackRemoved(quint64)));
+
+    // A whole album moved in at once ends up in a single batch
+    ASSERT_TRUE(root.mkpath(QStringLiteral("album")));
+    const QString trackPath = root.filePath(QStringLiteral("album/01.mp3"));
+    ASSERT_TRUE(QFile::rename(AudioFile::create().toLocalFile(), trackPath));
+    ASSERT_TRUE(QFile::rename(AudioFile::create().toLocalFile(), root.filePath(QStringLiteral("album/02.mp3"))));
+
+    // Changes are applied on the library's watch thread, the signals arrive one by one
+    while (trackAddedSpy.count() < 2 && trackAddedSpy.wait(10000)) {
+    }
+    ASSERT_EQ(trackAddedSpy.count(), 2);
+    ASSERT_NE(m_library->trackDatabase().fetchTrackIdFromFileName(QUrl::fromLocalFile(trackPath)), 0U);
+
+    // Removing the directory removes every track below it
+    ASSERT_TRUE(QDir(root.filePath(QStringLiteral("album"))).removeRecursively());
+
+    while (trackRemovedSpy.count() < 2 && trackRemovedSpy.wait(10000)) {
+    }
+    ASSERT_EQ(trackRemovedSpy.count(), 2);
+    ASSERT_EQ(m_library->trackDatabase().fetchTrackIdFromFileName(QUrl::fromLocalFile(trackPath)), 0U);
+}
+
 TEST_F(LibraryTest, CreatePlaylistFromUrls) {
     const QUrl fileUrl1 = AudioFile::create();
     const QUrl fileUrl2 = AudioFile::create();
@@ -129,6 +379,8 @@ TEST_F(LibraryTest, RenamePlaylist) {
     const QString newName = QStringLiteral("New Name");
     m_library->renamePlaylist(playlistId, newName);
 
+    // Reported from a continuation of the rename
+    if (playlistModifiedSpy.isEmpty()) ASSERT_TRUE(playlistModifiedSpy.wait(1000));
     ASSERT_EQ(playlistModifiedSpy.count(), 1);
 
     const auto playlist = m_library->playlistDatabase().getPlaylist(playlistId);
@@ -152,3 +404,35 @@ TEST_F(LibraryTest, RemovePlaylist) {
     ASSERT_EQ(playlist.name, QString());
     ASSERT_TRUE(playlist.trackIds.isEmpty());
 }
+
+TEST_F(LibraryTest, PlaylistHeaders) {
+    const QUrl fileUrl1 = AudioFile::create();
+    const QUrl fileUrl2 = AudioFile::create();
+    const quint64 playlistId = m_library->createPlaylistFromUrls(QStringLiteral("Full"), {fileUrl1, fileUrl2});
+    ASSERT_NE(playlistId, 0U);
+
+    Metadata::PlaylistRecord empty;
+    empty.name = QStringLiteral("Empty");
+    ASSERT_TRUE(m_library->playlistDatabase().savePlaylist(empty));
+
+    const auto headers = m_library->playlistDatabase().getPlaylistHeaders();
+    ASSERT_EQ(headers.size(), 2);
+
+    const auto full = std::ranges::find(headers, playlistId, &Metadata::PlaylistHeader::id);
+    ASSERT_NE(full, headers.end());
+    ASSERT_EQ(full->name, QStringLiteral("Full"));
+    ASSERT_EQ(full->trackCount, 2);
+    ASSERT_GT(full->totalDuration, 0);
+
+    const auto emptyHeader = std::ranges::find(headers, QStringLiteral("Empty"), &Metadata::PlaylistHeader::name);
+    ASSERT_NE(emptyHeader, headers.end());
+    ASSERT_EQ(emptyHeader->trackCount, 0);
+    ASSERT_EQ(emptyHeader->totalDuration, 0);
+
+    // Playlists without tracks are listed too
+    const auto playlists = m_library->playlistDatabase().getPlaylists();
+    ASSERT_EQ(playlists.size(), 2);
+    for (const auto& playlist : playlists) {
+        ASSERT_EQ(playlist.trackIds, m_library->playlistDatabase().getPlaylistTracks(playlist.id));
+    }
+}
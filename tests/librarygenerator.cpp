@@ -0,0 +1,244 @@
+#include "librarygenerator.h"
+
+#include <taglib/fileref.h>
+#include <taglib/tpropertymap.h>
+#include <taglib/tvariant.h>
+
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <array>
+
+namespace {
+
+struct Template {
+    QLatin1StringView extension;
+    QByteArray data;
+};
+
+constexpr std::array<QLatin1StringView, 5> templateExtensions{
+    QLatin1StringView("mp3"), QLatin1StringView("flac"), QLatin1StringView("ogg"),
+    QLatin1StringView("opus"), QLatin1StringView("m4a"),
+};
+
+constexpr std::array<QLatin1StringView, 16> words{
+    QLatin1StringView("Blue"),   QLatin1StringView("Night"),  QLatin1StringView("River"),
+    QLatin1StringView("Echo"),   QLatin1StringView("Glass"),  QLatin1StringView("Silver"),
+    QLatin1StringView("Winter"), QLatin1StringView("Signal"), QLatin1StringView("Paper"),
+    QLatin1StringView("Garden"), QLatin1StringView("Static"), QLatin1StringView("Golden"),
+    QLatin1StringView("Harbor"), QLatin1StringView("Velvet"), QLatin1StringView("Motion"),
+    QLatin1StringView("Ember"),
+};
+
+constexpr std::array<QLatin1StringView, 8> genres{
+    QLatin1StringView("Rock"),       QLatin1StringView("Jazz"),  QLatin1StringView("Electronic"),
+    QLatin1StringView("Classical"),  QLatin1StringView("Folk"),  QLatin1StringView("Hip-Hop"),
+    QLatin1StringView("Ambient"),    QLatin1StringView("Metal"),
+};
+
+constexpr qsizetype albumsPerArtist = 8;
+const QString markerFileName = QStringLiteral(".corplayer-bench");
+
+QString phrase(QRandomGenerator& random, const int wordCount) {
+    QStringList parts;
+    parts.reserve(wordCount);
+
+    for (int i = 0; i < wordCount; ++i) {
+        parts.append(words[random.bounded(static_cast<quint32>(words.size()))]);
+    }
+
+    return parts.join(QLatin1Char(' '));
+}
+
+QByteArray coverData(QRandomGenerator& random, const qsizetype size) {
+    if (size <= 0) return {};
+
+    // Random bytes behind a JPEG header, TagLib only stores them and nothing decodes them while scanning
+    QByteArray data(size, '\0');
+    random.fillRange(reinterpret_cast<quint32*>(data.data()), size / static_cast<qsizetype>(sizeof(quint32)));
+
+    constexpr std::array<char, 4> jpegHeader{'\xFF', '\xD8', '\xFF', '\xE0'};
+    for (qsizetype i = 0; i < qMin<qsizetype>(size, 4); ++i) {
+        data[i] = jpegHeader[static_cast<std::size_t>(i)];
+    }
+
+    return data;
+}
+
+QString markerText(const LibraryGenerator::Options& options) {
+    return QStringLiteral("%1 %2 %3 %4")
+        .arg(options.fileCount)
+        .arg(options.tracksPerAlbum)
+        .arg(options.coverBytes)
+        .arg(options.seed);
+}
+
+QList<QUrl> collectFiles(const QString& rootPath) {
+    QList<QUrl> urls;
+
+    QDirIterator it(rootPath, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString filePath = it.next();
+        if (it.fileName() != markerFileName) {
+            urls.append(QUrl::fromLocalFile(filePath));
+        }
+    }
+
+    std::ranges::sort(urls, [](const QUrl& a, const QUrl& b) {
+        return a.toLocalFile() < b.toLocalFile();
+    });
+
+    return urls;
+}
+
+bool writeTrack(const QString& filePath, const Template& source, const TagLib::PropertyMap& tags,
+                const QByteArray& cover) {
+    QFile target(filePath);
+    if (!target.open(QIODevice::WriteOnly) || target.write(source.data) != source.data.size()) {
+        qWarning() << "Could not create target file: " << filePath;
+        return false;
+    }
+    target.close();
+
+    TagLib::FileRef file(QFile::encodeName(filePath).constData(), false);
+    if (file.isNull()) {
+        qWarning() << "Failed to open file: " << filePath;
+        return false;
+    }
+
+    file.setProperties(tags);
+
+    if (!cover.isEmpty()) {
+        TagLib::VariantMap picture;
+        picture.insert("data", TagLib::ByteVector(cover.constData(), static_cast<unsigned int>(cover.size())));
+        picture.insert("mimeType", TagLib::String("image/jpeg"));
+        picture.insert("pictureType", TagLib::String("Front Cover"));
+        picture.insert("description", TagLib::String());
+        file.setComplexProperties("PICTURE", {picture});
+    }
+
+    if (!file.save()) {
+        qWarning() << "Failed to save metadata to file: " << filePath;
+        return false;
+    }
+
+    return true;
+}
+
+void generateAlbum(const QString& rootPath, const std::array<Template, templateExtensions.size()>& templates,
+                   const LibraryGenerator::Options& options, const qsizetype album, const qsizetype trackCount) {
+    const QDir root(rootPath);
+
+    // Seeded per album, so the library is the same whatever order the albums are written in
+    QRandomGenerator random(options.seed * 1'000'003U + static_cast<quint32>(album));
+
+    const qsizetype artist = album / albumsPerArtist;
+    const QString artistName = QStringLiteral("%1 %2").arg(phrase(random, 2)).arg(artist);
+    const QString albumName = QStringLiteral("%1 %2").arg(phrase(random, 3)).arg(album);
+    const QString genre = genres[random.bounded(static_cast<quint32>(genres.size()))];
+    const QString year = QString::number(1960 + random.bounded(64));
+
+    // Every album sticks to one format, as ripped or downloaded albums do
+    const Template& source = templates[static_cast<std::size_t>(album) % templates.size()];
+    const QByteArray cover = coverData(random, options.coverBytes);
+
+    const QString albumPath = QStringLiteral("%1/%2").arg(artistName, albumName);
+    if (!root.mkpath(albumPath)) {
+        qWarning() << "Could not create directory: " << root.filePath(albumPath);
+        return;
+    }
+
+    for (qsizetype track = 1; track <= trackCount; ++track) {
+        const QString title = phrase(random, 1 + static_cast<int>(random.bounded(4)));
+
+        TagLib::PropertyMap tags;
+        tags.replace("TITLE", TagLib::String(title.toStdString(), TagLib::String::UTF8));
+        tags.replace("ARTIST", TagLib::String(artistName.toStdString(), TagLib::String::UTF8));
+        tags.replace("ALBUMARTIST", TagLib::String(artistName.toStdString(), TagLib::String::UTF8));
+        tags.replace("ALBUM", TagLib::String(albumName.toStdString(), TagLib::String::UTF8));
+        tags.replace("GENRE", TagLib::String(genre.toStdString(), TagLib::String::UTF8));
+        tags.replace("DATE", TagLib::String(year.toStdString(), TagLib::String::UTF8));
+        tags.replace("TRACKNUMBER", TagLib::String::number(static_cast<int>(track)));
+        tags.replace("DISCNUMBER", TagLib::String("1"));
+
+        const QString fileName =
+            QStringLiteral("%1 - %2.%3").arg(track, 2, 10, QLatin1Char('0')).arg(title).arg(source.extension);
+
+        writeTrack(root.filePath(albumPath + QLatin1Char('/') + fileName), source, tags, cover);
+    }
+}
+
+qsizetype environmentValue(const char* name, const qsizetype defaultValue) {
+    bool ok = false;
+    const qsizetype value = qEnvironmentVariableIntValue(name, &ok);
+    return ok && value >= 0 ? value : defaultValue;
+}
+
+} // namespace
+
+LibraryGenerator::Options LibraryGenerator::optionsFromEnvironment() {
+    Options options;
+
+    options.fileCount = environmentValue("CORPLAYER_BENCH_FILES", options.fileCount);
+    options.coverBytes = environmentValue("CORPLAYER_BENCH_COVER_KB", options.coverBytes / 1024) * 1024;
+    options.seed = static_cast<quint32>(environmentValue("CORPLAYER_BENCH_SEED", options.seed));
+
+    return options;
+}
+
+QList<QUrl> LibraryGenerator::generate(const QString& rootPath, const Options& options) {
+    const QDir root(rootPath);
+
+    QFile marker(root.filePath(markerFileName));
+    if (marker.open(QIODevice::ReadOnly) && QString::fromUtf8(marker.readAll()) == markerText(options)) {
+        return collectFiles(rootPath);
+    }
+    marker.close();
+
+    // Anything left from other options or an interrupted run is thrown away
+    if (root.exists() && !QDir(rootPath).removeRecursively()) {
+        qWarning() << "Could not clear directory: " << rootPath;
+        return {};
+    }
+
+    if (!root.mkpath(QStringLiteral("."))) {
+        qWarning() << "Could not create directory: " << rootPath;
+        return {};
+    }
+
+    std::array<Template, templateExtensions.size()> templates;
+
+    for (std::size_t i = 0; i < templateExtensions.size(); ++i) {
+        QFile source(QStringLiteral(":/audio/audio.%1").arg(templateExtensions[i]));
+        if (!source.open(QIODevice::ReadOnly)) {
+            qWarning() << "Could not open source file: " << source.fileName();
+            return {};
+        }
+
+        templates[i] = {.extension = templateExtensions[i], .data = source.readAll()};
+    }
+
+    const qsizetype tracksPerAlbum = qMax<qsizetype>(1, options.tracksPerAlbum);
+    const qsizetype albumCount = (options.fileCount + tracksPerAlbum - 1) / tracksPerAlbum;
+
+    QThreadPool pool;
+    for (qsizetype album = 0; album < albumCount; ++album) {
+        const qsizetype trackCount = qMin(tracksPerAlbum, options.fileCount - album * tracksPerAlbum);
+        pool.start([&rootPath, &templates, &options, album, trackCount] {
+            generateAlbum(rootPath, templates, options, album, trackCount);
+        });
+    }
+    pool.waitForDone();
+
+    // Written last, so an interrupted run is never mistaken for a complete library
+    if (!marker.open(QIODevice::WriteOnly) || marker.write(markerText(options).toUtf8()) < 0) {
+        qWarning() << "Could not write marker file: " << marker.fileName();
+    }
+
+    return collectFiles(rootPath);
+}
@@ -0,0 +1,25 @@
+#ifndef LIBRARYGENERATOR_H
+#define LIBRARYGENERATOR_H
+
+#include <QList>
+#include <QString>
+#include <QUrl>
+
+// Builds a library of tagged audio files from the test templates, laid out as <artist>/<album>/<track>
+class LibraryGenerator {
+public:
+    struct Options {
+        qsizetype fileCount = 10'000;
+        qsizetype tracksPerAlbum = 12;
+        qsizetype coverBytes = 256 * 1024; // embedded in every track, 0 leaves the files without cover
+        quint32 seed = 1;
+    };
+
+    // Reads the settings from CORPLAYER_BENCH_FILES, CORPLAYER_BENCH_COVER_KB and CORPLAYER_BENCH_SEED
+    [[nodiscard]] static Options optionsFromEnvironment();
+
+    // A library generated earlier in the same directory with the same options is reused as it is
+    [[nodiscard]] static QList<QUrl> generate(const QString& rootPath, const Options& options);
+};
+
+#endif // LIBRARYGENERATOR_H
@@ -0,0 +1,106 @@
+#include "testutils.h"
+
+#include "metadata.hpp"
+#include "xxhash64.h"
+
+#include <gtest/gtest.h>
+
+TEST(TrackFieldsTest, TypedFields) {
+    Metadata::TrackFields track;
+    ASSERT_TRUE(track.isEmpty());
+    ASSERT_FALSE(track.contains(Metadata::Fields::Title));
+    ASSERT_FALSE(track.get(Metadata::Fields::Title).isValid());
+
+    track.insert(Metadata::Fields::Title, QStringLiteral("Title"));
+    track.insert(Metadata::Fields::TrackNumber, QStringLiteral("7"));
+    track.insert(Metadata::Fields::DatabaseId, 42);
+    track.insert(Metadata::Fields::Duration, QTime(0, 3, 15));
+
+    ASSERT_FALSE(track.isEmpty());
+    ASSERT_TRUE(track.isValid());
+    ASSERT_TRUE(track.contains(Metadata::Fields::Title));
+    ASSERT_EQ(track.title(), QStringLiteral("Title"));
+    ASSERT_EQ(track.get(Metadata::Fields::Title).toString(), QStringLiteral("Title"));
+    ASSERT_EQ(track.trackNumber(), 7);
+    ASSERT_EQ(track.get(Metadata::Fields::TrackNumber).toInt(), 7);
+    ASSERT_EQ(track.databaseId(), 42U);
+    ASSERT_EQ(track.duration(), QTime(0, 3, 15));
+
+    // Unset fields read as defaults but are not reported as present
+    ASSERT_FALSE(track.contains(Metadata::Fields::DiscNumber));
+    ASSERT_EQ(track.discNumber(), 0);
+
+    track.remove(Metadata::Fields::Title);
+    ASSERT_FALSE(track.contains(Metadata::Fields::Title));
+    ASSERT_FALSE(track.get(Metadata::Fields::Title).isValid());
+
+    // A NULL column leaves the field unset
+    track.insert(Metadata::Fields::Year, QVariant(QMetaType::fromType<int>()));
+    ASSERT_FALSE(track.contains(Metadata::Fields::Year));
+}
+
+TEST(TrackFieldsTest, ExtraFields) {
+    Metadata::TrackFields track;
+
+    track.insert(Metadata::Fields::Comment, QStringLiteral("Comment"));
+    track.insert(static_cast<Metadata::Fields>(Metadata::PlaylistFields::AlbumSection), QStringLiteral("Section"));
+
+    ASSERT_FALSE(track.isEmpty());
+    ASSERT_FALSE(track.isValid());
+    ASSERT_EQ(track.get(Metadata::Fields::Comment).toString(), QStringLiteral("Comment"));
+    ASSERT_EQ(track.get(static_cast<Metadata::Fields>(Metadata::PlaylistFields::AlbumSection)).toString(),
+              QStringLiteral("Section"));
+
+    track.remove(Metadata::Fields::Comment);
+    ASSERT_FALSE(track.contains(Metadata::Fields::Comment));
+}
+
+TEST(TrackFieldsTest, CoverImage) {
+    Metadata::TrackFields track;
+    track.insert(Metadata::Fields::ResourceUrl, QUrl::fromLocalFile(QStringLiteral("/music/track.flac")));
+
+    ASSERT_FALSE(track.contains(Metadata::Fields::CoverImage));
+
+    track.insert(Metadata::Fields::HasEmbeddedCover, false);
+    ASSERT_FALSE(track.contains(Metadata::Fields::CoverImage));
+
+    track.insert(Metadata::Fields::HasEmbeddedCover, true);
+    ASSERT_TRUE(track.contains(Metadata::Fields::CoverImage));
+    ASSERT_EQ(track.get(Metadata::Fields::CoverImage).toUrl(),
+              QUrl(QStringLiteral("image://cover//music/track.flac")));
+
+    // An explicit cover wins over the embedded one
+    const QUrl cover = QUrl::fromLocalFile(QStringLiteral("/music/cover.jpg"));
+    track.insert(Metadata::Fields::CoverImage, cover);
+    ASSERT_EQ(track.coverImage(), cover);
+}
+
+TEST(TrackFieldsTest, GenerateHash) {
+    Metadata::TrackFields track;
+    track.insert(Metadata::Fields::ResourceUrl, QUrl::fromLocalFile(QStringLiteral("/music/track.flac")));
+    track.insert(Metadata::Fields::Title, QStringLiteral("Title"));
+    track.insert(Metadata::Fields::Duration, QTime(0, 3, 15));
+
+    Metadata::TrackFields copy = track;
+    ASSERT_EQ(track.generateHash(), copy.generateHash());
+
+    // Column boundaries are part of the hash, moving text from one column to the next changes it
+    Metadata::TrackFields shifted;
+    shifted.insert(Metadata::Fields::Title, QStringLiteral("Ti"));
+    shifted.insert(Metadata::Fields::Artist, QStringLiteral("tle"));
+    Metadata::TrackFields joined;
+    joined.insert(Metadata::Fields::Title, QStringLiteral("Title"));
+    ASSERT_NE(shifted.generateHash(), joined.generateHash());
+
+    copy.insert(Metadata::Fields::Duration, QTime(0, 3, 16));
+    ASSERT_NE(track.generateHash(), copy.generateHash());
+
+    // An empty field hashes like an unset one
+    copy = track;
+    copy.insert(Metadata::Fields::Artist, QString{});
+    ASSERT_EQ(track.generateHash(), copy.generateHash());
+    // Text is hashed as UTF-16LE whatever the byte order of the machine, so stored hashes can be moved
+    XxHash64 text;
+    text.addData(QStringView{u"Title"});
+    ASSERT_EQ(text.result(), XxHash64::hash(QByteArrayView{"T\0i\0t\0l\0e\0", 10}));
+}
@@ -5,6 +5,7 @@
 #include "models/playlistproxymodel.hpp"
 
 #include <QSignalSpy>
+#include <QTest>
 
 class PlaylistProxyModelTest : public GlobalTest {
 protected:
@@ -250,3 +251,36 @@ TEST_F(PlaylistProxyModelTest, SkipPreviousWithPosition) {
     ASSERT_TRUE(m_proxyModel->currentTrack().isValid());
     ASSERT_EQ(m_proxyModel->currentTrack(), m_proxyModel->index(1, 0));
 }
+
+TEST_F(PlaylistProxyModelTest, RestoreEntries) {
+    const auto entries = createTestEntries(2);
+
+    const QUrl missingUrl = QUrl::fromLocalFile(QStringLiteral("/music/missing.mp3"));
+    QVariantList restored;
+    for (const auto& entry : entries) {
+        restored.append(QStringList{QString::number(entry.databaseId()), entry.resourceUrl().toString()});
+    }
+    restored.append(QStringList{QStringLiteral("9999"), missingUrl.toString()});
+
+    QSignalSpy addNewUrlSpy(m_playlistModel.get(), &PlaylistModel::addNewUrl);
+
+    // The rows are there at once, the library fills in their tracks afterwards
+    m_playlistModel->enqueueRestoredEntries(restored);
+    ASSERT_EQ(m_playlistModel->rowCount(), 3);
+
+    const auto isLoaded = [this](const int row) {
+        return m_playlistModel->data(m_playlistModel->index(row), PlaylistModel::IsValidRole).toBool();
+    };
+    ASSERT_TRUE(QTest::qWaitFor([&isLoaded] { return isLoaded(0) && isLoaded(1); }));
+
+    ASSERT_EQ(m_playlistModel->data(m_playlistModel->index(0), PlaylistModel::TitleRole).toString(),
+              QStringLiteral("Track 1"));
+    ASSERT_EQ(m_playlistModel->data(m_playlistModel->index(1), PlaylistModel::TitleRole).toString(),
+              QStringLiteral("Track 2"));
+
+    // A track the library no longer has is added again from its file
+    ASSERT_FALSE(isLoaded(2));
+    ASSERT_EQ(addNewUrlSpy.count(), 1);
+    ASSERT_EQ(addNewUrlSpy.first().first().toUrl(), missingUrl);
+    ASSERT_EQ(m_playlistModel->getEntriesForRestore().size(), 2);
+}
@@ -0,0 +1,269 @@
+#include "librarygenerator.h"
+
+#include "database/databasemanager.h"
+#include "library/filescanner.h"
+#include "library/library.hpp"
+#include "taglib/tagreader.h"
+#include "taglib/tracktags.h"
+
+#include <benchmark/benchmark.h>
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QThread>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Run with CORPLAYER_BENCH_FILES=200000 for a large library, the generated files are kept between runs.
+// Set CORPLAYER_BENCH_COLD=1 to evict the library from the page cache before every iteration.
+
+namespace {
+
+constexpr qsizetype workerChunk = 16;
+
+const QList<QUrl>& library() {
+    static const QList<QUrl> urls = [] {
+        const auto options = LibraryGenerator::optionsFromEnvironment();
+        const QString rootPath = QDir::tempPath() + QStringLiteral("/corplayer-bench-%1-%2")
+                                                        .arg(options.fileCount)
+                                                        .arg(options.seed);
+        return LibraryGenerator::generate(rootPath, options);
+    }();
+
+    return urls;
+}
+
+// Bytes this process read through read(2) and friends, including the ones served from the page cache
+qint64 bytesRead() {
+    QFile io(QStringLiteral("/proc/self/io"));
+    if (!io.open(QIODevice::ReadOnly | QIODevice::Text)) return 0;
+
+    while (!io.atEnd()) {
+        const QByteArray line = io.readLine();
+        if (line.startsWith("rchar:")) {
+            return line.mid(6).trimmed().toLongLong();
+        }
+    }
+
+    return 0;
+}
+
+void evictFromPageCache(const QList<QUrl>& urls) {
+    if (!qEnvironmentVariableIsSet("CORPLAYER_BENCH_COLD")) return;
+
+#ifdef Q_OS_LINUX
+    // Only drops clean pages, which is all the library has once it is generated
+    for (const QUrl& url : urls) {
+        const int fd = ::open(QFile::encodeName(url.toLocalFile()).constData(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            ::close(fd);
+        }
+    }
+#endif
+}
+
+// Files are handed out in small chunks, so a slow file does not leave the other threads idle at the end
+template <typename Setup, typename Function>
+void runParallel(const int threadCount, const QList<QUrl>& urls, Setup setup, Function function) {
+    std::atomic<qsizetype> next{0};
+    std::vector<std::thread> workers;
+    workers.reserve(static_cast<std::size_t>(threadCount));
+
+    for (int i = 0; i < threadCount; ++i) {
+        workers.emplace_back([&] {
+            auto state = setup();
+
+            for (qsizetype first = next.fetch_add(workerChunk); first < urls.size();
+                 first = next.fetch_add(workerChunk)) {
+                const qsizetype last = qMin(first + workerChunk, urls.size());
+
+                for (qsizetype j = first; j < last; ++j) {
+                    function(state, urls[j]);
+                }
+            }
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+class Throughput {
+public:
+    explicit Throughput(benchmark::State& state) : m_state(state) {}
+
+    void start(const QList<QUrl>& urls) {
+        m_state.PauseTiming();
+        evictFromPageCache(urls);
+        m_startBytes = bytesRead();
+        m_state.ResumeTiming();
+    }
+
+    void stop(const qsizetype files) {
+        m_state.PauseTiming();
+        m_bytes += bytesRead() - m_startBytes;
+        m_files += files;
+        m_state.ResumeTiming();
+    }
+
+    ~Throughput() {
+        m_state.SetItemsProcessed(m_files);
+        m_state.SetBytesProcessed(m_bytes);
+        m_state.counters["files/s"] =
+            benchmark::Counter(static_cast<double>(m_files), benchmark::Counter::kIsRate);
+        m_state.counters["bytes/file"] = benchmark::Counter(
+            m_files > 0 ? static_cast<double>(m_bytes) / static_cast<double>(m_files) : 0.0);
+    }
+
+    Throughput(const Throughput&) = delete;
+    Throughput& operator=(const Throughput&) = delete;
+
+private:
+    benchmark::State& m_state;
+    qint64 m_startBytes = 0;
+    qint64 m_bytes = 0;
+    qsizetype m_files = 0;
+};
+
+void BM_ScanFile(benchmark::State& state) {
+    const QList<QUrl>& urls = library();
+    const auto threadCount = static_cast<int>(state.range(0));
+
+    Throughput throughput(state);
+
+    for (auto _ : state) {
+        throughput.start(urls);
+
+        runParallel(
+            threadCount, urls, [] { return std::make_unique<FileScanner>(); },
+            [](const std::unique_ptr<FileScanner>& scanner, const QUrl& url) {
+                const auto track = scanner->scanFile(url);
+                benchmark::DoNotOptimize(track);
+            });
+
+        throughput.stop(urls.size());
+    }
+}
+
+void BM_ReadMetadata(benchmark::State& state) {
+    const QList<QUrl>& urls = library();
+    const auto threadCount = static_cast<int>(state.range(0));
+    const auto profile = state.range(1) != 0 ? TagReader::ReadProfile::Scan : TagReader::ReadProfile::Full;
+
+    Throughput throughput(state);
+
+    for (auto _ : state) {
+        throughput.start(urls);
+
+        runParallel(
+            threadCount, urls, [] { return std::make_unique<TagReader>(); },
+            [profile](const std::unique_ptr<TagReader>& reader, const QUrl& url) {
+                const QString filePath = url.toLocalFile();
+                TrackTags tags(filePath);
+                reader->readMetadata(filePath, tags, profile);
+                const auto fieldCount = tags.tags().size();
+                benchmark::DoNotOptimize(fieldCount);
+            });
+
+        throughput.stop(urls.size());
+    }
+}
+
+void BM_EnsureTracksInLibrary(benchmark::State& state) {
+    const QList<QUrl>& urls = library();
+
+    Throughput throughput(state);
+
+    for (auto _ : state) {
+        // Every iteration imports into an empty database
+        state.PauseTiming();
+        const QTemporaryDir databaseDir;
+        DatabaseManager::instance().initialize(databaseDir.filePath(QStringLiteral("bench.db")));
+
+        auto library = std::make_unique<Library>();
+        library->initialize(DatabaseManager::instance().dbConnectionPool());
+        library->setMaxScanThreads(static_cast<int>(state.range(0)));
+        state.ResumeTiming();
+
+        throughput.start(urls);
+        const QList<quint64> trackIds = library->addTracksFromUrls(urls);
+        throughput.stop(trackIds.size());
+
+        state.PauseTiming();
+        library.reset();
+        state.ResumeTiming();
+    }
+}
+
+// 1, 2, 4, ... up to every core
+void threadCounts(benchmark::internal::Benchmark* benchmark) {
+    const int maxThreads = qMax(1, QThread::idealThreadCount());
+
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        benchmark->Arg(threads);
+    }
+    benchmark->Arg(maxThreads);
+}
+
+void threadCountsAndProfiles(benchmark::internal::Benchmark* benchmark) {
+    const int maxThreads = qMax(1, QThread::idealThreadCount());
+
+    for (const int profile : {0, 1}) {
+        for (int threads = 1; threads < maxThreads; threads *= 2) {
+            benchmark->Args({threads, profile});
+        }
+        benchmark->Args({maxThreads, profile});
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_ScanFile)
+    ->Apply(threadCounts)
+    ->ArgName("threads")
+    ->Iterations(1)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReadMetadata)
+    ->Apply(threadCountsAndProfiles)
+    ->ArgNames({"threads", "scan"})
+    ->Iterations(1)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_EnsureTracksInLibrary)
+    ->Apply(threadCounts)
+    ->ArgName("threads")
+    ->Iterations(1)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+int main(int argc, char** argv) {
+    // Library and the database layer need an application instance
+    const QCoreApplication app(argc, argv);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+
+    // Generated up front, so the first benchmark does not pay for it
+    if (library().isEmpty()) {
+        qWarning() << "Failed to generate the benchmark library";
+        return 1;
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
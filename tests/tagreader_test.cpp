@@ -3,15 +3,21 @@
 #include "taglib/tagreader.h"
 #include "taglib/tracktags.h"
 
+#include <taglib/tstring.h>
+
+#include <QLocale>
+
 #include <gtest/gtest.h>
 
+#include <memory_resource>
+
 class TagReaderTest : public ::testing::Test {
 protected:
     TagReader m_tagReader;
 
     static void debugTags(const TrackTags& tags) {
-        for (auto it = tags.fieldMapping().begin(); it != tags.fieldMapping().end(); ++it) {
-            qDebug() << "Key: " << it.key() << ", Value: " << it.value().toString();
+        for (const auto& tag : tags.tags()) {
+            qDebug() << "Key: " << tag.field << ", Value: " << tag.value.toString();
         }
     }
 };
@@ -150,6 +156,66 @@ TEST_F(TagReaderTest, ReadMetadataOgg) {
     ASSERT_EQ(tags.value(Metadata::Fields::FileType).toString(), QStringLiteral("Vorbis"));
 }
 
+TEST_F(TagReaderTest, ReadMetadataScanProfile) {
+    for (const auto& fileName : {QStringLiteral(":/audio/audio.mp3"), QStringLiteral(":/audio/audio.flac"),
+                                 QStringLiteral(":/audio/audio.m4a")}) {
+        TemporaryFile tempFile(fileName);
+
+        ASSERT_FALSE(tempFile.fileName().isEmpty());
+
+        TrackTags fullTags(tempFile.fileName());
+        m_tagReader.readMetadata(tempFile.fileName(), fullTags);
+
+        TrackTags scanTags(tempFile.fileName());
+        m_tagReader.readMetadata(tempFile.fileName(), scanTags, TagReader::ReadProfile::Scan);
+
+        // Only the cover data itself is skipped
+        ASSERT_EQ(scanTags.value(Metadata::Fields::Title), fullTags.value(Metadata::Fields::Title));
+        ASSERT_EQ(scanTags.value(Metadata::Fields::Artist), fullTags.value(Metadata::Fields::Artist));
+        ASSERT_EQ(scanTags.value(Metadata::Fields::HasEmbeddedCover),
+                  fullTags.value(Metadata::Fields::HasEmbeddedCover));
+        ASSERT_EQ(scanTags.coverSize(), fullTags.coverSize());
+        ASSERT_TRUE(scanTags.coverImage().isEmpty());
+    }
+}
+
+TEST_F(TagReaderTest, ReadMetadataWithFormat) {
+    TemporaryFile tempFile(QStringLiteral(":/audio/audio.opus"));
+
+    ASSERT_FALSE(tempFile.fileName().isEmpty());
+
+    TrackTags tags(tempFile.fileName());
+    m_tagReader.readMetadata(tempFile.fileName(), AudioClassifier::Format::OggOpus, tags);
+
+    ASSERT_EQ(tags.value(Metadata::Fields::FileType).toString(), QStringLiteral("Opus"));
+    ASSERT_EQ(tags.value(Metadata::Fields::Title).toString(), QStringLiteral("Test Title"));
+
+    // A wrong format falls back to TagLib's own detection for the generic tags
+    TrackTags fallbackTags(tempFile.fileName());
+    m_tagReader.readMetadata(tempFile.fileName(), AudioClassifier::Format::Mp4, fallbackTags);
+
+    ASSERT_EQ(fallbackTags.value(Metadata::Fields::Title).toString(), QStringLiteral("Test Title"));
+}
+
+TEST_F(TagReaderTest, ExtractCoverArtWithFormat) {
+    TemporaryFile tempFile(QStringLiteral(":/audio/audio.mp3"));
+
+    ASSERT_FALSE(tempFile.fileName().isEmpty());
+
+    TrackTags tags(tempFile.fileName());
+    m_tagReader.extractCoverArt(tempFile.fileName(), AudioClassifier::Format::Mpeg, tags);
+
+    ASSERT_FALSE(tags.coverImage().isEmpty());
+
+    // Without a format or with a wrong one, the picture comes from TagLib's own detection
+    for (const auto format : {AudioClassifier::Format::Unknown, AudioClassifier::Format::Flac}) {
+        TrackTags fallbackTags(tempFile.fileName());
+        m_tagReader.extractCoverArt(tempFile.fileName(), format, fallbackTags);
+
+        ASSERT_EQ(fallbackTags.coverImage(), tags.coverImage());
+    }
+}
+
 TEST_F(TagReaderTest, ReadMetadataBenchmark) {
     const QString fileName = QStringLiteral(":/audio/audio.opus");
 
@@ -164,3 +230,49 @@ TEST_F(TagReaderTest, ReadMetadataBenchmark) {
         m_tagReader.readMetadata(tempFile.fileName(), tags);
     }
 }
+
+TEST_F(TagReaderTest, RepeatedValues) {
+    TrackTags tags(QStringLiteral("track.flac"));
+
+    tags.add(Metadata::Fields::Title, QStringLiteral("Title"));
+    tags.add(Metadata::Fields::Title, QStringLiteral("Title"));
+    tags.add(Metadata::Fields::Artist, QStringLiteral("First"));
+    tags.add(Metadata::Fields::Artist, QStringLiteral("Second"));
+    tags.add(Metadata::Fields::Duration, 30);
+
+    // Values a field already has are dropped as they are added
+    ASSERT_EQ(tags.tags().size(), 4);
+    ASSERT_EQ(tags.value(Metadata::Fields::Artist).toString(), QStringLiteral("First"));
+    ASSERT_FALSE(tags.contains(Metadata::Fields::Album));
+
+    Metadata::TrackFields track;
+    tags.copyTo(track);
+
+    ASSERT_EQ(track.title(), QStringLiteral("Title"));
+    ASSERT_EQ(track.artist(), QLocale().createSeparatedList({QStringLiteral("First"), QStringLiteral("Second")}));
+    ASSERT_EQ(track.duration(), QTime(0, 0, 30));
+}
+
+TEST_F(TagReaderTest, TextArena) {
+    // Everything a normal file carries fits the inline buffer, the upstream is never asked for memory
+    TrackTags tags(QStringLiteral("track.flac"), std::pmr::null_memory_resource());
+
+    tags.addText(Metadata::Fields::Title, TagLib::String("  Title  "));
+    tags.addText(Metadata::Fields::Artist, TagLib::String(L"Art\U0001F3B5st"));
+    tags.addText(Metadata::Fields::Title, QStringLiteral("Title"));
+
+    ASSERT_EQ(tags.tags().size(), 2);
+    ASSERT_EQ(tags.value(Metadata::Fields::Title).toString(), QStringLiteral("Title"));
+    ASSERT_EQ(tags.value(Metadata::Fields::Artist).toString(), QString::fromUtf8("Art\xF0\x9F\x8E\xB5st"));
+
+    // Long text spills into the upstream resource
+    std::pmr::monotonic_buffer_resource upstream;
+    TrackTags longTags(QStringLiteral("track.flac"), &upstream);
+
+    const QString lyrics(static_cast<qsizetype>(TrackTags::InlineTextBytes), QLatin1Char('x'));
+    longTags.addText(Metadata::Fields::Lyrics, lyrics);
+
+    Metadata::TrackFields track;
+    longTags.copyTo(track);
+    ASSERT_EQ(track.get(Metadata::Fields::Lyrics).toString(), lyrics);
+}